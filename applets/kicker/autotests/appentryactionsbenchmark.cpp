@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "appentry.h"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <Plasma/Plasma>
+
+// Just enough of a model to own entries: AppEntry asks its root model for
+// the applet interface.
+class FakeModel : public AbstractModel
+{
+    Q_OBJECT
+
+    public:
+        explicit FakeModel(QObject *parent) : AbstractModel(parent) {}
+
+        QString description() const Q_DECL_OVERRIDE { return QString(); }
+        int rowCount(const QModelIndex &) const Q_DECL_OVERRIDE { return 0; }
+        QVariant data(const QModelIndex &, int) const Q_DECL_OVERRIDE { return QVariant(); }
+        bool trigger(int, const QString &, const QVariant &) Q_DECL_OVERRIDE { return false; }
+};
+
+class AppEntryActionsBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void cleanupTestCase();
+        void testJumpListActions();
+        void testRepeatedActions();
+        void benchmarkActions();
+
+    private:
+        QTemporaryDir m_dir;
+        QObject m_appletInterface;
+        QObject m_root;
+        FakeModel *m_model = nullptr;
+        QVector<AppEntry *> m_entries;
+};
+
+// A made up menu of applications with a few jump list actions each, written
+// to disk so the services are loaded the way real ones are.
+static KService::Ptr syntheticService(const QString &dir, int i)
+{
+    const QString path = dir + QStringLiteral("/org.example.app%1.desktop").arg(i);
+
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(QStringLiteral("[Desktop Entry]\n"
+        "Type=Application\n"
+        "Name=App %1\n"
+        "GenericName=Example Application\n"
+        "Exec=app%1 %U\n"
+        "Icon=app%1\n"
+        "Actions=New;Open;Quit;\n"
+        "\n"
+        "[Desktop Action New]\n"
+        "Name=New Window\n"
+        "Exec=app%1 --new\n"
+        "\n"
+        "[Desktop Action Open]\n"
+        "Name=Open Recent\n"
+        "Exec=app%1 --recent\n"
+        "\n"
+        "[Desktop Action Quit]\n"
+        "Name=Quit\n"
+        "Exec=app%1 --quit\n").arg(i).toUtf8());
+    file.close();
+
+    return KService::Ptr(new KService(path));
+}
+
+void AppEntryActionsBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(m_dir.isValid());
+
+    m_appletInterface.setProperty("immutability", int(Plasma::Types::Mutable));
+
+    m_model = new FakeModel(&m_root);
+    m_model->setProperty("appletInterface", QVariant::fromValue<QObject *>(&m_appletInterface));
+
+    for (int i = 0; i < 200; ++i) {
+        const KService::Ptr service = syntheticService(m_dir.path(), i);
+        QVERIFY(service->isValid());
+
+        m_entries << new AppEntry(m_model, service, AppEntry::NameOnly);
+    }
+}
+
+void AppEntryActionsBenchmark::cleanupTestCase()
+{
+    qDeleteAll(m_entries);
+    m_entries.clear();
+}
+
+void AppEntryActionsBenchmark::testJumpListActions()
+{
+    const QVariantList &actions = m_entries.first()->actions();
+
+    QVERIFY(actions.count() >= 4);
+
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(actions.at(i).toMap().value(QStringLiteral("actionId")).toString(),
+            QStringLiteral("_kicker_jumpListAction"));
+    }
+
+    QCOMPARE(actions.at(0).toMap().value(QStringLiteral("actionArgument")).toString(), QStringLiteral("app0 --new"));
+    QCOMPARE(actions.at(3).toMap().value(QStringLiteral("type")).toString(), QStringLiteral("separator"));
+}
+
+void AppEntryActionsBenchmark::testRepeatedActions()
+{
+    foreach (const AppEntry *entry, m_entries) {
+        QCOMPARE(entry->actions(), entry->actions());
+    }
+
+    // Immutability is not part of what's cached.
+    m_appletInterface.setProperty("immutability", int(Plasma::Types::SystemImmutable));
+
+    foreach (const QVariant &action, m_entries.first()->actions()) {
+        QVERIFY(action.toMap().value(QStringLiteral("actionId")).toString() != QLatin1String("editApplication"));
+    }
+
+    m_appletInterface.setProperty("immutability", int(Plasma::Types::Mutable));
+}
+
+void AppEntryActionsBenchmark::benchmarkActions()
+{
+    QBENCHMARK {
+        foreach (const AppEntry *entry, m_entries) {
+            entry->actions();
+        }
+    }
+}
+
+QTEST_MAIN(AppEntryActionsBenchmark)
+
+#include "appentryactionsbenchmark.moc"
@@ -0,0 +1,158 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "appsearchindex.h"
+
+#include <QtTest>
+
+class AppSearchIndexBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void testRanking();
+        void testShortQuery();
+        void testNoMatch();
+        void benchmarkBuild();
+        void benchmarkQuery_data();
+        void benchmarkQuery();
+
+    private:
+        QVector<AppSearchIndex::Entry> m_catalog;
+        AppSearchIndex m_index;
+};
+
+// A made up catalog of several thousand applications with names built from
+// a handful of syllables, so trigrams are shared between many entries like
+// they are in a real menu.
+static QVector<AppSearchIndex::Entry> syntheticCatalog(int size)
+{
+    static const QStringList syllables = {
+        QStringLiteral("ka"), QStringLiteral("te"), QStringLiteral("fox"), QStringLiteral("lib"),
+        QStringLiteral("re"), QStringLiteral("of"), QStringLiteral("fi"), QStringLiteral("ce"),
+        QStringLiteral("dol"), QStringLiteral("phin"), QStringLiteral("kon"), QStringLiteral("so"),
+        QStringLiteral("le"), QStringLiteral("gim"), QStringLiteral("ink"), QStringLiteral("scape")
+    };
+
+    static const QStringList genericNames = {
+        QStringLiteral("Text Editor"), QStringLiteral("Web Browser"), QStringLiteral("File Manager"),
+        QStringLiteral("Terminal"), QStringLiteral("Image Editor"), QStringLiteral("Office Suite"),
+        QStringLiteral("Media Player"), QStringLiteral("Email Client")
+    };
+
+    QVector<AppSearchIndex::Entry> catalog;
+    catalog.reserve(size);
+
+    for (int i = 0; i < size; ++i) {
+        const QString name = syllables.at(i % syllables.count())
+            + syllables.at((i / syllables.count()) % syllables.count())
+            + syllables.at((i / (syllables.count() * syllables.count())) % syllables.count())
+            + QString::number(i);
+
+        AppSearchIndex::Entry entry;
+        entry.storageId = QStringLiteral("org.example.") + name + QStringLiteral(".desktop");
+        entry.name = name.at(0).toUpper() + name.mid(1);
+        entry.genericName = genericNames.at(i % genericNames.count());
+        entry.icon = name;
+        entry.keywords = QStringList{ syllables.at((i * 7) % syllables.count()) + QStringLiteral("keyword") };
+
+        catalog.append(entry);
+    }
+
+    AppSearchIndex::Entry kate;
+    kate.storageId = QStringLiteral("org.kde.kate.desktop");
+    kate.name = QStringLiteral("Kate");
+    kate.genericName = QStringLiteral("Advanced Text Editor");
+    catalog.append(kate);
+
+    return catalog;
+}
+
+void AppSearchIndexBenchmark::initTestCase()
+{
+    m_catalog = syntheticCatalog(5000);
+    m_index.setEntries(m_catalog);
+
+    QCOMPARE(m_index.count(), m_catalog.count());
+}
+
+void AppSearchIndexBenchmark::testRanking()
+{
+    const QVector<AppSearchIndex::Result> results = m_index.query(QStringLiteral("kate"));
+
+    QVERIFY(!results.isEmpty());
+    QCOMPARE(m_index.entry(results.first().entry).name, QStringLiteral("Kate"));
+    QCOMPARE(results.first().relevance, 1.0);
+
+    for (int i = 1; i < results.count(); ++i) {
+        QVERIFY(results.at(i - 1).relevance >= results.at(i).relevance);
+    }
+}
+
+void AppSearchIndexBenchmark::testShortQuery()
+{
+    const QVector<AppSearchIndex::Result> results = m_index.query(QStringLiteral("Ed"), 0);
+
+    QVERIFY(!results.isEmpty());
+
+    foreach (const AppSearchIndex::Result &result, results) {
+        const AppSearchIndex::Entry &entry = m_index.entry(result.entry);
+        QVERIFY(entry.genericName.contains(QLatin1String("Editor")));
+    }
+}
+
+void AppSearchIndexBenchmark::testNoMatch()
+{
+    QVERIFY(m_index.query(QStringLiteral("zzzz")).isEmpty());
+    QVERIFY(m_index.query(QString()).isEmpty());
+}
+
+void AppSearchIndexBenchmark::benchmarkBuild()
+{
+    QBENCHMARK {
+        AppSearchIndex index;
+        index.setEntries(m_catalog);
+    }
+}
+
+void AppSearchIndexBenchmark::benchmarkQuery_data()
+{
+    QTest::addColumn<QString>("query");
+
+    QTest::newRow("one character") << QStringLiteral("k");
+    QTest::newRow("two characters") << QStringLiteral("ka");
+    QTest::newRow("prefix") << QStringLiteral("kat");
+    QTest::newRow("full name") << QStringLiteral("kate");
+    QTest::newRow("generic name") << QStringLiteral("text editor");
+    QTest::newRow("no match") << QStringLiteral("qqq");
+}
+
+void AppSearchIndexBenchmark::benchmarkQuery()
+{
+    QFETCH(QString, query);
+
+    QBENCHMARK {
+        m_index.query(query);
+    }
+}
+
+QTEST_GUILESS_MAIN(AppSearchIndexBenchmark)
+
+#include "appsearchindexbenchmark.moc"
@@ -0,0 +1,225 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "favoritesmodel.h"
+#include "recentusagemodel.h"
+
+#include <QStandardItemModel>
+#include <QStandardPaths>
+#include <QtTest>
+
+#include <KSycoca>
+
+#include <KActivities/Stats/ResultModel>
+
+// Counts how often rows are run through the filter.
+class CountingFilterProxy : public InvalidAppsFilterProxy
+{
+    public:
+        CountingFilterProxy(AbstractModel *parentModel, QAbstractItemModel *sourceModel)
+        : InvalidAppsFilterProxy(parentModel, sourceModel)
+        {
+        }
+
+        mutable int filtered = 0;
+
+    protected:
+        bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const Q_DECL_OVERRIDE
+        {
+            ++filtered;
+            return InvalidAppsFilterProxy::filterAcceptsRow(source_row, source_parent);
+        }
+};
+
+class FavoritesFilterTest : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void init();
+        void cleanup();
+        void testIsFavorite();
+        void testDelta();
+        void testAddRemoveFiltersAffectedRow();
+        void testSetFavoritesFiltersAffectedRows();
+        void testUnlistedFavoriteIsNotFiltered();
+        void testNonCanonicalResource();
+
+    private:
+        QObject m_root;
+        FavoritesModel *m_favorites = nullptr;
+        CountingFilterProxy *m_proxy = nullptr;
+        static const int s_recentCount = 1000;
+};
+
+static QString appId(int i)
+{
+    return QStringLiteral("org.example.app%1.desktop").arg(i);
+}
+
+void FavoritesFilterTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    const QString appsDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+        + QStringLiteral("/applications");
+    QVERIFY(QDir().mkpath(appsDir));
+
+    // One more than there are recent ones.
+    for (int i = 0; i <= s_recentCount; ++i) {
+        QFile file(appsDir + QLatin1Char('/') + appId(i));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QStringLiteral("[Desktop Entry]\nType=Application\nName=App %1\nExec=app%1\n").arg(i).toUtf8());
+    }
+
+    KSycoca::self()->ensureCacheValid();
+    QVERIFY(KService::serviceByStorageId(appId(0)));
+}
+
+void FavoritesFilterTest::init()
+{
+    // AppEntry asks the root model of its owner for its settings.
+    m_favorites = new FavoritesModel(&m_root);
+
+    QStandardItemModel *recent = new QStandardItemModel();
+
+    for (int i = 0; i < s_recentCount; ++i) {
+        QStandardItem *item = new QStandardItem();
+        item->setData(QStringLiteral("applications:") + appId(i), KActivities::Stats::ResultModel::ResourceRole);
+        recent->appendRow(item);
+    }
+
+    m_proxy = new CountingFilterProxy(m_favorites, recent);
+    // It is created as a child of the source model it then adopts.
+    m_proxy->setParent(nullptr);
+    QCOMPARE(m_proxy->rowCount(), s_recentCount);
+}
+
+void FavoritesFilterTest::cleanup()
+{
+    delete m_proxy;
+    delete m_favorites;
+}
+
+void FavoritesFilterTest::testIsFavorite()
+{
+    m_favorites->setFavorites(QStringList() << appId(1) << appId(2) << appId(3));
+
+    QVERIFY(m_favorites->isFavorite(appId(2)));
+    QVERIFY(!m_favorites->isFavorite(appId(4)));
+
+    m_favorites->moveRow(0, 2);
+    QCOMPARE(m_favorites->favorites(), QStringList() << appId(2) << appId(3) << appId(1));
+    QVERIFY(m_favorites->isFavorite(appId(1)));
+
+    m_favorites->removeFavorite(appId(3));
+    QVERIFY(!m_favorites->isFavorite(appId(3)));
+    QVERIFY(m_favorites->isFavorite(appId(1)));
+
+    // Removing by id still finds the right row after the move.
+    m_favorites->removeFavorite(appId(1));
+    QCOMPARE(m_favorites->favorites(), QStringList() << appId(2));
+}
+
+void FavoritesFilterTest::testDelta()
+{
+    QSignalSpy delta(m_favorites, SIGNAL(favoriteIdsChanged(QStringList,QStringList)));
+
+    m_favorites->setFavorites(QStringList() << appId(1) << appId(2));
+    QCOMPARE(delta.count(), 1);
+    QCOMPARE(delta.at(0).at(0).toStringList(), QStringList() << appId(1) << appId(2));
+    QCOMPARE(delta.at(0).at(1).toStringList(), QStringList());
+
+    m_favorites->setFavorites(QStringList() << appId(2) << appId(3));
+    QCOMPARE(delta.count(), 2);
+    QCOMPARE(delta.at(1).at(0).toStringList(), QStringList() << appId(3));
+    QCOMPARE(delta.at(1).at(1).toStringList(), QStringList() << appId(1));
+
+    // Moving doesn't change what's a favorite.
+    m_favorites->moveRow(0, 1);
+    QCOMPARE(delta.count(), 2);
+}
+
+void FavoritesFilterTest::testAddRemoveFiltersAffectedRow()
+{
+    m_proxy->filtered = 0;
+
+    m_favorites->addFavorite(appId(500));
+
+    QCOMPARE(m_proxy->rowCount(), s_recentCount - 1);
+    QCOMPARE(m_proxy->filtered, 1);
+
+    m_proxy->filtered = 0;
+
+    m_favorites->removeFavorite(appId(500));
+
+    QCOMPARE(m_proxy->rowCount(), s_recentCount);
+    QCOMPARE(m_proxy->filtered, 1);
+}
+
+void FavoritesFilterTest::testSetFavoritesFiltersAffectedRows()
+{
+    m_favorites->setFavorites(QStringList() << appId(10) << appId(20));
+    QCOMPARE(m_proxy->rowCount(), s_recentCount - 2);
+
+    m_proxy->filtered = 0;
+
+    m_favorites->setFavorites(QStringList() << appId(20) << appId(30) << appId(40));
+
+    // appId(10) came back, appId(30) and appId(40) went away; appId(20)
+    // stayed a favorite and is left alone.
+    QCOMPARE(m_proxy->rowCount(), s_recentCount - 3);
+    QCOMPARE(m_proxy->filtered, 3);
+}
+
+void FavoritesFilterTest::testUnlistedFavoriteIsNotFiltered()
+{
+    m_proxy->filtered = 0;
+
+    m_favorites->addFavorite(appId(s_recentCount));
+
+    QVERIFY(m_favorites->isFavorite(appId(s_recentCount)));
+    QCOMPARE(m_proxy->rowCount(), s_recentCount);
+    QCOMPARE(m_proxy->filtered, 0);
+}
+
+void FavoritesFilterTest::testNonCanonicalResource()
+{
+    // Recent resources may name an application by its desktop file name
+    // only, favorites use the storage id.
+    QStandardItemModel *recent = new QStandardItemModel();
+    QStandardItem *item = new QStandardItem();
+    item->setData(QStringLiteral("applications:org.example.app500"), KActivities::Stats::ResultModel::ResourceRole);
+    recent->appendRow(item);
+
+    QScopedPointer<InvalidAppsFilterProxy> proxy(new InvalidAppsFilterProxy(m_favorites, recent));
+    proxy->setParent(nullptr);
+    QCOMPARE(proxy->rowCount(), 1);
+
+    m_favorites->addFavorite(appId(500));
+    QCOMPARE(proxy->rowCount(), 0);
+
+    m_favorites->removeFavorite(appId(500));
+    QCOMPARE(proxy->rowCount(), 1);
+}
+
+QTEST_MAIN(FavoritesFilterTest)
+
+#include "favoritesfiltertest.moc"
@@ -27,15 +27,22 @@
 #include <config-X11.h>
 #include <config-appstream.h>
 
+#include <QCoreApplication>
+#include <QFutureWatcher>
 #include <QProcess>
 #include <QQmlPropertyMap>
 #include <QStandardPaths>
 #include <QDesktopServices>
+#include <QtConcurrentRun>
 #if HAVE_X11
 #include <QX11Info>
 #endif
 
+#include <KActivities/Consumer>
 #include <KActivities/ResourceInstance>
+#include <KActivities/Stats/Query>
+#include <KActivities/Stats/ResultWatcher>
+#include <KActivities/Stats/Terms>
 #include <KConfigGroup>
 #include <KJob>
 #include <KLocalizedString>
@@ -91,6 +98,9 @@ void AppEntry::init(NameFormat nameFormat)
 
     if (!m_menuEntryEditor) {
         m_menuEntryEditor = new MenuEntryEditor();
+
+        // Gets the AppStream index loading well before the first context menu.
+        actionCache();
     }
 }
 
@@ -141,33 +151,199 @@ bool AppEntry::hasActions() const
     return true;
 }
 
+namespace {
+
+// The parts of an application's actions that only depend on the service.
+struct ServiceActions {
+    QVariantList jumpList;
+    bool canEdit = false;
+    QVariantList appstream;
+};
+
+#ifdef HAVE_APPSTREAMQT
+struct AppStreamComponent {
+    QString id;
+    QString name;
+};
+
+typedef QHash<QString, QVector<AppStreamComponent> > AppStreamIndex;
+
+// Runs on a worker thread: loading the pool parses all of the AppStream
+// metadata on the system, but all we need to keep is the components by
+// id. Desktop application ids are their desktop file names, which is what
+// they are looked up by, the same as Pool::componentsById() would.
+AppStreamIndex loadAppStreamIndex()
+{
+    AppStreamIndex index;
+
+    AppStream::Pool pool;
+
+    if (!pool.load()) {
+        return index;
+    }
+
+    foreach (const AppStream::Component &component, pool.components()) {
+        index[component.id()].append(AppStreamComponent{component.id(), component.name()});
+    }
+
+    index.squeeze();
+
+    return index;
+}
+#endif
+
+// Action lists are asked for every time a context menu opens, and the same
+// application usually shows up in several models at once, so the expensive
+// parts are kept here by storage id until whatever they were built from
+// changes. It holds QObjects of its own, so it belongs to the application
+// and goes away with it.
+class ActionCache : public QObject
+{
+    public:
+        explicit ActionCache(QObject *parent);
+
+        ServiceActions serviceActions(const KService::Ptr &service, const MenuEntryEditor *editor);
+        QVariantList recentDocuments(const KService::Ptr &service);
+
+    private:
+#ifdef HAVE_APPSTREAMQT
+        QVariantList appstreamActions(const KService::Ptr &service) const;
+
+        QFutureWatcher<AppStreamIndex> m_appstreamWatcher;
+        AppStreamIndex m_appstream;
+#endif
+
+        KActivities::Consumer m_activities;
+        KActivities::Stats::ResultWatcher m_recentWatcher;
+
+        QHash<QString, ServiceActions> m_serviceActions;
+        QHash<QString, QVariantList> m_recentDocuments;
+};
+
+ActionCache::ActionCache(QObject *parent)
+: QObject(parent)
+, m_recentWatcher(KActivities::Stats::Terms::UsedResources
+    | KActivities::Stats::Terms::Agent::any()
+    | KActivities::Stats::Terms::Type::any()
+    | KActivities::Stats::Terms::Activity::current()
+    | KActivities::Stats::Terms::Url::file())
+{
+    QObject::connect(KSycoca::self(),
+        static_cast<void (KSycoca::*)(const QStringList &)>(&KSycoca::databaseChanged),
+        this, [this]() {
+            m_serviceActions.clear();
+            m_recentDocuments.clear();
+        });
+
+    auto invalidateRecentDocuments = [this]() {
+        m_recentDocuments.clear();
+    };
+
+    QObject::connect(&m_activities, &KActivities::Consumer::currentActivityChanged,
+        this, invalidateRecentDocuments);
+    QObject::connect(&m_recentWatcher, &KActivities::Stats::ResultWatcher::resultScoreUpdated,
+        this, invalidateRecentDocuments);
+    QObject::connect(&m_recentWatcher, &KActivities::Stats::ResultWatcher::resultRemoved,
+        this, invalidateRecentDocuments);
+    QObject::connect(&m_recentWatcher, &KActivities::Stats::ResultWatcher::resultLinked,
+        this, invalidateRecentDocuments);
+    QObject::connect(&m_recentWatcher, &KActivities::Stats::ResultWatcher::resultUnlinked,
+        this, invalidateRecentDocuments);
+    QObject::connect(&m_recentWatcher, &KActivities::Stats::ResultWatcher::resultsInvalidated,
+        this, invalidateRecentDocuments);
+
+#ifdef HAVE_APPSTREAMQT
+    QObject::connect(&m_appstreamWatcher, &QFutureWatcher<AppStreamIndex>::finished, this,
+        [this]() {
+            m_appstream = m_appstreamWatcher.result();
+            m_serviceActions.clear();
+        });
+
+    m_appstreamWatcher.setFuture(QtConcurrent::run(loadAppStreamIndex));
+#endif
+}
+
+ServiceActions ActionCache::serviceActions(const KService::Ptr &service, const MenuEntryEditor *editor)
+{
+    const QString &storageId = service->storageId();
+
+    auto it = m_serviceActions.constFind(storageId);
+
+    if (it != m_serviceActions.constEnd()) {
+        return *it;
+    }
+
+    ServiceActions actions;
+    actions.jumpList = Kicker::jumpListActions(service);
+    actions.canEdit = editor->canEdit(service->entryPath());
+
 #ifdef HAVE_APPSTREAMQT
-Q_GLOBAL_STATIC(AppStream::Pool, appstreamPool)
+    if (service->isApplication()) {
+        actions.appstream = appstreamActions(service);
+    }
+#endif
+
+    m_serviceActions.insert(storageId, actions);
 
-QVariantList appstreamActions(const KService::Ptr &service)
+    return actions;
+}
+
+QVariantList ActionCache::recentDocuments(const KService::Ptr &service)
 {
-    if (!appstreamPool.exists()) {
-        appstreamPool->load();
+    const QString &storageId = service->storageId();
+
+    auto it = m_recentDocuments.constFind(storageId);
+
+    if (it != m_recentDocuments.constEnd()) {
+        return *it;
     }
 
+    const QVariantList &recentDocuments = Kicker::recentDocumentActions(service);
+    m_recentDocuments.insert(storageId, recentDocuments);
+
+    return recentDocuments;
+}
+
+#ifdef HAVE_APPSTREAMQT
+QVariantList ActionCache::appstreamActions(const KService::Ptr &service) const
+{
     QVariantList ret;
-    const auto components = appstreamPool->componentsById(service->desktopEntryName()+QLatin1String(".desktop"));
-    for(const auto &component: components) {
-        const QString componentId = component.id();
 
-        QVariantMap appstreamAction = Kicker::createActionItem(i18nc("@action opens a software center with the application", "Manage '%1'...", component.name()), "manageApplication", QVariant(QStringLiteral("appstream://") + componentId));
+    // Until the index is loaded this finds nothing; the cache is dropped
+    // once it is, so the actions show up from the next menu on.
+    const auto &components = m_appstream.value(service->desktopEntryName() + QLatin1String(".desktop"));
+
+    for (const AppStreamComponent &component : components) {
+        QVariantMap appstreamAction = Kicker::createActionItem(i18nc("@action opens a software center with the application", "Manage '%1'...", component.name), "manageApplication", QVariant(QStringLiteral("appstream://") + component.id));
         appstreamAction[QStringLiteral("icon")] = QStringLiteral("applications-other");
         ret << appstreamAction;
     }
+
     return ret;
 }
 #endif
 
+}
+
+static ActionCache *actionCache()
+{
+    static ActionCache *cache = nullptr;
+
+    if (!cache) {
+        cache = new ActionCache(QCoreApplication::instance());
+        QObject::connect(cache, &QObject::destroyed, []() { cache = nullptr; });
+    }
+
+    return cache;
+}
+
 QVariantList AppEntry::actions() const
 {
+    const ServiceActions &serviceActions = actionCache()->serviceActions(m_service, m_menuEntryEditor);
+
     QVariantList actionList;
 
-    actionList << Kicker::jumpListActions(m_service);
+    actionList << serviceActions.jumpList;
     if (!actionList.isEmpty()) {
         actionList << Kicker::createSeparatorActionItem();
     }
@@ -176,13 +352,15 @@ QVariantList AppEntry::actions() const
 
     const bool systemImmutable = appletInterface->property("immutability").toInt() == Plasma::Types::SystemImmutable;
 
-    const QVariantList &addLauncherActions = Kicker::createAddLauncherActionList(appletInterface, m_service);
-    if (!systemImmutable && !addLauncherActions.isEmpty()) {
-        actionList << addLauncherActions
-                   << Kicker::createSeparatorActionItem();
+    if (!systemImmutable) {
+        const QVariantList &addLauncherActions = Kicker::createAddLauncherActionList(appletInterface, m_service);
+        if (!addLauncherActions.isEmpty()) {
+            actionList << addLauncherActions
+                       << Kicker::createSeparatorActionItem();
+        }
     }
 
-    const QVariantList &recentDocuments = Kicker::recentDocumentActions(m_service);
+    const QVariantList &recentDocuments = actionCache()->recentDocuments(m_service);
     if (!recentDocuments.isEmpty()) {
         actionList << recentDocuments << Kicker::createSeparatorActionItem();
     }
@@ -193,7 +371,7 @@ QVariantList AppEntry::actions() const
         return actionList;
     }
 
-    if (m_menuEntryEditor->canEdit(m_service->entryPath())) {
+    if (serviceActions.canEdit) {
         actionList << Kicker::createSeparatorActionItem();
 
         QVariantMap editAction = Kicker::createActionItem(i18n("Edit Application..."), "editApplication");
@@ -201,11 +379,7 @@ QVariantList AppEntry::actions() const
         actionList << editAction;
     }
 
-#ifdef HAVE_APPSTREAMQT
-    if (m_service->isApplication()) {
-        actionList << appstreamActions(m_service);
-    }
-#endif
+    actionList << serviceActions.appstream;
 
     QQmlPropertyMap *appletConfig = qobject_cast<QQmlPropertyMap *>(appletInterface->property("configuration").value<QObject *>());
 
@@ -0,0 +1,295 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "appsearchindex.h"
+
+#include <QSet>
+
+#include <KService>
+#include <KServiceGroup>
+#include <KSycoca>
+
+#include <algorithm>
+
+static QString normalized(const QString &text)
+{
+    return text.simplified().toLower();
+}
+
+static void addPosting(QHash<QString, QVector<int> > &index, const QString &key, int entry)
+{
+    QVector<int> &list = index[key];
+
+    // Entries are added in ascending order, so checking the tail is enough.
+    if (list.isEmpty() || list.last() != entry) {
+        list.append(entry);
+    }
+}
+
+static void addTerm(QHash<QString, QVector<int> > &trigrams, QHash<QString, QVector<int> > &wordPrefixes,
+    const QString &term, int entry)
+{
+    for (int i = 0; i + 3 <= term.length(); ++i) {
+        addPosting(trigrams, term.mid(i, 3), entry);
+    }
+
+    for (int i = 0; i < term.length(); ++i) {
+        if (!term.at(i).isLetterOrNumber() || (i > 0 && term.at(i - 1).isLetterOrNumber())) {
+            continue;
+        }
+
+        addPosting(wordPrefixes, term.mid(i, 1), entry);
+
+        if (i + 1 < term.length() && term.at(i + 1).isLetterOrNumber()) {
+            addPosting(wordPrefixes, term.mid(i, 2), entry);
+        }
+    }
+}
+
+// How well a single term matches: exactly, at its start, at the start
+// of one of its words, or somewhere in the middle.
+static qreal termScore(const QString &term, const QString &text)
+{
+    int at = term.indexOf(text);
+
+    if (at == -1) {
+        return 0.0;
+    } else if (at == 0) {
+        return (term.length() == text.length()) ? 1.0 : 0.9;
+    }
+
+    qreal score = 0.6;
+
+    while (at != -1) {
+        if (!term.at(at - 1).isLetterOrNumber()) {
+            score = 0.8;
+            break;
+        }
+
+        at = term.indexOf(text, at + 1);
+    }
+
+    return score;
+}
+
+AppSearchIndex::AppSearchIndex()
+{
+}
+
+void AppSearchIndex::setEntries(const QVector<Entry> &entries)
+{
+    m_entries = entries;
+    m_terms.clear();
+    m_terms.reserve(entries.count());
+    m_trigrams.clear();
+    m_wordPrefixes.clear();
+
+    for (int i = 0; i < m_entries.count(); ++i) {
+        const Entry &entry = m_entries.at(i);
+
+        Terms terms;
+        terms.name = normalized(entry.name);
+        terms.genericName = normalized(entry.genericName);
+
+        foreach (const QString &keyword, entry.keywords) {
+            terms.keywords << normalized(keyword);
+        }
+
+        terms.storageId = normalized(entry.storageId);
+
+        if (terms.storageId.endsWith(QLatin1String(".desktop"))) {
+            terms.storageId.chop(8);
+        }
+
+        addTerm(m_trigrams, m_wordPrefixes, terms.name, i);
+        addTerm(m_trigrams, m_wordPrefixes, terms.genericName, i);
+
+        foreach (const QString &keyword, terms.keywords) {
+            addTerm(m_trigrams, m_wordPrefixes, keyword, i);
+        }
+
+        addTerm(m_trigrams, m_wordPrefixes, terms.storageId, i);
+
+        m_terms.append(terms);
+    }
+}
+
+qreal AppSearchIndex::score(const Terms &terms, const QString &text) const
+{
+    qreal best = termScore(terms.name, text);
+
+    if (best == 1.0) {
+        return best;
+    }
+
+    best = qMax(best, 0.8 * termScore(terms.genericName, text));
+
+    foreach (const QString &keyword, terms.keywords) {
+        best = qMax(best, 0.7 * termScore(keyword, text));
+    }
+
+    best = qMax(best, 0.6 * termScore(terms.storageId, text));
+
+    return best;
+}
+
+QVector<AppSearchIndex::Result> AppSearchIndex::query(const QString &text, int limit) const
+{
+    QVector<Result> results;
+
+    const QString needle = normalized(text);
+
+    if (needle.isEmpty()) {
+        return results;
+    }
+
+    QVector<int> candidates;
+
+    if (needle.length() < 3) {
+        candidates = m_wordPrefixes.value(needle);
+    } else {
+        QVector<const QVector<int> *> lists;
+
+        for (int i = 0; i + 3 <= needle.length(); ++i) {
+            auto it = m_trigrams.constFind(needle.mid(i, 3));
+
+            if (it == m_trigrams.constEnd()) {
+                return results;
+            }
+
+            lists.append(&it.value());
+        }
+
+        // Intersecting the shortest lists first keeps the work
+        // proportional to the rarest trigram.
+        std::sort(lists.begin(), lists.end(),
+            [](const QVector<int> *a, const QVector<int> *b) {
+                return a->count() < b->count();
+            });
+
+        candidates = *lists.first();
+
+        for (int i = 1; i < lists.count() && !candidates.isEmpty(); ++i) {
+            QVector<int> intersection;
+            std::set_intersection(candidates.constBegin(), candidates.constEnd(),
+                lists.at(i)->constBegin(), lists.at(i)->constEnd(),
+                std::back_inserter(intersection));
+            candidates = intersection;
+        }
+    }
+
+    // Trigrams only tell us a term might contain the query, the
+    // scoring below checks whether one really does.
+    foreach (int candidate, candidates) {
+        const qreal relevance = score(m_terms.at(candidate), needle);
+
+        if (relevance > 0.0) {
+            results.append(Result{candidate, relevance});
+        }
+    }
+
+    const QVector<Terms> &terms = m_terms;
+
+    auto better = [&terms](const Result &a, const Result &b) {
+        if (a.relevance != b.relevance) {
+            return a.relevance > b.relevance;
+        }
+
+        return terms.at(a.entry).name < terms.at(b.entry).name;
+    };
+
+    if (limit > 0 && results.count() > limit) {
+        std::partial_sort(results.begin(), results.begin() + limit, results.end(), better);
+        results.resize(limit);
+    } else {
+        std::sort(results.begin(), results.end(), better);
+    }
+
+    return results;
+}
+
+static void collectEntries(KServiceGroup::Ptr group, QVector<AppSearchIndex::Entry> &entries, QSet<QString> &seen)
+{
+    if (!group || !group->isValid()) {
+        return;
+    }
+
+    const KServiceGroup::List list = group->entries(false /* sorted */, true /* excludeNoDisplay */);
+
+    for (KServiceGroup::List::ConstIterator it = list.constBegin(); it != list.constEnd(); it++) {
+        const KSycocaEntry::Ptr p = (*it);
+
+        if (p->isType(KST_KService)) {
+            const KService::Ptr service(static_cast<KService*>(p.data()));
+
+            if (service->noDisplay() || seen.contains(service->storageId())) {
+                continue;
+            }
+
+            seen.insert(service->storageId());
+
+            AppSearchIndex::Entry entry;
+            entry.storageId = service->storageId();
+            entry.name = service->name();
+            entry.genericName = service->genericName();
+            entry.comment = service->comment();
+            entry.icon = service->icon();
+            entry.keywords = service->keywords();
+
+            entries.append(entry);
+        } else if (p->isType(KST_KServiceGroup)) {
+            const KServiceGroup::Ptr subGroup(static_cast<KServiceGroup*>(p.data()));
+
+            if (!subGroup->noDisplay() && subGroup->childCount() > 0) {
+                collectEntries(subGroup, entries, seen);
+            }
+        }
+    }
+}
+
+const AppSearchIndex &AppSearchIndex::applications()
+{
+    static AppSearchIndex *index = nullptr;
+    static bool dirty = true;
+
+    if (!index) {
+        index = new AppSearchIndex();
+
+        QObject::connect(KSycoca::self(),
+            static_cast<void (KSycoca::*)(const QStringList &)>(&KSycoca::databaseChanged),
+            [](const QStringList &changes) {
+                if (changes.contains(QLatin1String("services")) || changes.contains(QLatin1String("apps"))
+                    || changes.contains(QLatin1String("xdgdata-apps"))) {
+                    dirty = true;
+                }
+            });
+    }
+
+    if (dirty) {
+        QVector<Entry> entries;
+        QSet<QString> seen;
+
+        collectEntries(KServiceGroup::root(), entries, seen);
+
+        index->setEntries(entries);
+        dirty = false;
+    }
+
+    return *index;
+}
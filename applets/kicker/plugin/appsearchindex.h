@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#ifndef APPSEARCHINDEX_H
+#define APPSEARCHINDEX_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+// An in-memory index over the applications in the menu, used to answer
+// application name queries while the runners are still busy.
+//
+// Queries of three or more characters are looked up through the trigrams
+// of the searchable terms, shorter ones through the first one or two
+// characters of every word.
+class AppSearchIndex
+{
+    public:
+        struct Entry {
+            QString storageId;
+            QString name;
+            QString genericName;
+            QString comment;
+            QString icon;
+            QStringList keywords;
+        };
+
+        struct Result {
+            int entry;
+            qreal relevance;
+        };
+
+        AppSearchIndex();
+
+        void setEntries(const QVector<Entry> &entries);
+
+        int count() const { return m_entries.count(); }
+        const Entry &entry(int index) const { return m_entries.at(index); }
+
+        // Returns at most limit results, best ones first.
+        QVector<Result> query(const QString &text, int limit = 20) const;
+
+        // The shared index over the application menu, rebuilt on first
+        // use after the sycoca database changed.
+        static const AppSearchIndex &applications();
+
+    private:
+        struct Terms {
+            QString name;
+            QString genericName;
+            QStringList keywords;
+            QString storageId;
+        };
+
+        qreal score(const Terms &terms, const QString &text) const;
+
+        QVector<Entry> m_entries;
+        QVector<Terms> m_terms;
+
+        // Posting lists hold entry indices in ascending order.
+        QHash<QString, QVector<int> > m_trigrams;
+        QHash<QString, QVector<int> > m_wordPrefixes;
+};
+
+#endif
@@ -49,6 +49,11 @@ bool ContainmentInterface::mayAddLauncher(QObject *appletInterface, ContainmentI
     }
 
     Plasma::Applet *applet = appletInterface->property("_plasma_applet").value<Plasma::Applet *>();
+
+    if (!applet) {
+        return false;
+    }
+
     Plasma::Containment *containment = applet->containment();
 
     if (!containment) {
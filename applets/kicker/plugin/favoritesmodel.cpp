@@ -149,7 +149,7 @@ void FavoritesModel::setMaxFavorites(int max)
 
 bool FavoritesModel::isFavorite(const QString &id) const
 {
-    return m_favorites.contains(id);
+    return m_favoriteIndex.contains(id);
 }
 
 void FavoritesModel::addFavorite(const QString &id, int index)
@@ -177,11 +177,13 @@ void FavoritesModel::addFavorite(const QString &id, int index)
 
     m_entryList.insert(insertIndex, entry);
     m_favorites.insert(insertIndex, entry->id());
+    updateFavoriteIndex();
 
     endInsertRows();
 
     emit countChanged();
     emit favoritesChanged();
+    emit favoriteIdsChanged(QStringList() << entry->id(), QStringList());
 }
 
 void FavoritesModel::removeFavorite(const QString &id)
@@ -190,7 +192,7 @@ void FavoritesModel::removeFavorite(const QString &id)
         return;
     }
 
-    int index = m_favorites.indexOf(id);
+    int index = m_favoriteIndex.value(id, -1);
 
     if (index != -1) {
         setDropPlaceholderIndex(-1);
@@ -200,11 +202,13 @@ void FavoritesModel::removeFavorite(const QString &id)
         delete m_entryList[index];
         m_entryList.removeAt(index);
         m_favorites.removeAt(index);
+        updateFavoriteIndex();
 
         endRemoveRows();
 
         emit countChanged();
         emit favoritesChanged();
+        emit favoriteIdsChanged(QStringList(), QStringList() << id);
     }
 }
 
@@ -227,6 +231,7 @@ void FavoritesModel::moveRow(int from, int to)
     if (ok) {
         m_entryList.move(from, to);
         m_favorites.move(from, to);
+        updateFavoriteIndex();
 
         endMoveRows();
 
@@ -305,6 +310,9 @@ void FavoritesModel::refresh()
 
     m_favorites = newFavorites;
 
+    const QHash<QString, int> oldIndex = m_favoriteIndex;
+    updateFavoriteIndex();
+
     endResetModel();
 
     if (oldCount != m_entryList.count()) {
@@ -312,6 +320,35 @@ void FavoritesModel::refresh()
     }
 
     emit favoritesChanged();
+
+    QStringList added;
+    QStringList removed;
+
+    foreach (const QString &id, m_favorites) {
+        if (!oldIndex.contains(id)) {
+            added << id;
+        }
+    }
+
+    for (auto it = oldIndex.constBegin(); it != oldIndex.constEnd(); ++it) {
+        if (!m_favoriteIndex.contains(it.key())) {
+            removed << it.key();
+        }
+    }
+
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        emit favoriteIdsChanged(added, removed);
+    }
+}
+
+void FavoritesModel::updateFavoriteIndex()
+{
+    m_favoriteIndex.clear();
+    m_favoriteIndex.reserve(m_favorites.count());
+
+    for (int i = 0; i < m_favorites.count(); ++i) {
+        m_favoriteIndex.insert(m_favorites.at(i), i);
+    }
 }
 
 AbstractEntry *FavoritesModel::favoriteFromId(const QString &id)
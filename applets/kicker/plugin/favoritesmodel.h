@@ -73,16 +73,22 @@ class FavoritesModel : public AbstractModel
     Q_SIGNALS:
         void enabledChanged() const;
         void favoritesChanged() const;
+        // Which ids became or stopped being favorites, emitted along with
+        // favoritesChanged() unless favorites were only moved around.
+        void favoriteIdsChanged(const QStringList &added, const QStringList &removed) const;
         void maxFavoritesChanged() const;
         void dropPlaceholderIndexChanged();
 
     private:
         AbstractEntry *favoriteFromId(const QString &id);
+        void updateFavoriteIndex();
 
         bool m_enabled;
 
         QList<AbstractEntry *> m_entryList;
         QStringList m_favorites;
+        // Row of each id in m_favorites, for isFavorite().
+        QHash<QString, int> m_favoriteIndex;
         int m_maxFavorites;
 
         int m_dropPlaceholderIndex;
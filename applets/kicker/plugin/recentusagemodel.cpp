@@ -36,6 +36,7 @@
 #include <KLocalizedString>
 #include <KRun>
 #include <KService>
+#include <KSycoca>
 #include <KStartupInfo>
 
 #include <KActivities/Stats/Cleaning>
@@ -58,14 +59,39 @@ GroupSortProxy::~GroupSortProxy()
 {
 }
 
+FavoriteStateProxy::FavoriteStateProxy(QObject *parent) : QIdentityProxyModel(parent)
+{
+}
+
+FavoriteStateProxy::~FavoriteStateProxy()
+{
+}
+
+void FavoriteStateProxy::favoriteStateChanged(int firstRow, int lastRow)
+{
+    emit dataChanged(index(firstRow, 0), index(lastRow, 0), QVector<int>() << Kicker::FavoriteIdRole);
+}
+
 InvalidAppsFilterProxy::InvalidAppsFilterProxy(AbstractModel *parentModel, QAbstractItemModel *sourceModel) : QSortFilterProxyModel(sourceModel)
 , m_parentModel(parentModel)
+, m_favoriteStateProxy(new FavoriteStateProxy(this))
 {
+    // Whether a row is accepted depends on it being a favorite, so changes
+    // to that role need to be filtered again.
+    setFilterRole(Kicker::FavoriteIdRole);
+
+    connect(KSycoca::self(), static_cast<void (KSycoca::*)(const QStringList &)>(&KSycoca::databaseChanged),
+        this, [this]() {
+            m_storageIds.clear();
+            invalidateFilter();
+        });
+
     connect(parentModel, &AbstractModel::favoritesModelChanged, this, &InvalidAppsFilterProxy::connectNewFavoritesModel);
     connectNewFavoritesModel();
 
     sourceModel->setParent(this);
-    setSourceModel(sourceModel);
+    m_favoriteStateProxy->setSourceModel(sourceModel);
+    setSourceModel(m_favoriteStateProxy);
 }
 
 InvalidAppsFilterProxy::~InvalidAppsFilterProxy()
@@ -74,12 +100,71 @@ InvalidAppsFilterProxy::~InvalidAppsFilterProxy()
 
 void InvalidAppsFilterProxy::connectNewFavoritesModel()
 {
+    if (m_favoritesModel) {
+        disconnect(m_favoritesModel, nullptr, this, nullptr);
+    }
+
     FavoritesModel* favoritesModel = static_cast<FavoritesModel *>(m_parentModel->favoritesModel());
-    connect(favoritesModel, &FavoritesModel::favoritesChanged, this, &QSortFilterProxyModel::invalidate);
+    m_favoritesModel = favoritesModel;
+
+    if (favoritesModel) {
+        connect(favoritesModel, &FavoritesModel::favoriteIdsChanged, this, &InvalidAppsFilterProxy::favoriteIdsChanged);
+    }
 
     invalidate();
 }
 
+void InvalidAppsFilterProxy::favoriteIdsChanged(const QStringList &added, const QStringList &removed)
+{
+    if (!sourceModel()) {
+        return;
+    }
+
+    const QSet<QString> ids = (added + removed).toSet();
+
+    // Rather than filtering everything again, find the rows of the affected
+    // applications and have just those filtered again. The services of the
+    // rows are cached, so finding them does no lookups.
+    QAbstractItemModel *model = sourceModel();
+    const int count = model->rowCount();
+    int firstRow = -1;
+
+    // One past the end closes a run that reaches the last row.
+    for (int row = 0; row <= count; ++row) {
+        bool affected = false;
+
+        if (row < count) {
+            const QString &resource = model->index(row, 0).data(ResultModel::ResourceRole).toString();
+
+            affected = resource.startsWith(QLatin1String("applications:"))
+                && ids.contains(storageIdForResource(resource));
+        }
+
+        if (affected && firstRow == -1) {
+            firstRow = row;
+        } else if (!affected && firstRow != -1) {
+            m_favoriteStateProxy->favoriteStateChanged(firstRow, row - 1);
+            firstRow = -1;
+        }
+    }
+}
+
+QString InvalidAppsFilterProxy::storageIdForResource(const QString &resource) const
+{
+    auto it = m_storageIds.constFind(resource);
+
+    if (it != m_storageIds.constEnd()) {
+        return *it;
+    }
+
+    KService::Ptr service = KService::serviceByStorageId(resource.section(':', 1));
+    const QString &storageId = service ? service->storageId() : QString();
+
+    m_storageIds.insert(resource, storageId);
+
+    return storageId;
+}
+
 bool InvalidAppsFilterProxy::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
     Q_UNUSED(source_parent);
@@ -87,11 +172,11 @@ bool InvalidAppsFilterProxy::filterAcceptsRow(int source_row, const QModelIndex
     const QString resource = sourceModel()->index(source_row, 0).data(ResultModel::ResourceRole).toString();
 
     if (resource.startsWith(QLatin1String("applications:"))) {
-        KService::Ptr service = KService::serviceByStorageId(resource.section(':', 1));
+        const QString &storageId = storageIdForResource(resource);
 
         FavoritesModel* favoritesModel = m_parentModel ? static_cast<FavoritesModel *>(m_parentModel->favoritesModel()) : nullptr;
 
-        return (service && (!favoritesModel || !favoritesModel->isFavorite(service->storageId())));
+        return (!storageId.isEmpty() && (!favoritesModel || !favoritesModel->isFavorite(storageId)));
     }
 
     return true;
@@ -309,11 +394,11 @@ bool RecentUsageModel::trigger(int row, const QString &actionId, const QVariant
     } else if (actionId == "forget" && withinBounds) {
         if (m_activitiesModel) {
             QModelIndex idx = sourceModel()->index(row, 0);
-            QSortFilterProxyModel *sourceProxy = qobject_cast<QSortFilterProxyModel *>(sourceModel());
+            QAbstractProxyModel *sourceProxy = qobject_cast<QAbstractProxyModel *>(sourceModel());
 
             while (sourceProxy) {
                 idx = sourceProxy->mapToSource(idx);
-                sourceProxy = qobject_cast<QSortFilterProxyModel *>(sourceProxy->sourceModel());
+                sourceProxy = qobject_cast<QAbstractProxyModel *>(sourceProxy->sourceModel());
             }
 
             static_cast<ResultModel *>(m_activitiesModel.data())->forgetResource(idx.row());
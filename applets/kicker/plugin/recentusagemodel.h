@@ -22,6 +22,7 @@
 
 #include "forwardingmodel.h"
 
+#include <QIdentityProxyModel>
 #include <QQmlParserStatus>
 #include <QSortFilterProxyModel>
 
@@ -37,6 +38,20 @@ class GroupSortProxy : public QSortFilterProxyModel
         bool lessThan(const QModelIndex &left, const QModelIndex &right) const Q_DECL_OVERRIDE;
 };
 
+// Passes the activity results through unchanged. InvalidAppsFilterProxy
+// owns it, so it can announce that rows became or stopped being favorites
+// and have just those rows filtered again.
+class FavoriteStateProxy : public QIdentityProxyModel
+{
+    Q_OBJECT
+
+    public:
+        explicit FavoriteStateProxy(QObject *parent);
+        ~FavoriteStateProxy();
+
+        void favoriteStateChanged(int firstRow, int lastRow);
+};
+
 class InvalidAppsFilterProxy : public QSortFilterProxyModel
 {
     Q_OBJECT
@@ -50,9 +65,17 @@ class InvalidAppsFilterProxy : public QSortFilterProxyModel
 
     private Q_SLOTS:
         void connectNewFavoritesModel();
+        void favoriteIdsChanged(const QStringList &added, const QStringList &removed);
 
     private:
+        // The canonical storage id of the application a resource refers
+        // to, or an empty string if there is no such application.
+        QString storageIdForResource(const QString &resource) const;
+
         QPointer<AbstractModel> m_parentModel;
+        QPointer<AbstractModel> m_favoritesModel;
+        FavoriteStateProxy *m_favoriteStateProxy;
+        mutable QHash<QString, QString> m_storageIds;
 };
 
 class RecentUsageModel : public ForwardingModel, public QQmlParserStatus
@@ -24,6 +24,7 @@
 
 #include <QAction>
 #include <QIcon>
+#include <QSet>
 
 #include <KLocalizedString>
 #include <KRunner/RunnerManager>
@@ -181,45 +182,115 @@ bool RunnerMatchesModel::trigger(int row, const QString &actionId, const QVarian
     return true;
 }
 
+// Runners that do not give their matches an id of their own still
+// give them distinct data, e.g. the storage id of a service.
+static QString matchKey(const Plasma::QueryMatch &match)
+{
+    const QString &runnerId = match.runner() ? match.runner()->id() : QString();
+    const QString &id = match.id();
+
+    if (id.isEmpty() || id == runnerId) {
+        return runnerId + QLatin1Char('/') + match.data().toString();
+    }
+
+    return runnerId + QLatin1Char('/') + id;
+}
+
+static bool sameContent(const Plasma::QueryMatch &a, const Plasma::QueryMatch &b)
+{
+    return a == b
+        || (a.text() == b.text()
+            && a.subtext() == b.subtext()
+            && a.iconName() == b.iconName()
+            && a.icon().cacheKey() == b.icon().cacheKey()
+            && a.isEnabled() == b.isEnabled()
+            && a.data() == b.data());
+}
+
 void RunnerMatchesModel::setMatches(const QList< Plasma::QueryMatch > &matches)
 {
-    int oldCount = m_matches.count();
-    int newCount = matches.count();
+    const int oldCount = m_matches.count();
+
+    QSet<QString> newKeys;
+
+    foreach (const Plasma::QueryMatch &match, matches) {
+        newKeys.insert(matchKey(match));
+    }
 
-    bool emitCountChange = (oldCount != newCount);
+    // Remove the rows that are gone, in contiguous runs from the bottom.
+    for (int row = m_matches.count() - 1; row >= 0; --row) {
+        if (newKeys.contains(matchKey(m_matches.at(row)))) {
+            continue;
+        }
+
+        int first = row;
 
-    int ceiling = qMin(oldCount, newCount);
-    bool emitDataChange = false;
+        while (first > 0 && !newKeys.contains(matchKey(m_matches.at(first - 1)))) {
+            --first;
+        }
 
-    for (int row = 0; row < ceiling; ++row) {
-        if (!(m_matches.at(row) == matches.at(row))) {
-            emitDataChange = true;
+        beginRemoveRows(QModelIndex(), first, row);
 
-            break;
+        for (int i = row; i >= first; --i) {
+            m_matches.removeAt(i);
         }
+
+        endRemoveRows();
+
+        row = first;
     }
 
-    if (newCount > oldCount) {
-        beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+    // Walk the new list; rows above the current position are final, so
+    // the match for it is either already in place, further down, or new.
+    for (int row = 0; row < matches.count(); ++row) {
+        const Plasma::QueryMatch &match = matches.at(row);
+        const QString &key = matchKey(match);
 
-        m_matches = matches;
+        int from = -1;
+
+        for (int i = row; i < m_matches.count(); ++i) {
+            if (matchKey(m_matches.at(i)) == key) {
+                from = i;
+                break;
+            }
+        }
 
-        endInsertRows();
-    } else if (newCount < oldCount) {
-        beginRemoveRows(QModelIndex(), newCount, oldCount - 1);
+        if (from == -1) {
+            beginInsertRows(QModelIndex(), row, row);
+            m_matches.insert(row, match);
+            endInsertRows();
 
-        m_matches = matches;
+            continue;
+        }
 
-        endRemoveRows();
+        if (from != row) {
+            beginMoveRows(QModelIndex(), from, from, QModelIndex(), row);
+            m_matches.move(from, row);
+            endMoveRows();
+        }
+
+        const bool changed = !sameContent(m_matches.at(row), match);
+
+        m_matches[row] = match;
+
+        if (changed) {
+            const QModelIndex &idx = index(row, 0);
+            emit dataChanged(idx, idx);
+        }
     }
 
-    if (emitDataChange) {
-        m_matches = matches;
+    // Whatever is left over had a duplicate key.
+    if (m_matches.count() > matches.count()) {
+        beginRemoveRows(QModelIndex(), matches.count(), m_matches.count() - 1);
 
-        emit dataChanged(index(0, 0), index(ceiling - 1, 0));
+        while (m_matches.count() > matches.count()) {
+            m_matches.removeLast();
+        }
+
+        endRemoveRows();
     }
 
-    if (emitCountChange) {
+    if (m_matches.count() != oldCount) {
         emit countChanged();
     }
 }
@@ -19,10 +19,13 @@
  ***************************************************************************/
 
 #include "runnermodel.h"
+#include "appsearchindex.h"
 #include "runnermatchesmodel.h"
 
 #include <QSet>
 
+#include <algorithm>
+
 #include <KLocalizedString>
 #include <KRunner/AbstractRunner>
 #include <KRunner/RunnerManager>
@@ -37,6 +40,12 @@ RunnerModel::RunnerModel(QObject *parent) : QAbstractListModel(parent)
     m_queryTimer.setSingleShot(true);
     m_queryTimer.setInterval(10);
     connect(&m_queryTimer, SIGNAL(timeout()), this, SLOT(startQuery()));
+
+    // Runners report their matches one after another; apply them at
+    // most once per frame rather than once per runner.
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(16);
+    connect(&m_updateTimer, &QTimer::timeout, this, &RunnerModel::updateMatches);
 }
 
 RunnerModel::~RunnerModel()
@@ -207,10 +216,85 @@ void RunnerModel::startQuery()
     createManager();
 
     m_runnerManager->launchQuery(m_query);
+
+    // Answer application name queries from the index right away, the
+    // services runner's own results replace these once they arrive.
+    if (m_runners.isEmpty() || m_runners.contains(QStringLiteral("services"))) {
+        m_quickMatches = quickMatches();
+
+        // Whatever the services runner found so far was for the old query.
+        auto it = std::remove_if(m_runnerMatches.begin(), m_runnerMatches.end(),
+            [](const Plasma::QueryMatch &match) {
+                return match.runner()->id() == QLatin1String("services");
+            });
+        m_runnerMatches.erase(it, m_runnerMatches.end());
+
+        updateMatches();
+    }
+}
+
+QList<Plasma::QueryMatch> RunnerModel::quickMatches() const
+{
+    QList<Plasma::QueryMatch> matches;
+
+    Plasma::AbstractRunner *runner = m_runnerManager->runner(QStringLiteral("services"));
+
+    if (!runner) {
+        return matches;
+    }
+
+    const AppSearchIndex &index = AppSearchIndex::applications();
+
+    foreach (const AppSearchIndex::Result &result, index.query(m_query)) {
+        const AppSearchIndex::Entry &entry = index.entry(result.entry);
+
+        // Mirrors how the services runner describes its matches, so
+        // replacing them with the runner's own does not look jumpy.
+        Plasma::QueryMatch match(runner);
+        match.setType(result.relevance >= 0.9 ? Plasma::QueryMatch::ExactMatch : Plasma::QueryMatch::PossibleMatch);
+        match.setId(entry.storageId);
+        match.setText(entry.name);
+        match.setSubtext(entry.genericName.isEmpty() ? entry.comment : entry.genericName);
+        match.setIconName(entry.icon);
+        match.setData(entry.storageId);
+        match.setRelevance(result.relevance);
+
+        matches.append(match);
+    }
+
+    return matches;
 }
 
 void RunnerModel::matchesChanged(const QList<Plasma::QueryMatch> &matches)
 {
+    m_runnerMatches = matches;
+
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void RunnerModel::updateMatches()
+{
+    m_updateTimer.stop();
+
+    QList<Plasma::QueryMatch> matches = m_runnerMatches;
+
+    if (!m_quickMatches.isEmpty()) {
+        bool haveServiceMatches = false;
+
+        foreach (const Plasma::QueryMatch &match, matches) {
+            if (match.runner()->id() == QLatin1String("services")) {
+                haveServiceMatches = true;
+                break;
+            }
+        }
+
+        if (!haveServiceMatches) {
+            matches.append(m_quickMatches);
+        }
+    }
+
     // Group matches by runner.
     // We do not use a QMultiHash here because it keeps values in LIFO order, while we want FIFO.
     QHash<QString, QList<Plasma::QueryMatch> > matchesForRunner;
@@ -322,6 +406,10 @@ void RunnerModel::clear()
         m_runnerManager->reset();
     }
 
+    m_runnerMatches.clear();
+    m_quickMatches.clear();
+    m_updateTimer.stop();
+
     if (m_models.isEmpty()) {
         return;
     }
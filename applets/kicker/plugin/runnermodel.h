@@ -93,14 +93,19 @@ class RunnerModel : public QAbstractListModel
     private:
         void createManager();
         void clear();
+        void updateMatches();
+        QList<Plasma::QueryMatch> quickMatches() const;
 
         AbstractModel *m_favoritesModel;
         QObject *m_appletInterface;
         Plasma::RunnerManager *m_runnerManager;
         QStringList m_runners;
         QList<RunnerMatchesModel *> m_models;
+        QList<Plasma::QueryMatch> m_runnerMatches;
+        QList<Plasma::QueryMatch> m_quickMatches;
         QString m_query;
         QTimer m_queryTimer;
+        QTimer m_updateTimer;
         bool m_mergeResults;
         bool m_deleteWhenEmpty;
 };
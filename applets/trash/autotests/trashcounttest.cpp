@@ -0,0 +1,177 @@
+/*
+ *   Copyright 2017 The KDE Project
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Library General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "trashcount.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class TrashCountTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void testAddAndDelete();
+    void testMoves();
+    void testIgnoresOtherFiles();
+    void testTrashCreatedLater();
+    void testEmptied();
+
+private:
+    void trash(const QString &name);
+    void restore(const QString &name);
+
+    QTemporaryDir m_dataHome;
+    QString m_trash;
+    // Items in the trashes of other volumes, which the test does not touch
+    int m_otherVolumes;
+};
+
+void TrashCountTest::initTestCase()
+{
+    QVERIFY(m_dataHome.isValid());
+    qputenv("XDG_DATA_HOME", QFile::encodeName(m_dataHome.path()));
+
+    m_trash = m_dataHome.path() + QStringLiteral("/Trash");
+
+    TrashCount count;
+    m_otherVolumes = count.count();
+}
+
+void TrashCountTest::init()
+{
+    QDir(m_trash).removeRecursively();
+    QVERIFY(QDir().mkpath(m_trash + QStringLiteral("/info")));
+    QVERIFY(QDir().mkpath(m_trash + QStringLiteral("/files")));
+}
+
+void TrashCountTest::trash(const QString &name)
+{
+    QFile file(m_trash + QStringLiteral("/files/") + name);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    QFile info(m_trash + QStringLiteral("/info/") + name + QStringLiteral(".trashinfo"));
+    QVERIFY(info.open(QIODevice::WriteOnly));
+    info.write("[Trash Info]\nPath=/tmp/" + name.toUtf8() + "\nDeletionDate=2017-01-01T00:00:00\n");
+    info.close();
+}
+
+void TrashCountTest::restore(const QString &name)
+{
+    QVERIFY(QFile::remove(m_trash + QStringLiteral("/info/") + name + QStringLiteral(".trashinfo")));
+    QVERIFY(QFile::remove(m_trash + QStringLiteral("/files/") + name));
+}
+
+void TrashCountTest::testAddAndDelete()
+{
+    for (int i = 0; i < 10; ++i) {
+        trash(QStringLiteral("before%1").arg(i));
+    }
+
+    TrashCount count;
+    QCOMPARE(count.count(), m_otherVolumes + 10);
+
+    for (int i = 0; i < 5; ++i) {
+        trash(QStringLiteral("after%1").arg(i));
+    }
+    QTRY_COMPARE(count.count(), m_otherVolumes + 15);
+
+    for (int i = 0; i < 10; ++i) {
+        restore(QStringLiteral("before%1").arg(i));
+    }
+    QTRY_COMPARE(count.count(), m_otherVolumes + 5);
+}
+
+void TrashCountTest::testMoves()
+{
+    TrashCount count;
+    QCOMPARE(count.count(), m_otherVolumes);
+
+    // kio_trash moves files in and out of the trash where it can
+    QTemporaryDir elsewhere(m_dataHome.path() + QStringLiteral("/elsewhereXXXXXX"));
+    QFile info(elsewhere.path() + QStringLiteral("/moved.trashinfo"));
+    QVERIFY(info.open(QIODevice::WriteOnly));
+    info.close();
+
+    QVERIFY(QFile::rename(info.fileName(), m_trash + QStringLiteral("/info/moved.trashinfo")));
+    QTRY_COMPARE(count.count(), m_otherVolumes + 1);
+
+    QVERIFY(QFile::rename(m_trash + QStringLiteral("/info/moved.trashinfo"), info.fileName()));
+    QTRY_COMPARE(count.count(), m_otherVolumes);
+}
+
+void TrashCountTest::testIgnoresOtherFiles()
+{
+    TrashCount count;
+    QSignalSpy changed(&count, &TrashCount::countChanged);
+
+    // Temporary files written by kio_trash before renaming them
+    QFile other(m_trash + QStringLiteral("/info/partial.trashinfo.part"));
+    QVERIFY(other.open(QIODevice::WriteOnly));
+    other.close();
+    QVERIFY(QDir().mkpath(m_trash + QStringLiteral("/info/dir.trashinfo")));
+
+    trash(QStringLiteral("real"));
+    QTRY_COMPARE(count.count(), m_otherVolumes + 1);
+    QCOMPARE(changed.count(), 1);
+}
+
+void TrashCountTest::testTrashCreatedLater()
+{
+    QDir(m_trash).removeRecursively();
+
+    TrashCount count;
+    QCOMPARE(count.count(), m_otherVolumes);
+
+    QVERIFY(QDir().mkpath(m_trash + QStringLiteral("/info")));
+    QVERIFY(QDir().mkpath(m_trash + QStringLiteral("/files")));
+    // Give the new directories a moment to be picked up
+    QTest::qWait(100);
+
+    trash(QStringLiteral("first"));
+    trash(QStringLiteral("second"));
+    QTRY_COMPARE(count.count(), m_otherVolumes + 2);
+}
+
+void TrashCountTest::testEmptied()
+{
+    for (int i = 0; i < 100; ++i) {
+        trash(QStringLiteral("item%1").arg(i));
+    }
+
+    TrashCount count;
+    QCOMPARE(count.count(), m_otherVolumes + 100);
+
+    QVERIFY(QDir(m_trash).removeRecursively());
+    QTRY_COMPARE(count.count(), m_otherVolumes);
+
+    init();
+    trash(QStringLiteral("again"));
+    QTRY_COMPARE(count.count(), m_otherVolumes + 1);
+}
+
+QTEST_GUILESS_MAIN(TrashCountTest)
+
+#include "trashcounttest.moc"
@@ -58,7 +58,7 @@ DragDrop.DropArea {
 
     Plasmoid.preferredRepresentation: Plasmoid.fullRepresentation
     Plasmoid.backgroundHints: PlasmaCore.Types.NoBackground
-    Plasmoid.icon: (dirModel.count > 0) ? "user-trash-full": "user-trash"
+    Plasmoid.icon: (trashCount.count > 0) ? "user-trash-full": "user-trash"
 
     preventStealing: true
 
@@ -77,9 +77,9 @@ DragDrop.DropArea {
         }
     }
 
-    TrashPrivate.DirModel {
-        id: dirModel
-        url: "trash:/"
+    // Only counts the items, the trash is never listed here
+    TrashPrivate.TrashCount {
+        id: trashCount
         onCountChanged: {
             plasmoid.action("empty").enabled = count > 0;
         }
@@ -101,7 +101,7 @@ DragDrop.DropArea {
         plasmoid.removeAction("configure");
         plasmoid.setAction("open", i18nc("a verb", "Open"),"document-open");
         plasmoid.setAction("empty",i18nc("a verb", "Empty"),"trash-empty");
-        plasmoid.action("empty").enabled = dirModel.count > 0;
+        plasmoid.action("empty").enabled = trashCount.count > 0;
 
         if (KCMShell.authorize("kcmtrash.desktop").length > 0) {
             plasmoid.setAction("openkcm", i18n("Trash Settings..."), "configure");
@@ -151,7 +151,7 @@ DragDrop.DropArea {
             horizontalCenter: parent.horizontalCenter
             bottom: parent.bottom
         }
-        text: (dirModel.count === 0) ? i18n("Trash\nEmpty") : i18np("Trash\nOne item", "Trash\n %1 items", dirModel.count)
+        text: (trashCount.count === 0) ? i18n("Trash\nEmpty") : i18np("Trash\nOne item", "Trash\n %1 items", trashCount.count)
         color: "white"
         horizontalAlignment: Text.AlignHCenter
         visible: false // rendered by DropShadow
@@ -161,7 +161,7 @@ DragDrop.DropArea {
         id: toolTip
         anchors.fill: parent
         mainText: i18n("Trash")
-        subText: (dirModel.count === 0) ? i18n("Empty") : i18np("One item", "%1 items", dirModel.count)
-        icon: (dirModel.count > 0) ? "user-trash-full" : "user-trash"
+        subText: (trashCount.count === 0) ? i18n("Empty") : i18np("One item", "%1 items", trashCount.count)
+        icon: (trashCount.count > 0) ? "user-trash-full" : "user-trash"
     }
 }
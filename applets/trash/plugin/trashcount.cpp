@@ -0,0 +1,348 @@
+/*
+ *   Copyright 2017 The KDE Project
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Library General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "trashcount.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QStorageInfo>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <mntent.h>
+#include <sys/inotify.h>
+#endif
+#include <unistd.h>
+
+static const QString s_infoSuffix = QStringLiteral(".trashinfo");
+
+// Mounts come and go in bursts, e.g. when a disk with several partitions
+// is plugged in
+static const int s_rescanDelay = 500;
+
+static bool isNetworkFileSystem(const QByteArray &type)
+{
+    static const QList<QByteArray> types = {
+        QByteArrayLiteral("nfs"), QByteArrayLiteral("nfs4"), QByteArrayLiteral("cifs"),
+        QByteArrayLiteral("smb3"), QByteArrayLiteral("smbfs"), QByteArrayLiteral("ncpfs"),
+        QByteArrayLiteral("afs"), QByteArrayLiteral("9p"), QByteArrayLiteral("davfs"),
+        QByteArrayLiteral("fuse.sshfs"), QByteArrayLiteral("fuse.davfs2"), QByteArrayLiteral("fuse.curlftpfs"),
+        // Unmounted automount points would be mounted just for looking at them
+        QByteArrayLiteral("autofs")
+    };
+
+    return types.contains(type);
+}
+
+// Looking at a network share blocks while its server does not answer,
+// so those are left out before anything on them is touched
+static QStringList localMountPoints()
+{
+    QStringList mountPoints;
+
+#ifdef Q_OS_LINUX
+    // QStorageInfo would statfs() every volume, network shares included
+    FILE *mounts = setmntent("/proc/self/mounts", "r");
+
+    if (mounts) {
+        struct mntent entry;
+        char buffer[4096];
+
+        while (getmntent_r(mounts, &entry, buffer, sizeof(buffer))) {
+            if (!isNetworkFileSystem(entry.mnt_type)) {
+                mountPoints << QFile::decodeName(entry.mnt_dir);
+            }
+        }
+
+        endmntent(mounts);
+    }
+#else
+    foreach (const QStorageInfo &volume, QStorageInfo::mountedVolumes()) {
+        if (volume.isValid() && !isNetworkFileSystem(volume.fileSystemType()) && volume.isReady()) {
+            mountPoints << volume.rootPath();
+        }
+    }
+#endif
+
+    return mountPoints;
+}
+
+TrashCount::TrashCount(QObject *parent)
+    : QObject(parent)
+    , m_count(0)
+    , m_inotifyFd(-1)
+    , m_notifier(nullptr)
+    , m_watcher(nullptr)
+    , m_mountInfo(nullptr)
+    , m_mountNotifier(nullptr)
+    , m_rescanTimer(new QTimer(this))
+{
+    m_rescanTimer->setSingleShot(true);
+    m_rescanTimer->setInterval(s_rescanDelay);
+    connect(m_rescanTimer, &QTimer::timeout, this, &TrashCount::rescan);
+
+#ifdef Q_OS_LINUX
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_inotifyFd != -1) {
+        m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &TrashCount::readEvents);
+    }
+#endif
+
+    if (m_inotifyFd == -1) {
+        m_watcher = new QFileSystemWatcher(this);
+        connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &TrashCount::directoryChanged);
+    }
+
+#ifdef Q_OS_LINUX
+    // The kernel raises a priority event on the mount table when it changes
+    m_mountInfo = new QFile(QStringLiteral("/proc/self/mountinfo"), this);
+
+    if (m_mountInfo->open(QIODevice::ReadOnly)) {
+        m_mountNotifier = new QSocketNotifier(m_mountInfo->handle(), QSocketNotifier::Exception, this);
+        connect(m_mountNotifier, &QSocketNotifier::activated, this, &TrashCount::mountsChanged);
+    }
+#endif
+
+    rescan();
+}
+
+TrashCount::~TrashCount()
+{
+    if (m_inotifyFd != -1) {
+        close(m_inotifyFd);
+    }
+}
+
+int TrashCount::count() const
+{
+    return m_count;
+}
+
+QStringList TrashCount::trashDirectories()
+{
+    // The trash in the home directory, see the freedesktop.org trash spec
+    QStringList dirs;
+    dirs << QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/Trash");
+
+    // and the ones at the top of other mounted volumes
+    const QString uid = QString::number(getuid());
+
+    foreach (const QString &root, localMountPoints()) {
+        const QStringList candidates = {
+            root + QStringLiteral("/.Trash/") + uid,
+            root + QStringLiteral("/.Trash-") + uid
+        };
+
+        foreach (const QString &candidate, candidates) {
+            const QString path = QDir::cleanPath(candidate);
+
+            if (!dirs.contains(path) && QFileInfo(path + QStringLiteral("/info")).isDir()) {
+                dirs << path;
+            }
+        }
+    }
+
+    return dirs;
+}
+
+int TrashCount::countInfoFiles(const QString &infoDir)
+{
+    int count = 0;
+
+    // Names only, nothing is stat'ed
+    QDirIterator it(infoDir, QStringList() << QStringLiteral("*.trashinfo"), QDir::Files | QDir::Hidden | QDir::System);
+
+    while (it.hasNext()) {
+        it.next();
+        ++count;
+    }
+
+    return count;
+}
+
+void TrashCount::clearWatches()
+{
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd != -1) {
+        foreach (int wd, m_infoWatches.keys() + m_parentWatches.keys()) {
+            inotify_rm_watch(m_inotifyFd, wd);
+        }
+    }
+#endif
+
+    m_infoWatches.clear();
+    m_parentWatches.clear();
+
+    if (m_watcher && !m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+}
+
+void TrashCount::watch(const QString &path, bool infoDir)
+{
+    if (m_watcher) {
+        m_watcher->addPath(path);
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    const uint32_t mask = infoDir
+        ? (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+        : (IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+
+    const int wd = inotify_add_watch(m_inotifyFd, QFile::encodeName(path).constData(), mask);
+
+    if (wd != -1) {
+        if (infoDir) {
+            m_infoWatches.insert(wd, path);
+        } else {
+            m_parentWatches.insert(wd, path);
+        }
+    }
+#else
+    Q_UNUSED(infoDir)
+#endif
+}
+
+void TrashCount::rescan()
+{
+    clearWatches();
+    m_counts.clear();
+
+    foreach (const QString &trash, trashDirectories()) {
+        const QString info = trash + QStringLiteral("/info");
+
+        if (QFileInfo(info).isDir()) {
+            // Watch first, so nothing trashed while counting is missed
+            watch(info, true);
+            m_counts.insert(info, countInfoFiles(info));
+        } else {
+            // The home trash only appears when something is trashed
+            // the first time
+            const QString parent = QFileInfo(trash).isDir() ? trash : QFileInfo(trash).path();
+
+            if (QFileInfo(parent).isDir()) {
+                watch(parent, false);
+            }
+        }
+    }
+
+    updateCount();
+}
+
+void TrashCount::readEvents()
+{
+#ifdef Q_OS_LINUX
+    bool needRescan = false;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    forever {
+        const ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+
+        if (length <= 0) {
+            break;
+        }
+
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                needRescan = true;
+                continue;
+            }
+
+            if (m_parentWatches.contains(event->wd)) {
+                if (event->mask & IN_ISDIR) {
+                    needRescan = true;
+                }
+
+                continue;
+            }
+
+            auto it = m_infoWatches.constFind(event->wd);
+
+            if (it == m_infoWatches.constEnd()) {
+                continue;
+            }
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                needRescan = true;
+                continue;
+            }
+
+            if (!event->len || (event->mask & IN_ISDIR)
+                || !QFile::decodeName(event->name).endsWith(s_infoSuffix)) {
+                continue;
+            }
+
+            int &count = m_counts[it.value()];
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                ++count;
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                count = qMax(0, count - 1);
+            }
+        }
+    }
+
+    if (needRescan) {
+        rescan();
+    } else {
+        updateCount();
+    }
+#endif
+}
+
+void TrashCount::directoryChanged(const QString &path)
+{
+    if (!m_counts.contains(path)) {
+        rescan();
+        return;
+    }
+
+    m_counts[path] = countInfoFiles(path);
+    updateCount();
+}
+
+void TrashCount::mountsChanged()
+{
+    m_rescanTimer->start();
+}
+
+void TrashCount::updateCount()
+{
+    int count = 0;
+
+    foreach (int items, m_counts) {
+        count += items;
+    }
+
+    if (m_count != count) {
+        m_count = count;
+        emit countChanged();
+    }
+}
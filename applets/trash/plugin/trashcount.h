@@ -0,0 +1,94 @@
+/*
+ *   Copyright 2017 The KDE Project
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Library General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef TRASHCOUNT_H
+#define TRASHCOUNT_H
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+class QFile;
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * Counts the items in the trash without listing it.
+ *
+ * Every trashed item has a .trashinfo file in the info/ directory of its
+ * trash, so counting those names is enough. On Linux the info/ directories
+ * are watched with inotify and the count is kept up to date from the
+ * individual events; elsewhere a change makes the directory be counted
+ * again. On Linux the trashes of other volumes are also looked up again
+ * whenever something is mounted or unmounted.
+ */
+class TrashCount : public QObject
+{
+    Q_OBJECT
+
+    /**
+     * @property count Number of items in all trashes of the user
+     */
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    explicit TrashCount(QObject *parent = nullptr);
+    ~TrashCount() override;
+
+    int count() const;
+
+Q_SIGNALS:
+    void countChanged();
+
+private Q_SLOTS:
+    void rescan();
+    void readEvents();
+    void directoryChanged(const QString &path);
+    void mountsChanged();
+
+private:
+    static QStringList trashDirectories();
+    static int countInfoFiles(const QString &infoDir);
+
+    void clearWatches();
+    void watch(const QString &path, bool infoDir);
+    void updateCount();
+
+    // Items per info/ directory
+    QHash<QString, int> m_counts;
+    int m_count;
+
+    int m_inotifyFd;
+    QSocketNotifier *m_notifier;
+    // Watched info/ directories and, for trashes that do not exist yet,
+    // the directories they will be created in
+    QHash<int, QString> m_infoWatches;
+    QHash<int, QString> m_parentWatches;
+
+    QFileSystemWatcher *m_watcher;
+
+    // Signals mount table changes, which come in bursts and are
+    // compressed by the timer
+    QFile *m_mountInfo;
+    QSocketNotifier *m_mountNotifier;
+    QTimer *m_rescanTimer;
+};
+
+#endif // TRASHCOUNT_H
@@ -20,6 +20,7 @@
 #include "trashplugin.h"
 #include "dirmodel.h"
 #include "trash.h"
+#include "trashcount.h"
 
 #include <QtQml>
 
@@ -34,5 +35,6 @@ void TrashPrivatePlugin::registerTypes(const char *uri)
 {
     Q_ASSERT(uri == QLatin1String("org.kde.plasma.private.trash"));
     qmlRegisterType<DirModel>(uri, 1,0, "DirModel");
+    qmlRegisterType<TrashCount>(uri, 1, 0, "TrashCount");
     qmlRegisterSingletonType<Trash>(uri, 1, 0, "Trash", trash_singletonProvider);
 }
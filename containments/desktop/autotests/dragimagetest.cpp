@@ -0,0 +1,202 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "dragimagecomposer.h"
+#include "foldermodel.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class DragImageTest : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void testSingleItem();
+        void testLimit();
+        void testBadge();
+        void testEmpty();
+        void testModelDrag();
+        void benchmarkLargeSelection();
+
+    private:
+        QVector<DragImageComposer::Tile> m_tiles;
+        static const int s_selectionCount = 2000;
+};
+
+// Delegate sized images laid out like a desktop full of icons, forty to
+// a line.
+static QVector<DragImageComposer::Tile> gridTiles(int count)
+{
+    QImage image(80, 96, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+
+    QVector<DragImageComposer::Tile> tiles;
+    tiles.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        tiles.append(DragImageComposer::Tile{QRect((i % 40) * 100, (i / 40) * 110, 80, 96), image});
+    }
+
+    return tiles;
+}
+
+void DragImageTest::initTestCase()
+{
+    m_tiles = gridTiles(s_selectionCount);
+}
+
+void DragImageTest::testSingleItem()
+{
+    DragImageComposer composer;
+
+    const DragImageComposer::Result result = composer.compose(gridTiles(1), QPoint(40, 48), 1);
+
+    // No badge for a single item.
+    QCOMPARE(result.image.size(), QSize(80, 96));
+    QCOMPARE(result.offset, QPoint(0, 0));
+    QCOMPARE(result.image.pixel(40, 48), QColor(Qt::red).rgb());
+}
+
+void DragImageTest::testLimit()
+{
+    DragImageComposer composer;
+    composer.setLimit(9);
+
+    // In the middle of the grid.
+    const QPoint hotSpot(20 * 100 + 40, 25 * 110 + 48);
+    const DragImageComposer::Result result = composer.compose(m_tiles, hotSpot, s_selectionCount);
+
+    // The closest ones are at most two tiles to either side and one above
+    // or below.
+    QVERIFY(!result.image.isNull());
+    QVERIFY(result.image.width() <= 5 * 100);
+    QVERIFY(result.image.height() <= 3 * 110);
+
+    // The tile under the hot spot is drawn.
+    const QPoint inImage = hotSpot - result.offset;
+    QCOMPARE(result.image.pixel(inImage), QColor(Qt::red).rgb());
+
+    // Far away tiles are not.
+    QVERIFY(!QRect(result.offset, result.image.size()).contains(QPoint(0, 0)));
+}
+
+void DragImageTest::testBadge()
+{
+    DragImageComposer composer;
+    composer.setBadgeColors(Qt::blue, Qt::blue);
+
+    // Near the top left corner of the tile, so the badge above and to the
+    // right of the hot spot grows the image upwards.
+    const QPoint hotSpot(10, 10);
+    const DragImageComposer::Result result = composer.compose(gridTiles(1), hotSpot, 2);
+
+    QVERIFY(result.offset.y() < 0);
+    QCOMPARE(result.image.width(), 80);
+
+    bool foundBadge = false;
+
+    for (int y = 0; y < -result.offset.y() && !foundBadge; ++y) {
+        for (int x = 0; x < result.image.width() && !foundBadge; ++x) {
+            foundBadge = (result.image.pixel(x, y) == QColor(Qt::blue).rgb());
+        }
+    }
+
+    QVERIFY(foundBadge);
+}
+
+void DragImageTest::testEmpty()
+{
+    DragImageComposer composer;
+
+    QVERIFY(composer.compose(QVector<DragImageComposer::Tile>(), QPoint(), 1).image.isNull());
+
+    // Nothing to draw but still more than one item: just the badge.
+    QVERIFY(!composer.compose(QVector<DragImageComposer::Tile>(), QPoint(), 5).image.isNull());
+}
+
+void DragImageTest::testModelDrag()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    for (int i = 0; i < 100; ++i) {
+        QFile file(dir.path() + QStringLiteral("/file%1.txt").arg(i, 3, 10, QLatin1Char('0')));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    FolderModel model;
+    model.setDragImageLimit(9);
+
+    QSignalSpy completed(&model, SIGNAL(listingCompleted()));
+    model.setUrl(dir.path());
+    QVERIFY(completed.wait(10000));
+    QCOMPARE(model.rowCount(), 100);
+
+    // What the delegates hand in when the selection is dragged.
+    model.setRangeSelected(0, 99);
+
+    const QVector<DragImageComposer::Tile> tiles = gridTiles(100);
+
+    for (int row = 0; row < tiles.count(); ++row) {
+        const QRect &rect = tiles.at(row).rect;
+        model.addItemDragImage(row, rect.x(), rect.y(), rect.width(), rect.height(), tiles.at(row).image);
+    }
+
+    // Row 45 is in the middle of the second line.
+    const QPoint hotSpot = tiles.at(45).rect.center();
+    DragImageComposer::Result result = model.composeDragImage(hotSpot.x(), hotSpot.y());
+
+    QVERIFY(!result.image.isNull());
+    QVERIFY(result.image.width() <= 5 * 100);
+    QVERIFY(result.image.height() <= 3 * 110);
+    QCOMPARE(result.image.pixel(hotSpot - result.offset), QColor(Qt::red).rgb());
+
+    // Deselected items drop their images and are left out of the drag.
+    model.toggleSelected(45);
+
+    result = model.composeDragImage(hotSpot.x(), hotSpot.y());
+    QVERIFY(!result.image.isNull());
+    QVERIFY(result.image.pixel(hotSpot - result.offset) != QColor(Qt::red).rgb());
+
+    model.clearSelection();
+    QVERIFY(model.composeDragImage(hotSpot.x(), hotSpot.y()).image.isNull());
+}
+
+void DragImageTest::benchmarkLargeSelection()
+{
+    DragImageComposer composer;
+    const QPoint hotSpot(20 * 100 + 40, 25 * 110 + 48);
+
+    QImage image;
+
+    QBENCHMARK {
+        image = composer.compose(m_tiles, hotSpot, s_selectionCount).image;
+    }
+
+    // The whole selection would be a 3980x5486 image.
+    QVERIFY(image.width() < 1000);
+    QVERIFY(image.height() < 1000);
+}
+
+QTEST_MAIN(DragImageTest)
+
+#include "dragimagetest.moc"
@@ -0,0 +1,207 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "foldermodel.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <climits>
+#include <cmath>
+
+// Counts how often the proxy compares two items.
+class CountingFolderModel : public FolderModel
+{
+    public:
+        explicit CountingFolderModel(QObject *parent = 0) : FolderModel(parent) {}
+
+        bool lessThan(const QModelIndex &left, const QModelIndex &right) const Q_DECL_OVERRIDE
+        {
+            ++comparisons;
+            return FolderModel::lessThan(left, right);
+        }
+
+        mutable qint64 comparisons = 0;
+};
+
+class InitialListingBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void testSortedOnCompletion();
+        void testUnsortedMode();
+        void testUrlChangedWhileListing();
+        void benchmarkInitialListing_data();
+        void benchmarkInitialListing();
+
+    private:
+        QTemporaryDir m_smallDir;
+        QTemporaryDir m_largeDirs[2];
+        static const int s_smallCount = 1000;
+        static const int s_largeCount = 50000;
+};
+
+// Files are created in a different order than they sort in.
+static bool populate(const QString &dir, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        QFile file(dir + QStringLiteral("/file%1.txt").arg((qint64(i) * 7919) % count));
+
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool isSorted(const FolderModel &model)
+{
+    for (int row = 1; row < model.rowCount(); ++row) {
+        if (model.lessThan(model.mapToSource(model.index(row, 0)), model.mapToSource(model.index(row - 1, 0)))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void InitialListingBenchmark::initTestCase()
+{
+    QVERIFY(m_smallDir.isValid());
+    QVERIFY(populate(m_smallDir.path(), s_smallCount));
+
+    // Listings are cached by the dir lister, so every run needs a
+    // folder of its own.
+    for (QTemporaryDir &dir : m_largeDirs) {
+        QVERIFY(dir.isValid());
+        QVERIFY(populate(dir.path(), s_largeCount));
+    }
+}
+
+void InitialListingBenchmark::testSortedOnCompletion()
+{
+    FolderModel model;
+    model.setDeferredSortThreshold(100);
+
+    QSignalSpy completed(&model, SIGNAL(listingCompleted()));
+    model.setUrl(m_smallDir.path());
+    QVERIFY(completed.wait(60000));
+
+    QCOMPARE(model.rowCount(), s_smallCount);
+    QVERIFY(model.dynamicSortFilter());
+    QVERIFY(isSorted(model));
+
+    // Later changes are sorted in right away again.
+    QFile file(m_smallDir.path() + QStringLiteral("/a.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    QTRY_COMPARE_WITH_TIMEOUT(model.rowCount(), s_smallCount + 1, 10000);
+    QVERIFY(isSorted(model));
+
+    QFile::remove(file.fileName());
+}
+
+void InitialListingBenchmark::testUnsortedMode()
+{
+    FolderModel model;
+    model.setSortMode(-1);
+    model.setDeferredSortThreshold(100);
+
+    QSignalSpy completed(&model, SIGNAL(listingCompleted()));
+    model.setUrl(m_smallDir.path());
+    QVERIFY(completed.wait(60000));
+
+    QCOMPARE(model.rowCount(), s_smallCount);
+    QVERIFY(!model.dynamicSortFilter());
+}
+
+void InitialListingBenchmark::testUrlChangedWhileListing()
+{
+    QTemporaryDir otherDir;
+    QVERIFY(otherDir.isValid());
+
+    FolderModel model;
+    model.setDeferredSortThreshold(100);
+
+    // Replacing a listing that is still going on cancels it.
+    model.setUrl(otherDir.path());
+    model.setUrl(m_smallDir.path());
+
+    QSignalSpy completed(&model, SIGNAL(listingCompleted()));
+    QSignalSpy layoutChanged(&model, SIGNAL(layoutChanged()));
+    QVERIFY(completed.wait(60000));
+
+    // The new listing was still deferred and sorted in one go.
+    QCOMPARE(model.rowCount(), s_smallCount);
+    QVERIFY(model.dynamicSortFilter());
+    QVERIFY(isSorted(model));
+    QVERIFY(!layoutChanged.isEmpty());
+}
+
+void InitialListingBenchmark::benchmarkInitialListing_data()
+{
+    QTest::addColumn<int>("dir");
+    QTest::addColumn<int>("threshold");
+
+    QTest::newRow("sorted as listed") << 0 << INT_MAX;
+    QTest::newRow("deferred sort") << 1 << 200;
+}
+
+void InitialListingBenchmark::benchmarkInitialListing()
+{
+    QFETCH(int, dir);
+    QFETCH(int, threshold);
+
+    CountingFolderModel model;
+    model.setDeferredSortThreshold(threshold);
+
+    QSignalSpy completed(&model, SIGNAL(listingCompleted()));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    model.setUrl(m_largeDirs[dir].path());
+    QVERIFY(completed.wait(120000));
+
+    const qint64 elapsed = timer.elapsed();
+    const qint64 comparisons = model.comparisons;
+    qDebug() << "comparisons:" << comparisons;
+
+    QCOMPARE(model.rowCount(), s_largeCount);
+    QVERIFY(isSorted(model));
+
+    // A deferred listing is sorted once, in O(n log n) comparisons,
+    // instead of every batch being sorted in as it arrives.
+    if (threshold < s_largeCount) {
+        const qint64 bound = 2 * qint64(s_largeCount) * qint64(std::ceil(std::log2(double(s_largeCount))));
+        QVERIFY2(comparisons <= bound, qPrintable(QStringLiteral("%1 comparisons, expected at most %2").arg(comparisons).arg(bound)));
+    }
+
+    QTest::setBenchmarkResult(elapsed, QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(InitialListingBenchmark)
+
+#include "initiallistingbenchmark.moc"
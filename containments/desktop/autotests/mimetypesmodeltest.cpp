@@ -0,0 +1,162 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "mimetypesmodel.h"
+
+#include <QCollator>
+#include <QMimeDatabase>
+#include <QtTest>
+
+#include <algorithm>
+
+class MimeTypesModelTest : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void testCatalog();
+        void testCheckedRoundTrip();
+        void testNothingChecked();
+        void testCheckAll();
+        void testFilteredRowChecked();
+        void benchmarkSettingsPage_data();
+        void benchmarkSettingsPage();
+};
+
+static QStringList names(const QAbstractItemModel &model)
+{
+    QStringList list;
+
+    for (int row = 0; row < model.rowCount(); ++row) {
+        list.append(model.index(row, 0).data().toString());
+    }
+
+    return list;
+}
+
+void MimeTypesModelTest::testCatalog()
+{
+    MimeTypesModel model;
+
+    QMimeDatabase db;
+    QCOMPARE(model.rowCount(), db.allMimeTypes().count());
+
+    const QStringList &list = names(model);
+    QCollator collator;
+
+    for (int i = 1; i < list.count(); ++i) {
+        QVERIFY2(collator.compare(list.at(i - 1), list.at(i)) <= 0, qPrintable(list.at(i)));
+    }
+
+    // A second model gets the same catalog.
+    MimeTypesModel other;
+    QCOMPARE(names(other), list);
+}
+
+void MimeTypesModelTest::testCheckedRoundTrip()
+{
+    MimeTypesModel model;
+    QSignalSpy changed(&model, SIGNAL(checkedTypesChanged()));
+
+    model.setCheckedTypes(QStringList() << QStringLiteral("text/plain") << QStringLiteral("image/png")
+        << QStringLiteral("no/such-type"));
+
+    QCOMPARE(changed.count(), 1);
+
+    // Unknown types are dropped, the rest comes back in catalog order.
+    QCOMPARE(model.checkedTypes(), QStringList() << QStringLiteral("image/png") << QStringLiteral("text/plain"));
+
+    const int row = names(model).indexOf(QStringLiteral("image/png"));
+    QCOMPARE(model.index(row, 0).data(Qt::CheckStateRole).toInt(), int(Qt::Checked));
+    QCOMPARE(model.index(row + 1, 0).data(Qt::CheckStateRole).toInt(), int(Qt::Unchecked));
+
+    model.setRowChecked(row, false);
+    QCOMPARE(model.checkedTypes(), QStringList() << QStringLiteral("text/plain"));
+
+    MimeTypesModel copy;
+    copy.setCheckedTypes(model.checkedTypes());
+    QCOMPARE(copy.checkedTypes(), model.checkedTypes());
+}
+
+void MimeTypesModelTest::testNothingChecked()
+{
+    MimeTypesModel model;
+
+    model.setCheckedTypes(QStringList());
+
+    // What the config ends up with when nothing is checked.
+    QCOMPARE(model.checkedTypes(), QStringList(QString()));
+
+    model.setCheckedTypes(model.checkedTypes());
+    QCOMPARE(model.checkedTypes(), QStringList(QString()));
+}
+
+void MimeTypesModelTest::testCheckAll()
+{
+    MimeTypesModel model;
+
+    model.checkAll();
+    QCOMPARE(model.checkedTypes(), names(model));
+}
+
+void MimeTypesModelTest::testFilteredRowChecked()
+{
+    FilterableMimeTypesModel model;
+    model.setFilter(QStringLiteral("image/png"));
+
+    QVERIFY(model.rowCount() >= 1);
+
+    const int row = names(model).indexOf(QStringLiteral("image/png"));
+    QVERIFY(row != -1);
+
+    model.setRowChecked(row, true);
+    QCOMPARE(model.checkedTypes(), QStringList() << QStringLiteral("image/png"));
+}
+
+void MimeTypesModelTest::benchmarkSettingsPage_data()
+{
+    QTest::addColumn<int>("checked");
+
+    QTest::newRow("none checked") << 0;
+    QTest::newRow("100 checked") << 100;
+    QTest::newRow("all checked") << -1;
+}
+
+void MimeTypesModelTest::benchmarkSettingsPage()
+{
+    QFETCH(int, checked);
+
+    QStringList checkedTypes = names(MimeTypesModel());
+
+    if (checked >= 0) {
+        checkedTypes = checkedTypes.mid(0, checked);
+    }
+
+    // Reversed, so looking the types up can't just walk the catalog along.
+    std::reverse(checkedTypes.begin(), checkedTypes.end());
+
+    QBENCHMARK {
+        FilterableMimeTypesModel model;
+        model.setCheckedTypes(checkedTypes);
+    }
+}
+
+QTEST_GUILESS_MAIN(MimeTypesModelTest)
+
+#include "mimetypesmodeltest.moc"
@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "itemviewadapter.h"
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QStandardItemModel>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <KDirLister>
+#include <KDirModel>
+#include <KDirSortFilterProxyModel>
+#include <KFilePreviewGenerator>
+
+// Stands in for the GridView of the folder view.
+class FakeGridView : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(qreal cellWidth READ cellWidth NOTIFY cellWidthChanged)
+    Q_PROPERTY(qreal cellHeight READ cellHeight NOTIFY cellHeightChanged)
+    Q_PROPERTY(int flow READ flow NOTIFY flowChanged)
+    Q_PROPERTY(qreal width READ width NOTIFY widthChanged)
+    Q_PROPERTY(qreal height READ height NOTIFY heightChanged)
+    Q_PROPERTY(int effectiveLayoutDirection READ effectiveLayoutDirection NOTIFY effectiveLayoutDirectionChanged)
+
+    public:
+        qreal cellWidth() const { return 100; }
+        qreal cellHeight() const { return 100; }
+        int flow() const { return 0; }
+        qreal width() const { return 800; }
+        qreal height() const { return 600; }
+        int effectiveLayoutDirection() const { return Qt::LeftToRight; }
+
+    Q_SIGNALS:
+        void cellWidthChanged() const;
+        void cellHeightChanged() const;
+        void flowChanged() const;
+        void widthChanged() const;
+        void heightChanged() const;
+        void effectiveLayoutDirectionChanged() const;
+};
+
+class PreviewSchedulingBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void testVisualRect();
+        void testLookAhead();
+        void benchmarkFirstVisiblePreview_data();
+        void benchmarkFirstVisiblePreview();
+
+    private:
+        QTemporaryDir m_dir;
+        static const int s_imageCount = 5000;
+};
+
+void PreviewSchedulingBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    QImage image(96, 96, QImage::Format_RGB32);
+
+    for (int i = 0; i < s_imageCount; ++i) {
+        image.fill(QColor::fromHsv(i % 360, 200, 200));
+        QVERIFY(image.save(m_dir.path() + QStringLiteral("/photo%1.jpg").arg(i, 5, 10, QLatin1Char('0'))));
+    }
+}
+
+void PreviewSchedulingBenchmark::testVisualRect()
+{
+    FakeGridView view;
+    QStandardItemModel model(20, 1);
+
+    ItemViewAdapter adapter;
+    adapter.setAdapterView(&view);
+    adapter.setAdapterModel(&model);
+
+    // Eight cells per line
+    QCOMPARE(adapter.visualRect(model.index(0, 0)), QRect(0, 0, 100, 100));
+    QCOMPARE(adapter.visualRect(model.index(7, 0)), QRect(700, 0, 100, 100));
+    QCOMPARE(adapter.visualRect(model.index(9, 0)), QRect(100, 100, 100, 100));
+    QCOMPARE(adapter.visualRect(QModelIndex()), QRect());
+
+    adapter.setAdapterView(nullptr);
+    QCOMPARE(adapter.visualRect(model.index(0, 0)), QRect());
+}
+
+void PreviewSchedulingBenchmark::testLookAhead()
+{
+    FakeGridView view;
+
+    ItemViewAdapter adapter;
+    adapter.setAdapterView(&view);
+
+    QSignalSpy scrolled(&adapter, SIGNAL(viewScrolled()));
+
+    adapter.setAdapterVisibleArea(QRect(0, 1000, 800, 600));
+    QCOMPARE(scrolled.count(), 1);
+    QCOMPARE(adapter.visibleArea(), QRect(0, 1000, 800, 600));
+
+    adapter.setAdapterLookAhead(300);
+    QCOMPARE(adapter.visibleArea(), QRect(0, 700, 800, 1200));
+}
+
+void PreviewSchedulingBenchmark::benchmarkFirstVisiblePreview_data()
+{
+    QTest::addColumn<bool>("layout");
+
+    QTest::newRow("directory order") << false;
+    QTest::newRow("viewport order") << true;
+}
+
+void PreviewSchedulingBenchmark::benchmarkFirstVisiblePreview()
+{
+    QFETCH(bool, layout);
+
+    KDirModel dirModel;
+    KDirSortFilterProxyModel proxyModel;
+    proxyModel.setSourceModel(&dirModel);
+    proxyModel.sort(0);
+
+    QSignalSpy completed(dirModel.dirLister(), SIGNAL(completed()));
+    dirModel.dirLister()->openUrl(QUrl::fromLocalFile(m_dir.path()));
+    QVERIFY(completed.wait(60000));
+    QCOMPARE(proxyModel.rowCount(), s_imageCount);
+
+    FakeGridView view;
+
+    ItemViewAdapter adapter;
+    adapter.setAdapterModel(&proxyModel);
+    adapter.setAdapterIconSize(64);
+
+    if (layout) {
+        adapter.setAdapterView(&view);
+    }
+
+    // Tells where items end up on screen, whatever the generator was told.
+    ItemViewAdapter grid;
+    grid.setAdapterModel(&proxyModel);
+    grid.setAdapterView(&view);
+
+    // Scrolled far down, directory order reaches these last.
+    const QRect visibleArea(0, 50000, 800, 600);
+    adapter.setAdapterVisibleArea(visibleArea);
+
+    QElapsedTimer timer;
+    qint64 firstVisible = -1;
+
+    connect(&proxyModel, &QAbstractItemModel::dataChanged, this,
+        [&](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles) {
+            if (firstVisible != -1 || (!roles.isEmpty() && !roles.contains(Qt::DecorationRole))) {
+                return;
+            }
+
+            for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                if (grid.visualRect(proxyModel.index(row, 0)).intersects(visibleArea)) {
+                    firstVisible = timer.elapsed();
+                    break;
+                }
+            }
+        });
+
+    timer.start();
+
+    KFilePreviewGenerator generator(&adapter, &proxyModel);
+    generator.setPreviewShown(true);
+    generator.updateIcons();
+
+    QTRY_VERIFY_WITH_TIMEOUT(firstVisible != -1 || timer.elapsed() > 120000, 125000);
+
+    if (firstVisible == -1) {
+        QSKIP("No previews were generated, is the image thumbnailer installed?");
+    }
+
+    QTest::setBenchmarkResult(firstVisible, QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(PreviewSchedulingBenchmark)
+
+#include "previewschedulingbenchmark.moc"
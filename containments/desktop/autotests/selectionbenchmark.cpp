@@ -0,0 +1,187 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "foldermodel.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class SelectionBenchmark : public QObject
+{
+    Q_OBJECT
+
+    private Q_SLOTS:
+        void initTestCase();
+        void cleanup();
+        void testSelectionForRows();
+        void testDataChangedGroups();
+        void testToggle();
+        void benchmarkRubberBandSweep_data();
+        void benchmarkRubberBandSweep();
+
+    private:
+        QTemporaryDir m_dir;
+        FolderModel *m_model = nullptr;
+        static const int s_fileCount = 10000;
+        static const int s_columns = 100;
+};
+
+// The rows a rubber band covering the given number of columns and lines
+// selects on a grid with s_columns icons per line.
+static QVariantList rubberBandRows(int columns, int lines, int columnCount)
+{
+    QVariantList rows;
+
+    for (int line = 0; line < lines; ++line) {
+        for (int column = 0; column < columns; ++column) {
+            rows.append(line * columnCount + column);
+        }
+    }
+
+    return rows;
+}
+
+void SelectionBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    for (int i = 0; i < s_fileCount; ++i) {
+        QFile file(m_dir.path() + QStringLiteral("/file%1.txt").arg(i, 5, 10, QLatin1Char('0')));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    m_model = new FolderModel(this);
+
+    QSignalSpy completed(m_model, SIGNAL(listingCompleted()));
+    m_model->setUrl(m_dir.path());
+    QVERIFY(completed.wait(60000));
+    QCOMPARE(m_model->rowCount(), s_fileCount);
+}
+
+void SelectionBenchmark::cleanup()
+{
+    m_model->clearSelection();
+    m_model->unpinSelection();
+}
+
+void SelectionBenchmark::testSelectionForRows()
+{
+    const QItemSelection selection = m_model->selectionForRows(QVector<int>{20, 5, 3, 4, 11, 10, 4});
+
+    QCOMPARE(selection.count(), 3);
+    QCOMPARE(selection.at(0).top(), 3);
+    QCOMPARE(selection.at(0).bottom(), 5);
+    QCOMPARE(selection.at(1).top(), 10);
+    QCOMPARE(selection.at(1).bottom(), 11);
+    QCOMPARE(selection.at(2).top(), 20);
+    QCOMPARE(selection.at(2).bottom(), 20);
+
+    QVERIFY(m_model->selectionForRows(QVector<int>()).isEmpty());
+}
+
+void SelectionBenchmark::testDataChangedGroups()
+{
+    QSignalSpy changed(m_model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    // Ten lines of ten icons.
+    m_model->updateSelection(rubberBandRows(10, 10, s_columns), false);
+
+    QCOMPARE(changed.count(), 10);
+
+    for (int i = 0; i < changed.count(); ++i) {
+        const QList<QVariant> &arguments = changed.at(i);
+        QCOMPARE(arguments.at(0).toModelIndex().row(), i * s_columns);
+        QCOMPARE(arguments.at(1).toModelIndex().row(), i * s_columns + 9);
+        QCOMPARE(arguments.at(2).value<QVector<int> >(), QVector<int>() << FolderModel::SelectedRole);
+    }
+
+    QVERIFY(m_model->isSelected(909));
+    QVERIFY(!m_model->isSelected(910));
+
+    // Growing the band by a column only touches the new column.
+    changed.clear();
+    m_model->updateSelection(rubberBandRows(11, 10, s_columns), false);
+
+    QCOMPARE(changed.count(), 10);
+
+    for (int i = 0; i < changed.count(); ++i) {
+        QCOMPARE(changed.at(i).at(0).toModelIndex().row(), i * s_columns + 10);
+        QCOMPARE(changed.at(i).at(1).toModelIndex().row(), i * s_columns + 10);
+    }
+
+    // Negative rows reject the whole update, like before.
+    changed.clear();
+    m_model->updateSelection(QVariantList() << 1 << -1, false);
+    QCOMPARE(changed.count(), 0);
+}
+
+void SelectionBenchmark::testToggle()
+{
+    m_model->updateSelection(QVariantList() << 0 << 1 << 2, false);
+    m_model->pinSelection();
+
+    m_model->updateSelection(QVariantList() << 2 << 3, true);
+
+    QVERIFY(m_model->isSelected(0));
+    QVERIFY(m_model->isSelected(1));
+    QVERIFY(!m_model->isSelected(2));
+    QVERIFY(m_model->isSelected(3));
+}
+
+void SelectionBenchmark::benchmarkRubberBandSweep_data()
+{
+    QTest::addColumn<bool>("toggle");
+
+    QTest::newRow("replace") << false;
+    QTest::newRow("toggle") << true;
+}
+
+void SelectionBenchmark::benchmarkRubberBandSweep()
+{
+    QFETCH(bool, toggle);
+
+    // Dragging from the top left corner to the bottom right one and back,
+    // over every icon of the desktop.
+    const int lines = s_fileCount / s_columns;
+    QVector<QVariantList> steps;
+
+    for (int step = 1; step <= 50; ++step) {
+        steps.append(rubberBandRows(step * s_columns / 50, step * lines / 50, s_columns));
+    }
+
+    for (int step = 49; step >= 1; --step) {
+        steps.append(steps.at(step - 1));
+    }
+
+    if (toggle) {
+        m_model->updateSelection(rubberBandRows(s_columns, 1, s_columns), false);
+        m_model->pinSelection();
+    }
+
+    QBENCHMARK {
+        foreach (const QVariantList &rows, steps) {
+            m_model->updateSelection(rows, toggle);
+        }
+    }
+}
+
+QTEST_MAIN(SelectionBenchmark)
+
+#include "selectionbenchmark.moc"
@@ -1141,10 +1141,11 @@ Item {
             adapterView: gridView
             adapterModel: positioner
             adapterIconSize: gridView.iconSize;
-            adapterVisibleArea: Qt.rect(gridView.contentX, gridView.contentY, gridView.contentWidth, gridView.contentHeight)
+            adapterVisibleArea: Qt.rect(gridView.contentX, gridView.contentY, gridView.width, gridView.height)
+            // Half a page ahead in either scroll direction.
+            adapterLookAhead: ((gridView.flow == GridView.FlowLeftToRight) ? gridView.height : gridView.width) / 2
 
             Component.onCompleted: {
-                gridView.movementStarted.connect(viewAdapter.viewScrolled);
                 dir.viewAdapter = viewAdapter;
             }
         }
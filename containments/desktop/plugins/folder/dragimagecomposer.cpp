@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "dragimagecomposer.h"
+
+#include <QFontMetrics>
+#include <QPainter>
+
+#include <algorithm>
+
+DragImageComposer::DragImageComposer()
+: m_limit(32)
+, m_badgeBackground(Qt::black)
+, m_badgeText(Qt::white)
+{
+    m_badgeFont.setBold(true);
+}
+
+void DragImageComposer::setLimit(int limit)
+{
+    m_limit = qMax(1, limit);
+}
+
+void DragImageComposer::setBadgeColors(const QColor &background, const QColor &text)
+{
+    m_badgeBackground = background;
+    m_badgeText = text;
+}
+
+void DragImageComposer::setBadgeFont(const QFont &font)
+{
+    m_badgeFont = font;
+    m_badgeFont.setBold(true);
+}
+
+DragImageComposer::Result DragImageComposer::compose(QVector<Tile> tiles, const QPoint &hotSpot, int count) const
+{
+    Result result;
+
+    if (tiles.count() > m_limit) {
+        auto closer = [&hotSpot](const Tile &a, const Tile &b) {
+            return (a.rect.center() - hotSpot).manhattanLength() < (b.rect.center() - hotSpot).manhattanLength();
+        };
+
+        std::partial_sort(tiles.begin(), tiles.begin() + m_limit, tiles.end(), closer);
+        tiles.resize(m_limit);
+    }
+
+    QRect rect;
+
+    foreach (const Tile &tile, tiles) {
+        rect |= tile.rect;
+    }
+
+    QString badgeText;
+    QRect badgeRect;
+
+    if (count > 1) {
+        badgeText = QString::number(count);
+
+        const QFontMetrics metrics(m_badgeFont);
+        const int height = metrics.height() + 4;
+        const int width = qMax(height, metrics.width(badgeText) + height / 2);
+
+        // Above and to the right of the hot spot, where the cursor doesn't cover it.
+        badgeRect = QRect(hotSpot.x() + 4, hotSpot.y() - height - 4, width, height);
+        rect |= badgeRect;
+    }
+
+    if (rect.isEmpty()) {
+        return result;
+    }
+
+    QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+
+    foreach (const Tile &tile, tiles) {
+        painter.drawImage(tile.rect.topLeft() - rect.topLeft(), tile.image);
+    }
+
+    if (!badgeText.isEmpty()) {
+        const QRect badge = badgeRect.translated(-rect.topLeft());
+
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(m_badgeBackground);
+        painter.drawRoundedRect(badge, badge.height() / 2.0, badge.height() / 2.0);
+
+        painter.setFont(m_badgeFont);
+        painter.setPen(m_badgeText);
+        painter.drawText(badge, Qt::AlignCenter, badgeText);
+    }
+
+    painter.end();
+
+    result.image = image;
+    result.offset = rect.topLeft();
+
+    return result;
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by The KDE Project                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#ifndef DRAGIMAGECOMPOSER_H
+#define DRAGIMAGECOMPOSER_H
+
+#include <QColor>
+#include <QFont>
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+// Puts the images of the delegates being dragged together into a single
+// drag image. Only works on QImage, so it may run in a worker thread.
+class DragImageComposer
+{
+    public:
+        struct Tile {
+            QRect rect;
+            QImage image;
+        };
+
+        struct Result {
+            QImage image;
+            // Where the top left corner of the image is in view coordinates.
+            QPoint offset;
+        };
+
+        DragImageComposer();
+
+        // At most this many tiles, the ones closest to the hot spot, are drawn.
+        int limit() const { return m_limit; }
+        void setLimit(int limit);
+
+        void setBadgeColors(const QColor &background, const QColor &text);
+        void setBadgeFont(const QFont &font);
+
+        // When more than one item is dragged, a badge with their count is
+        // drawn next to the hot spot.
+        Result compose(QVector<Tile> tiles, const QPoint &hotSpot, int count) const;
+
+    private:
+        int m_limit;
+        QColor m_badgeBackground;
+        QColor m_badgeText;
+        QFont m_badgeFont;
+};
+
+#endif
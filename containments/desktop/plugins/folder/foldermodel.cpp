@@ -75,6 +75,29 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+typedef QPair<int, int> RowSpan;
+
+// Sorts spans of rows and merges the ones that overlap or touch, so
+// a set of rows turns into as few ranges as possible.
+static QVector<RowSpan> mergedSpans(QVector<RowSpan> spans)
+{
+    std::sort(spans.begin(), spans.end());
+
+    QVector<RowSpan> merged;
+
+    foreach (const RowSpan &span, spans) {
+        if (!merged.isEmpty() && span.first <= merged.last().second + 1) {
+            merged.last().second = qMax(merged.last().second, span.second);
+        } else {
+            merged.append(span);
+        }
+    }
+
+    return merged;
+}
+
 DirLister::DirLister(QObject *parent) : KDirLister(parent)
 {
 }
@@ -105,6 +128,8 @@ FolderModel::FolderModel(QObject *parent) : QSortFilterProxyModel(parent),
     m_usedByContainment(false),
     m_locked(true),
     m_sortMode(0),
+    m_deferredSortThreshold(200),
+    m_initialListing(false),
     m_sortDesc(false),
     m_sortDirsFirst(true),
     m_parseDesktopFiles(false),
@@ -120,9 +145,13 @@ FolderModel::FolderModel(QObject *parent) : QSortFilterProxyModel(parent),
     connect(dirLister, &DirLister::error, this, &FolderModel::dirListFailed);
     connect(dirLister, &KCoreDirLister::itemsDeleted, this, &FolderModel::evictFromIsDirCache);
     connect(dirLister, &KCoreDirLister::started, this, &FolderModel::listingStarted);
+    // Connected before the dir model gets to see the new items.
+    connect(dirLister, &KCoreDirLister::itemsAdded, this, &FolderModel::deferSortIfLarge);
     void (KCoreDirLister::*myCompletedSignal)() = &KCoreDirLister::completed;
+    QObject::connect(dirLister, myCompletedSignal, this, &FolderModel::finishInitialListing);
     QObject::connect(dirLister, myCompletedSignal, this, &FolderModel::listingCompleted);
     void (KCoreDirLister::*myCanceledSignal)() = &KCoreDirLister::canceled;
+    QObject::connect(dirLister, myCanceledSignal, this, &FolderModel::finishInitialListing);
     QObject::connect(dirLister, myCanceledSignal, this, &FolderModel::listingCanceled);
 
     m_dirModel = new KDirModel(this);
@@ -135,6 +164,14 @@ FolderModel::FolderModel(QObject *parent) : QSortFilterProxyModel(parent),
 
     setSourceModel(m_dirModel);
 
+    // Delegate images are kept around for as long as there is a selection,
+    // so they need to move along with their items.
+    connect(this, &QAbstractItemModel::rowsInserted, this, &FolderModel::updateDragImageRows);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, &FolderModel::updateDragImageRows);
+    connect(this, &QAbstractItemModel::rowsMoved, this, &FolderModel::updateDragImageRows);
+    connect(this, &QAbstractItemModel::layoutChanged, this, &FolderModel::updateDragImageRows);
+    connect(this, &QAbstractItemModel::modelReset, this, &FolderModel::clearDragImages);
+
     setSortLocaleAware(true);
     setFilterCaseSensitivity(Qt::CaseInsensitive);
     setDynamicSortFilter(true);
@@ -148,6 +185,7 @@ FolderModel::FolderModel(QObject *parent) : QSortFilterProxyModel(parent),
 
 FolderModel::~FolderModel()
 {
+    clearDragImages();
 }
 
 QHash< int, QByteArray > FolderModel::roleNames() const
@@ -191,7 +229,9 @@ void FolderModel::setUrl(const QString& url)
     beginResetModel();
     m_url = url;
     m_isDirCache.clear();
-    m_dirModel->dirLister()->openUrl(resolvedUrl);
+    // Opening the new URL cancels the listing of the old one right away,
+    // which would end the new initial listing if it had begun already.
+    m_initialListing = m_dirModel->dirLister()->openUrl(resolvedUrl);
     clearDragImages();
     m_dragIndexes.clear();
     endResetModel();
@@ -259,6 +299,20 @@ bool FolderModel::dragging() const
     return m_dragInProgress;
 }
 
+int FolderModel::dragImageLimit() const
+{
+    return m_dragImageComposer.limit();
+}
+
+void FolderModel::setDragImageLimit(int limit)
+{
+    if (m_dragImageComposer.limit() != limit) {
+        m_dragImageComposer.setLimit(limit);
+
+        emit dragImageLimitChanged();
+    }
+}
+
 bool FolderModel::usedByContainment() const
 {
     return m_usedByContainment;
@@ -322,6 +376,45 @@ void FolderModel::setSortMode(int mode)
     }
 }
 
+int FolderModel::deferredSortThreshold() const
+{
+    return m_deferredSortThreshold;
+}
+
+void FolderModel::setDeferredSortThreshold(int threshold)
+{
+    if (m_deferredSortThreshold != threshold) {
+        m_deferredSortThreshold = threshold;
+
+        emit deferredSortThresholdChanged();
+    }
+}
+
+void FolderModel::deferSortIfLarge()
+{
+    // The first screenful of items is sorted as it comes in, so it can be
+    // shown right away. The rest is appended as is, rather than inserting
+    // every batch at its sorted position and emitting a signal for each
+    // insertion point, and sorted in one go once the listing completes.
+    if (m_initialListing && dynamicSortFilter() && m_dirModel->rowCount() >= m_deferredSortThreshold) {
+        setDynamicSortFilter(false);
+    }
+}
+
+void FolderModel::finishInitialListing()
+{
+    if (!m_initialListing) {
+        return;
+    }
+
+    m_initialListing = false;
+
+    if (m_sortMode != -1 /* Unsorted */ && !dynamicSortFilter()) {
+        // Sorts everything and emits a single layout change.
+        setDynamicSortFilter(true);
+    }
+}
+
 bool FolderModel::sortDesc() const
 {
     return m_sortDesc;
@@ -662,30 +755,51 @@ void FolderModel::setRangeSelected(int anchor, int to)
 
 void FolderModel::updateSelection(const QVariantList &rows, bool toggle)
 {
-    QItemSelection newSelection;
-
-    int iRow = -1;
+    QVector<int> iRows;
+    iRows.reserve(rows.count());
 
     foreach (const QVariant &row, rows) {
-        iRow = row.toInt();
+        const int iRow = row.toInt();
 
         if (iRow < 0) {
             return;
         }
 
-        const QModelIndex &idx = index(iRow, 0);
-        newSelection.select(idx, idx);
+        iRows.append(iRow);
     }
 
+    updateSelection(selectionForRows(iRows), toggle);
+}
+
+void FolderModel::updateSelection(const QItemSelection &selection, bool toggle)
+{
     if (toggle) {
         QItemSelection pinnedSelection = m_pinnedSelection;
-        pinnedSelection.merge(newSelection, QItemSelectionModel::Toggle);
+        pinnedSelection.merge(selection, QItemSelectionModel::Toggle);
         m_selectionModel->select(pinnedSelection, QItemSelectionModel::ClearAndSelect);
     } else {
-        m_selectionModel->select(newSelection, QItemSelectionModel::ClearAndSelect);
+        m_selectionModel->select(selection, QItemSelectionModel::ClearAndSelect);
     }
 }
 
+QItemSelection FolderModel::selectionForRows(const QVector<int> &rows) const
+{
+    QVector<RowSpan> spans;
+    spans.reserve(rows.count());
+
+    foreach (int row, rows) {
+        spans.append(RowSpan(row, row));
+    }
+
+    QItemSelection selection;
+
+    foreach (const RowSpan &span, mergedSpans(spans)) {
+        selection.append(QItemSelectionRange(index(span.first, 0), index(span.second, 0)));
+    }
+
+    return selection;
+}
+
 void FolderModel::clearSelection()
 {
     if (m_selectionModel->hasSelection()) {
@@ -713,9 +827,9 @@ void FolderModel::addItemDragImage(int row, int x, int y, int width, int height,
 
     DragImage *dragImage = new DragImage();
     dragImage->row = row;
+    dragImage->index = index(row, 0);
     dragImage->rect = QRect(x, y, width, height);
     dragImage->image = image.value<QImage>();
-    dragImage->blank = false;
 
     m_dragImages.insert(row, dragImage);
 }
@@ -746,48 +860,83 @@ QPoint FolderModel::dragCursorOffset(int row)
     return m_dragImages.value(row)->cursorOffset;
 }
 
-void FolderModel::addDragImage(QDrag *drag, int x, int y)
+void FolderModel::updateDragImageRows()
 {
-    if (!drag || m_dragImages.isEmpty()) {
+    if (m_dragImages.isEmpty()) {
         return;
     }
 
-    QRegion region;
+    QHash<int, DragImage *> dragImages;
 
     foreach (DragImage *image, m_dragImages) {
-        image->blank = isBlank(image->row);
-        image->rect.translate(-m_dragHotSpotScrollOffset.x(), -m_dragHotSpotScrollOffset.y());
-        if (!image->blank && !image->image.isNull()) {
-            region = region.united(image->rect);
+        if (image->index.isValid()) {
+            image->row = image->index.row();
+            dragImages.insert(image->row, image);
+        } else {
+            delete image;
         }
     }
 
-    QRect rect = region.boundingRect();
-    QPoint offset = rect.topLeft();
-    rect.translate(-offset.x(), -offset.y());
+    m_dragImages = dragImages;
+}
 
-    QImage dragImage(rect.size(), QImage::Format_RGBA8888);
-    dragImage.fill(Qt::transparent);
+QVector<DragImageComposer::Tile> FolderModel::dragImageTiles() const
+{
+    QVector<DragImageComposer::Tile> tiles;
 
-    QPainter painter(&dragImage);
+    foreach (DragImage *image, m_dragImages) {
+        if (image->image.isNull() || !m_selectionModel->isSelected(index(image->row, 0))) {
+            continue;
+        }
 
-    QPoint pos;
+        tiles.append(DragImageComposer::Tile{image->rect.translated(-m_dragHotSpotScrollOffset), image->image});
+    }
+
+    return tiles;
+}
+
+int FolderModel::selectedCount() const
+{
+    int count = 0;
+
+    foreach (const QItemSelectionRange &range, m_selectionModel->selection()) {
+        count += range.height();
+    }
+
+    return count;
+}
+
+DragImageComposer::Result FolderModel::composeDragImage(int x, int y)
+{
+    m_dragImageComposer.setBadgeColors(QApplication::palette().color(QPalette::Highlight),
+        QApplication::palette().color(QPalette::HighlightedText));
+    m_dragImageComposer.setBadgeFont(QApplication::font());
+
+    // Bounded by the item limit, so this is cheap enough to do right
+    // before the drag starts.
+    return m_dragImageComposer.compose(dragImageTiles(), QPoint(x, y), selectedCount());
+}
+
+void FolderModel::addDragImage(QDrag *drag, int x, int y)
+{
+    if (!drag || m_dragImages.isEmpty()) {
+        return;
+    }
+
+    const QPoint hotSpot(x, y);
 
     foreach (DragImage *image, m_dragImages) {
-        if (!image->blank && !image->image.isNull()) {
-            pos = image->rect.translated(-offset.x(), -offset.y()).topLeft();
-            image->cursorOffset.setX(pos.x() - (x - offset.x()));
-            image->cursorOffset.setY(pos.y() - (y - offset.y()));
+        image->cursorOffset = image->rect.translated(-m_dragHotSpotScrollOffset).topLeft() - hotSpot;
+    }
 
-            painter.drawImage(pos, image->image);
-        }
+    const DragImageComposer::Result result = composeDragImage(x, y);
 
-        // FIXME HACK: Operate on copy.
-        image->rect.translate(m_dragHotSpotScrollOffset.x(), m_dragHotSpotScrollOffset.y());
+    if (result.image.isNull()) {
+        return;
     }
 
-    drag->setPixmap(QPixmap::fromImage(dragImage));
-    drag->setHotSpot(QPoint(x - offset.x(), y - offset.y()));
+    drag->setPixmap(QPixmap::fromImage(result.image));
+    drag->setHotSpot(hotSpot - result.offset);
 }
 
 void FolderModel::dragSelected(int x, int y)
@@ -825,10 +974,10 @@ void FolderModel::dragSelectedInternal(int x, int y)
 
     m_dragIndexes = m_selectionModel->selectedIndexes();
 
-    qSort(m_dragIndexes.begin(), m_dragIndexes.end());
+    // Kept sorted for the lookups in data().
+    std::sort(m_dragIndexes.begin(), m_dragIndexes.end());
 
-    // TODO: Optimize to emit contiguous groups.
-    emit dataChanged(m_dragIndexes.first(), m_dragIndexes.last(), QVector<int>() << BlankRole);
+    emitDataChangedForIndexes(m_dragIndexes, QVector<int>() << BlankRole);
 
     QModelIndexList sourceDragIndexes;
 
@@ -854,11 +1003,9 @@ void FolderModel::dragSelectedInternal(int x, int y)
     m_urlChangedWhileDragging = false;
 
     if (m_dirModel->dirLister()->url() == currentUrl) {
-        const QModelIndex first(m_dragIndexes.first());
-        const QModelIndex last(m_dragIndexes.last());
+        const QModelIndexList dragIndexes = m_dragIndexes;
         m_dragIndexes.clear();
-        // TODO: Optimize to emit contiguous groups.
-        emit dataChanged(first, last, QVector<int>() << BlankRole);
+        emitDataChangedForIndexes(dragIndexes, QVector<int>() << BlankRole);
     }
 }
 
@@ -999,27 +1146,56 @@ void FolderModel::dropCwd(QObject* dropEvent)
     }
 }
 
+void FolderModel::emitDataChangedForIndexes(const QModelIndexList &indexes, const QVector<int> &roles)
+{
+    QVector<RowSpan> spans;
+    spans.reserve(indexes.count());
+
+    foreach (const QModelIndex &index, indexes) {
+        spans.append(RowSpan(index.row(), index.row()));
+    }
+
+    emitDataChangedForSpans(spans, roles);
+}
+
+void FolderModel::emitDataChangedForSpans(const QVector<QPair<int, int> > &spans, const QVector<int> &roles)
+{
+    foreach (const RowSpan &span, mergedSpans(spans)) {
+        emit dataChanged(index(span.first, 0), index(span.second, 0), roles);
+    }
+}
+
 void FolderModel::selectionChanged(QItemSelection selected, QItemSelection deselected)
 {
-    QModelIndexList indices = selected.indexes();
-    indices.append(deselected.indexes());
+    // Both only ever change the selected state, so rows that got selected
+    // and rows next to them that got deselected can share a signal.
+    QVector<RowSpan> spans;
+    spans.reserve(selected.count() + deselected.count());
 
-    QVector<int> roles;
-    roles.append(SelectedRole);
+    foreach (const QItemSelectionRange &range, selected) {
+        spans.append(RowSpan(range.top(), range.bottom()));
+    }
 
-    foreach(const QModelIndex index, indices) {
-        emit dataChanged(index, index, roles);
+    foreach (const QItemSelectionRange &range, deselected) {
+        spans.append(RowSpan(range.top(), range.bottom()));
     }
 
+    emitDataChangedForSpans(spans, QVector<int>() << SelectedRole);
+
     if (!m_selectionModel->hasSelection()) {
         clearDragImages();
-    } else {
-        foreach (const QModelIndex &idx, deselected.indexes()) {
-            if (m_dragImages.contains(idx.row())) {
-                DragImage *image = m_dragImages.value(idx.row());
-                delete image;
-                m_dragImages.remove(idx.row());
-            }
+        return;
+    }
+
+    // Delegates grab themselves again once they are reselected.
+    QHash<int, DragImage *>::iterator it = m_dragImages.begin();
+
+    while (it != m_dragImages.end()) {
+        if (deselected.contains(index(it.key(), 0))) {
+            delete it.value();
+            it = m_dragImages.erase(it);
+        } else {
+            ++it;
         }
     }
 }
@@ -1040,7 +1216,7 @@ QVariant FolderModel::data(const QModelIndex& index, int role) const
     }
 
     if (role == BlankRole) {
-        return m_dragIndexes.contains(index);
+        return std::binary_search(m_dragIndexes.constBegin(), m_dragIndexes.constEnd(), index);
     } else if (role == OverlaysRole) {
         const KFileItem item = itemForIndex(index);
         return item.overlays();
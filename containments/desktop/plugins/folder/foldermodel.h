@@ -30,6 +30,8 @@
 #include <QSet>
 #include <QRegExp>
 
+#include "dragimagecomposer.h"
+
 #include <KAbstractViewAdapter>
 #include <KActionCollection>
 #include <KFilePreviewGenerator>
@@ -78,9 +80,11 @@ class FolderModel : public QSortFilterProxyModel
     Q_PROPERTY(QUrl resolvedUrl READ resolvedUrl NOTIFY resolvedUrlChanged)
     Q_PROPERTY(QString errorString READ errorString NOTIFY errorStringChanged)
     Q_PROPERTY(bool dragging READ dragging NOTIFY draggingChanged)
+    Q_PROPERTY(int dragImageLimit READ dragImageLimit WRITE setDragImageLimit NOTIFY dragImageLimitChanged)
     Q_PROPERTY(bool usedByContainment READ usedByContainment WRITE setUsedByContainment NOTIFY usedByContainmentChanged)
     Q_PROPERTY(bool locked READ locked WRITE setLocked NOTIFY lockedChanged)
     Q_PROPERTY(int sortMode READ sortMode WRITE setSortMode NOTIFY sortModeChanged)
+    Q_PROPERTY(int deferredSortThreshold READ deferredSortThreshold WRITE setDeferredSortThreshold NOTIFY deferredSortThresholdChanged)
     Q_PROPERTY(bool sortDesc READ sortDesc WRITE setSortDesc NOTIFY sortDescChanged)
     Q_PROPERTY(bool sortDirsFirst READ sortDirsFirst WRITE setSortDirsFirst NOTIFY sortDirsFirstChanged)
     Q_PROPERTY(bool parseDesktopFiles READ parseDesktopFiles WRITE setParseDesktopFiles NOTIFY parseDesktopFilesChanged)
@@ -131,6 +135,9 @@ class FolderModel : public QSortFilterProxyModel
 
         bool dragging() const;
 
+        int dragImageLimit() const;
+        void setDragImageLimit(int limit);
+
         bool usedByContainment() const;
         void setUsedByContainment(bool used);
 
@@ -140,6 +147,11 @@ class FolderModel : public QSortFilterProxyModel
         int sortMode() const;
         void setSortMode(int mode);
 
+        // While a folder is first listed, items past this many are only
+        // sorted once the listing has completed.
+        int deferredSortThreshold() const;
+        void setDeferredSortThreshold(int threshold);
+
         bool sortDesc() const;
         void setSortDesc(bool desc);
 
@@ -184,6 +196,9 @@ class FolderModel : public QSortFilterProxyModel
         Q_INVOKABLE void toggleSelected(int row);
         Q_INVOKABLE void setRangeSelected(int anchor, int to);
         Q_INVOKABLE void updateSelection(const QVariantList &rows, bool toggle);
+        void updateSelection(const QItemSelection &selection, bool toggle);
+        // Builds a selection with one range per run of consecutive rows.
+        QItemSelection selectionForRows(const QVector<int> &rows) const;
         Q_INVOKABLE void clearSelection();
         Q_INVOKABLE void pinSelection();
         Q_INVOKABLE void unpinSelection();
@@ -193,6 +208,8 @@ class FolderModel : public QSortFilterProxyModel
         Q_INVOKABLE void setDragHotSpotScrollOffset(int x, int y); // FIXME TODO: Propify.
         Q_INVOKABLE QPoint dragCursorOffset(int row);
         Q_INVOKABLE void dragSelected(int x, int y);
+        // The image a drag of the selection started at x, y shows.
+        DragImageComposer::Result composeDragImage(int x, int y);
         Q_INVOKABLE void drop(QQuickItem *target, QObject *dropEvent, int row);
         Q_INVOKABLE void dropCwd(QObject *dropEvent);
 
@@ -228,9 +245,11 @@ class FolderModel : public QSortFilterProxyModel
         void resolvedUrlChanged() const;
         void errorStringChanged() const;
         void draggingChanged() const;
+        void dragImageLimitChanged() const;
         void usedByContainmentChanged() const;
         void lockedChanged() const;
         void sortModeChanged() const;
+        void deferredSortThresholdChanged() const;
         void sortDescChanged() const;
         void sortDirsFirstChanged() const;
         void parseDesktopFilesChanged() const;
@@ -264,15 +283,23 @@ class FolderModel : public QSortFilterProxyModel
     private:
         struct DragImage {
             int row;
+            // Follows the item around when rows are inserted, removed or sorted.
+            QPersistentModelIndex index;
             QRect rect;
             QPoint cursorOffset;
             QImage image;
-            bool blank;
         };
 
         void createActions();
         void updatePasteAction();
         void addDragImage(QDrag *drag, int x, int y);
+        void deferSortIfLarge();
+        void finishInitialListing();
+        void updateDragImageRows();
+        QVector<DragImageComposer::Tile> dragImageTiles() const;
+        int selectedCount() const;
+        void emitDataChangedForIndexes(const QModelIndexList &indexes, const QVector<int> &roles);
+        void emitDataChangedForSpans(const QVector<QPair<int, int> > &spans, const QVector<int> &roles);
         QList<QUrl> selectedUrls(bool forTrash) const;
         KDirModel *m_dirModel;
         KDirWatch *m_dirWatch;
@@ -282,6 +309,7 @@ class FolderModel : public QSortFilterProxyModel
         QItemSelection m_pinnedSelection;
         QModelIndexList m_dragIndexes;
         QHash<int, DragImage *> m_dragImages;
+        DragImageComposer m_dragImageComposer;
         QPoint m_dragHotSpotScrollOffset;
         bool m_dragInProgress;
         bool m_urlChangedWhileDragging;
@@ -295,6 +323,8 @@ class FolderModel : public QSortFilterProxyModel
         bool m_usedByContainment;
         bool m_locked;
         int m_sortMode; // FIXME TODO: Enumify.
+        int m_deferredSortThreshold;
+        bool m_initialListing;
         bool m_sortDesc;
         bool m_sortDirsFirst;
         bool m_parseDesktopFiles;
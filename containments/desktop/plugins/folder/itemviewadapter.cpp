@@ -18,15 +18,25 @@
  */
 
 #include "itemviewadapter.h"
+#include "positioner.h"
 
 #include <QModelIndex>
 #include <QPalette>
 #include <QSize>
 
+#include <cmath>
+
 ItemViewAdapter::ItemViewAdapter(QObject *parent) : KAbstractViewAdapter(parent),
     m_adapterView(0),
     m_adapterModel(0),
-    m_adapterIconSize(-1)
+    m_adapterIconSize(-1),
+    m_adapterLookAhead(0),
+    m_cellWidth(0),
+    m_cellHeight(0),
+    m_viewWidth(0),
+    m_viewHeight(0),
+    m_flowTopToBottom(false),
+    m_rightToLeft(false)
 {
 }
 
@@ -47,16 +57,61 @@ QPalette ItemViewAdapter::palette() const
 
 QRect ItemViewAdapter::visibleArea() const
 {
-    return m_adapterVisibleArea;
+    if (m_adapterVisibleArea.isEmpty()) {
+        return m_adapterVisibleArea;
+    }
+
+    // Items about to be scrolled in get their previews along with the
+    // visible ones.
+    const int margin = m_adapterLookAhead;
+
+    if (m_flowTopToBottom) {
+        return m_adapterVisibleArea.adjusted(-margin, 0, margin, 0);
+    }
+
+    return m_adapterVisibleArea.adjusted(0, -margin, 0, margin);
 }
 
 QRect ItemViewAdapter::visualRect(const QModelIndex &index) const
 {
-    // FIXME TODO: Implemented on DND branch.
+    if (!index.isValid() || m_cellWidth <= 0 || m_cellHeight <= 0) {
+        return QRect();
+    }
+
+    int row = index.row();
 
-    Q_UNUSED(index)
+    // The preview generator hands out indices of the folder model, while
+    // the view lays out the positioner's rows.
+    const Positioner *positioner = qobject_cast<const Positioner *>(m_adapterModel);
 
-    return QRect();
+    if (positioner && index.model() != positioner) {
+        row = positioner->mapFromSource(row);
+
+        if (row == -1) {
+            return QRect();
+        }
+    }
+
+    int column = 0;
+    int line = 0;
+
+    if (m_flowTopToBottom) {
+        const int perColumn = qMax(1, int(std::floor(m_viewHeight / m_cellHeight)));
+        column = row / perColumn;
+        line = row % perColumn;
+    } else {
+        const int perLine = qMax(1, int(std::floor(m_viewWidth / m_cellWidth)));
+        column = row % perLine;
+        line = row / perLine;
+    }
+
+    qreal x = column * m_cellWidth;
+
+    if (m_rightToLeft) {
+        x = m_viewWidth - x - m_cellWidth;
+    }
+
+    return QRect(qRound(x), qRound(line * m_cellHeight), qRound(m_cellWidth), qRound(m_cellHeight));
 }
 
 void ItemViewAdapter::connect(Signal signal, QObject *receiver, const char *slot)
@@ -81,12 +136,46 @@ QObject* ItemViewAdapter::adapterView() const
 void ItemViewAdapter::setAdapterView(QObject* view)
 {
     if (m_adapterView != view) {
+        if (m_adapterView) {
+            QObject::disconnect(m_adapterView, 0, this, SLOT(updateViewGeometry()));
+        }
+
         m_adapterView = view;
 
+        if (m_adapterView) {
+            QObject::connect(m_adapterView, SIGNAL(cellWidthChanged()), this, SLOT(updateViewGeometry()));
+            QObject::connect(m_adapterView, SIGNAL(cellHeightChanged()), this, SLOT(updateViewGeometry()));
+            QObject::connect(m_adapterView, SIGNAL(flowChanged()), this, SLOT(updateViewGeometry()));
+            QObject::connect(m_adapterView, SIGNAL(widthChanged()), this, SLOT(updateViewGeometry()));
+            QObject::connect(m_adapterView, SIGNAL(heightChanged()), this, SLOT(updateViewGeometry()));
+            QObject::connect(m_adapterView, SIGNAL(effectiveLayoutDirectionChanged()), this, SLOT(updateViewGeometry()));
+        }
+
+        updateViewGeometry();
+
         emit adapterViewChanged();
     }
 }
 
+void ItemViewAdapter::updateViewGeometry()
+{
+    if (!m_adapterView) {
+        m_cellWidth = m_cellHeight = 0;
+        m_viewWidth = m_viewHeight = 0;
+
+        return;
+    }
+
+    m_cellWidth = m_adapterView->property("cellWidth").toReal();
+    m_cellHeight = m_adapterView->property("cellHeight").toReal();
+    m_viewWidth = m_adapterView->property("width").toReal();
+    m_viewHeight = m_adapterView->property("height").toReal();
+
+    // GridView.FlowTopToBottom
+    m_flowTopToBottom = (m_adapterView->property("flow").toInt() == 1);
+    m_rightToLeft = (m_adapterView->property("effectiveLayoutDirection").toInt() == Qt::RightToLeft);
+}
+
 void ItemViewAdapter::setAdapterModel(QAbstractItemModel *model)
 {
     if (m_adapterModel != model) {
@@ -121,5 +210,23 @@ void ItemViewAdapter::setAdapterVisibleArea(QRect rect)
         m_adapterVisibleArea = rect;
 
         emit adapterVisibleAreaChanged();
+
+        // Makes the preview generator put the items now in view first,
+        // and drop the jobs it already started for the others.
+        emit viewScrolled();
+    }
+}
+
+int ItemViewAdapter::adapterLookAhead() const
+{
+    return m_adapterLookAhead;
+}
+
+void ItemViewAdapter::setAdapterLookAhead(int lookAhead)
+{
+    if (m_adapterLookAhead != lookAhead) {
+        m_adapterLookAhead = lookAhead;
+
+        emit adapterLookAheadChanged();
     }
 }
@@ -20,6 +20,7 @@
 #ifndef ITEMVIEWADAPTER_H
 #define ITEMVIEWADAPTER_H
 
+#include <QPointer>
 #include <QRect>
 
 #include <KAbstractViewAdapter>
@@ -32,6 +33,7 @@ class ItemViewAdapter : public KAbstractViewAdapter
     Q_PROPERTY(QAbstractItemModel* adapterModel READ adapterModel WRITE setAdapterModel NOTIFY adapterModelChanged)
     Q_PROPERTY(int adapterIconSize READ adapterIconSize WRITE setAdapterIconSize NOTIFY adapterIconSizeChanged)
     Q_PROPERTY(QRect adapterVisibleArea READ adapterVisibleArea WRITE setAdapterVisibleArea NOTIFY adapterVisibleAreaChanged)
+    Q_PROPERTY(int adapterLookAhead READ adapterLookAhead WRITE setAdapterLookAhead NOTIFY adapterLookAheadChanged)
 
     public:
         ItemViewAdapter(QObject* parent = 0);
@@ -55,18 +57,37 @@ class ItemViewAdapter : public KAbstractViewAdapter
         QRect adapterVisibleArea() const;
         void setAdapterVisibleArea(QRect rect);
 
+        // How far beyond the visible area, in pixels, items still count
+        // as visible when previews are scheduled.
+        int adapterLookAhead() const;
+        void setAdapterLookAhead(int lookAhead);
+
     Q_SIGNALS:
         void viewScrolled() const;
         void adapterViewChanged() const;
         void adapterModelChanged() const;
         void adapterIconSizeChanged() const;
         void adapterVisibleAreaChanged() const;
+        void adapterLookAheadChanged() const;
+
+    private Q_SLOTS:
+        void updateViewGeometry();
 
     private:
-        QObject *m_adapterView;
+        QPointer<QObject> m_adapterView;
         QAbstractItemModel *m_adapterModel;
         int m_adapterIconSize;
         QRect m_adapterVisibleArea;
+        int m_adapterLookAhead;
+
+        // Grid geometry of the view, kept here since the preview generator
+        // asks for the rects of all items whenever it reorders its queue.
+        qreal m_cellWidth;
+        qreal m_cellHeight;
+        qreal m_viewWidth;
+        qreal m_viewHeight;
+        bool m_flowTopToBottom;
+        bool m_rightToLeft;
 };
 
 #endif
@@ -19,20 +19,101 @@
 
 #include "mimetypesmodel.h"
 
+#include <QCollator>
+#include <QCoreApplication>
 #include <QMimeDatabase>
+#include <QStandardPaths>
 
-static bool lessThan(const QMimeType &a, const QMimeType &b)
+#include <KDirWatch>
+
+#include <algorithm>
+#include <numeric>
+
+struct MimeTypeCatalog
 {
-    return QString::localeAwareCompare(a.name(), b.name()) < 0;
-}
+    // Sorted by name, in a locale aware way.
+    QVector<QMimeType> mimeTypes;
+    QVector<QString> iconNames;
+    QHash<QString, int> rows;
+};
 
-MimeTypesModel::MimeTypesModel(QObject *parent) : QAbstractListModel(parent)
+static QSharedPointer<const MimeTypeCatalog> buildCatalog()
 {
     QMimeDatabase db;
-    m_mimeTypesList = db.allMimeTypes();
-    qStableSort(m_mimeTypesList.begin(), m_mimeTypesList.end(), lessThan);
+    const QList<QMimeType> &mimeTypes = db.allMimeTypes();
+
+    // Comparing sort keys is a lot cheaper than comparing the names
+    // themselves over and over again.
+    QCollator collator;
+    QVector<QCollatorSortKey> keys;
+    keys.reserve(mimeTypes.count());
+
+    foreach (const QMimeType &mimeType, mimeTypes) {
+        keys.append(collator.sortKey(mimeType.name()));
+    }
+
+    QVector<int> order(mimeTypes.count());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&keys](int a, int b) {
+        return keys.at(a).compare(keys.at(b)) < 0;
+    });
+
+    QSharedPointer<MimeTypeCatalog> catalog(new MimeTypeCatalog);
+    catalog->mimeTypes.reserve(order.count());
+    catalog->iconNames.reserve(order.count());
+    catalog->rows.reserve(order.count());
+
+    foreach (int i, order) {
+        const QMimeType &mimeType = mimeTypes.at(i);
+
+        QString icon = mimeType.iconName();
+
+        if (icon.isEmpty()) {
+            icon = mimeType.genericIconName();
+        }
+
+        catalog->rows.insert(mimeType.name(), catalog->mimeTypes.count());
+        catalog->mimeTypes.append(mimeType);
+        catalog->iconNames.append(icon);
+    }
+
+    return catalog;
+}
+
+// Built on first use and shared by all folder containments in the process,
+// then built again on the next use after shared-mime-info updated its cache.
+static QSharedPointer<const MimeTypeCatalog> sharedCatalog()
+{
+    static QSharedPointer<const MimeTypeCatalog> catalog;
+    static KDirWatch *watch = nullptr;
+
+    if (!watch) {
+        watch = new KDirWatch(QCoreApplication::instance());
 
-    checkedRows = QVector<bool>(m_mimeTypesList.size(), false);
+        foreach (const QString &dir, QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation)) {
+            watch->addFile(dir + QLatin1String("/mime/mime.cache"));
+        }
+
+        auto invalidate = []() {
+            catalog.clear();
+        };
+
+        QObject::connect(watch, &KDirWatch::dirty, invalidate);
+        QObject::connect(watch, &KDirWatch::created, invalidate);
+        QObject::connect(watch, &KDirWatch::deleted, invalidate);
+    }
+
+    if (!catalog) {
+        catalog = buildCatalog();
+    }
+
+    return catalog;
+}
+
+MimeTypesModel::MimeTypesModel(QObject *parent) : QAbstractListModel(parent)
+, m_catalog(sharedCatalog())
+{
+    checkedRows = QVector<bool>(m_catalog->mimeTypes.size(), false);
 }
 
 MimeTypesModel::~MimeTypesModel()
@@ -48,26 +129,25 @@ QHash<int, QByteArray> MimeTypesModel::roleNames() const
     };
 }
 
+int MimeTypesModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+
+    return m_catalog->mimeTypes.size();
+}
+
 QVariant MimeTypesModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() < 0 || index.row() >= m_mimeTypesList.size()) {
+    if (index.row() < 0 || index.row() >= m_catalog->mimeTypes.size()) {
         return QVariant();
     }
 
     switch (role) {
         case Qt::DisplayRole:
-            return m_mimeTypesList.at(index.row()).name();
+            return m_catalog->mimeTypes.at(index.row()).name();
 
         case Qt::DecorationRole:
-        {
-            QString icon = m_mimeTypesList.at(index.row()).iconName();
-
-            if (icon.isEmpty()) {
-                icon = m_mimeTypesList.at(index.row()).genericIconName();
-            }
-
-            return icon;
-        }
+            return m_catalog->iconNames.at(index.row());
 
         case Qt::CheckStateRole:
             return checkedRows.at(index.row()) ? Qt::Checked : Qt::Unchecked;
@@ -89,21 +169,16 @@ void MimeTypesModel::setRowChecked(int row, bool checked)
 
 void MimeTypesModel::checkAll()
 {
-    checkedRows = QVector<bool>(m_mimeTypesList.size(), true);
+    checkedRows = QVector<bool>(m_catalog->mimeTypes.size(), true);
 
-    emit dataChanged(index(0, 0), index(m_mimeTypesList.size() - 1, 0));
+    emit dataChanged(index(0, 0), index(m_catalog->mimeTypes.size() - 1, 0));
 
     emit checkedTypesChanged();
 }
 
 int MimeTypesModel::indexOfType(const QString &name) const
 {
-    for (int i = 0; i < m_mimeTypesList.size(); i++) {
-        if (m_mimeTypesList.at(i).name() == name) {
-            return i;
-        }
-    }
-    return -1;
+    return m_catalog->rows.value(name, -1);
 }
 
 QStringList MimeTypesModel::checkedTypes() const
@@ -112,7 +187,7 @@ QStringList MimeTypesModel::checkedTypes() const
 
     for (int i =0; i < checkedRows.size(); ++i) {
         if (checkedRows.at(i)) {
-            list.append(m_mimeTypesList.at(i).name());
+            list.append(m_catalog->mimeTypes.at(i).name());
         }
     }
 
@@ -125,7 +200,7 @@ QStringList MimeTypesModel::checkedTypes() const
 
 void MimeTypesModel::setCheckedTypes(const QStringList &list)
 {
-    checkedRows = QVector<bool>(m_mimeTypesList.size(), false);
+    checkedRows = QVector<bool>(m_catalog->mimeTypes.size(), false);
 
     foreach (const QString &name, list) {
         const int row = indexOfType(name);
@@ -135,7 +210,7 @@ void MimeTypesModel::setCheckedTypes(const QStringList &list)
         }
     }
 
-    emit dataChanged(index(0, 0), index(m_mimeTypesList.size() - 1, 0));
+    emit dataChanged(index(0, 0), index(m_catalog->mimeTypes.size() - 1, 0));
 
     emit checkedTypesChanged();
 }
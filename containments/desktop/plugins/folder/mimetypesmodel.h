@@ -22,10 +22,13 @@
 
 #include <QAbstractListModel>
 #include <QMimeType>
+#include <QSharedPointer>
 #include <QSortFilterProxyModel>
 
 class QStringList;
 
+struct MimeTypeCatalog;
+
 class MimeTypesModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -42,7 +45,7 @@ class MimeTypesModel : public QAbstractListModel
         Q_INVOKABLE void checkAll();
         Q_INVOKABLE void setRowChecked(int row, bool checked);
 
-        int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE { Q_UNUSED(parent) return m_mimeTypesList.size(); }
+        int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
 
         QStringList checkedTypes() const;
         void setCheckedTypes(const QStringList &list);
@@ -53,7 +56,9 @@ class MimeTypesModel : public QAbstractListModel
     private:
         int indexOfType(const QString &name) const;
 
-        QList<QMimeType> m_mimeTypesList;
+        // Shared by all models, and kept by this one even if the mime
+        // database changes while it's around.
+        QSharedPointer<const MimeTypeCatalog> m_catalog;
         QVector<bool> checkedRows;
 };
 
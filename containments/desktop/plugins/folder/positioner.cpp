@@ -23,6 +23,7 @@
 #include <QDebug>
 #include <QTimer>
 
+#include <algorithm>
 #include <cstdlib>
 
 Positioner::Positioner(QObject *parent): QAbstractItemModel(parent)
@@ -149,6 +150,15 @@ int Positioner::map(int row) const
     return row;
 }
 
+int Positioner::mapFromSource(int sourceRow) const
+{
+    if (m_enabled && m_folderModel) {
+        return m_sourceToProxy.value(sourceRow, -1);
+    }
+
+    return sourceRow;
+}
+
 int Positioner::nearestItem(int currentIndex, Qt::ArrowType direction)
 {
     if (!m_enabled || currentIndex >= rowCount()) {
@@ -268,16 +278,16 @@ void Positioner::setRangeSelected(int anchor, int to)
     }
 
     if (m_enabled) {
-        QVariantList indices;
+        QVector<int> rows;
 
         for (int i = qMin(anchor, to); i <= qMax(anchor, to); ++i) {
             if (m_proxyToSource.contains(i)) {
-                indices.append(m_proxyToSource.value(i));
+                rows.append(m_proxyToSource.value(i));
             }
         }
 
-        if (indices.count()) {
-            m_folderModel->updateSelection(indices, false);
+        if (rows.count()) {
+            m_folderModel->updateSelection(m_folderModel->selectionForRows(rows), false);
         }
     } else {
         m_folderModel->setRangeSelected(anchor, to);
@@ -482,12 +492,29 @@ void Positioner::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex
         int start = topLeft.row();
         int end = bottomRight.row();
 
+        QVector<int> rows;
+        rows.reserve(end - start + 1);
+
         for (int i = start; i <= end; ++i) {
             if (m_sourceToProxy.contains(i)) {
-                const QModelIndex &idx = index(m_sourceToProxy.value(i), 0);
+                rows.append(m_sourceToProxy.value(i));
+            }
+        }
+
+        // Positions scatter the rows, but neighbors usually stay together,
+        // so runs of proxy rows are announced as one range each.
+        std::sort(rows.begin(), rows.end());
 
-                emit dataChanged(idx, idx);
+        for (int i = 0; i < rows.count();) {
+            int last = i;
+
+            while (last + 1 < rows.count() && rows.at(last + 1) == rows.at(last) + 1) {
+                ++last;
             }
+
+            emit dataChanged(index(rows.at(i), 0), index(rows.at(last), 0), roles);
+
+            i = last + 1;
         }
     } else {
         emit dataChanged(topLeft, bottomRight, roles);
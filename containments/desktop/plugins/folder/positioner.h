@@ -52,6 +52,7 @@ class Positioner : public QAbstractItemModel
         void setPositions(QStringList positions);
 
         Q_INVOKABLE int map(int row) const;
+        int mapFromSource(int sourceRow) const;
 
         Q_INVOKABLE int nearestItem(int currentIndex, Qt::ArrowType direction);
 
@@ -0,0 +1,151 @@
+/*
+ *   Copyright (C) 2017 The KDE Project
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2,
+ *   or (at your option) any later version, as published by the Free
+ *   Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Self
+#include "lastusedstore.h"
+
+// Qt
+#include <QCoreApplication>
+#include <QStandardPaths>
+
+// KDE
+#include <KConfigGroup>
+#include <KDirWatch>
+
+#define SWITCHERCONFIG "kactivitymanagerd-switcher"
+
+// How long to wait for more switches before writing the file
+static const int SAVE_DELAY = 2000;
+
+LastUsedStore &LastUsedStore::self()
+{
+    // If you convert this to a shared pointer,
+    // fix the connections to KDirWatcher
+    static LastUsedStore store;
+    return store;
+}
+
+LastUsedStore::LastUsedStore()
+    : m_config(KSharedConfig::openConfig(SWITCHERCONFIG, KConfig::SimpleConfig))
+{
+    const auto configFile = QStandardPaths::writableLocation(
+                                QStandardPaths::GenericConfigLocation) +
+                            QLatin1Char('/') + SWITCHERCONFIG;
+
+    KDirWatch::self()->addFile(configFile);
+
+    QObject::connect(KDirWatch::self(), &KDirWatch::dirty,
+                     this, &LastUsedStore::settingsFileChanged,
+                     Qt::QueuedConnection);
+    QObject::connect(KDirWatch::self(), &KDirWatch::created,
+                     this, &LastUsedStore::settingsFileChanged,
+                     Qt::QueuedConnection);
+
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(SAVE_DELAY);
+    QObject::connect(&m_saveTimer, &QTimer::timeout,
+                     this, &LastUsedStore::flush);
+
+    // Do not lose the last switch when the shell goes away
+    if (QCoreApplication::instance()) {
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+                         this, &LastUsedStore::flush);
+    }
+
+    reload();
+}
+
+LastUsedStore::~LastUsedStore()
+{
+}
+
+uint LastUsedStore::lastUsed(const QString &activity) const
+{
+    return m_times.value(activity, 0);
+}
+
+void LastUsedStore::setLastUsed(const QString &activity, uint time)
+{
+    if (m_times.value(activity, 0) == time) return;
+
+    m_times[activity] = time;
+    m_pending << activity;
+    m_saveTimer.start();
+
+    emit lastUsedChanged({ activity });
+}
+
+void LastUsedStore::flush()
+{
+    m_saveTimer.stop();
+
+    if (m_pending.isEmpty()) return;
+
+    KConfigGroup times(m_config, "LastUsed");
+
+    for (const auto &activity: m_pending) {
+        times.writeEntry(activity, m_times[activity]);
+    }
+
+    m_pending.clear();
+    m_config->sync();
+}
+
+void LastUsedStore::settingsFileChanged(const QString &file)
+{
+    if (!file.endsWith(SWITCHERCONFIG)) {
+        return;
+    }
+
+    m_config->reparseConfiguration();
+    reload();
+}
+
+void LastUsedStore::reload()
+{
+    const KConfigGroup times(m_config, "LastUsed");
+
+    QHash<QString, uint> newTimes;
+    for (const auto &activity: times.keyList()) {
+        newTimes[activity] = times.readEntry(activity, (uint)0);
+    }
+
+    // Our own updates that did not reach the file yet are newer
+    for (const auto &activity: m_pending) {
+        newTimes[activity] = m_times[activity];
+    }
+
+    QStringList changedActivities;
+    for (auto it = newTimes.constBegin(); it != newTimes.constEnd(); ++it) {
+        if (m_times.value(it.key(), 0) != it.value()) {
+            changedActivities << it.key();
+        }
+    }
+    for (auto it = m_times.constBegin(); it != m_times.constEnd(); ++it) {
+        if (!newTimes.contains(it.key())) {
+            changedActivities << it.key();
+        }
+    }
+
+    m_times = newTimes;
+
+    if (!changedActivities.isEmpty()) {
+        emit lastUsedChanged(changedActivities);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ *   Copyright (C) 2017 The KDE Project
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2,
+ *   or (at your option) any later version, as published by the Free
+ *   Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef LAST_USED_STORE_H
+#define LAST_USED_STORE_H
+
+// Qt
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+// KDE
+#include <KSharedConfig>
+
+/**
+ * In-memory copy of the times the activities were last used.
+ *
+ * The times live in kactivitymanagerd-switcher, which is read once and
+ * then watched for changes made by other processes. Updates are kept in
+ * memory and written back shortly after the last one, so neither sorting
+ * the activities nor switching between them has to touch the disk.
+ */
+class LastUsedStore: public QObject {
+    Q_OBJECT
+
+public:
+    static LastUsedStore &self();
+
+    uint lastUsed(const QString &activity) const;
+    void setLastUsed(const QString &activity, uint time);
+
+    /**
+     * Writes pending updates to the config file right away
+     */
+    void flush();
+
+Q_SIGNALS:
+    void lastUsedChanged(const QStringList &activities);
+
+private:
+    LastUsedStore();
+    ~LastUsedStore();
+
+    void reload();
+    void settingsFileChanged(const QString &file);
+
+    KSharedConfig::Ptr m_config;
+    QHash<QString, uint> m_times;
+    QSet<QString> m_pending;
+    QTimer m_saveTimer;
+};
+
+#endif // LAST_USED_STORE_H
@@ -20,13 +20,23 @@
 // Self
 #include "sortedactivitiesmodel.h"
 
+// Local
+#include "lastusedstore.h"
+
 // C++
+#include <cstring>
 #include <functional>
 
 // Qt
 #include <QColor>
+#include <QFile>
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QScopedPointer>
+#include <QSet>
 #include <QTimer>
+#include <QVector>
 
 // KDE
 #include <KSharedConfig>
@@ -40,10 +50,17 @@
 #include <KWindowSystem>
 #include <QX11Info>
 
+// X11
+#include <xcb/xcb.h>
+
 #define PLASMACONFIG "plasma-org.kde.plasma.desktop-appletsrc"
 
 namespace {
 
+    // How long to wait before rereading the plasma config file,
+    // it tends to get written many times in a row
+    const int RELOAD_DELAY = 500;
+
     class BackgroundCache: public QObject {
     public:
         BackgroundCache()
@@ -52,9 +69,9 @@ namespace {
         {
             using namespace std::placeholders;
 
-            const auto configFile = QStandardPaths::writableLocation(
-                                        QStandardPaths::GenericConfigLocation) +
-                                    QLatin1Char('/') + PLASMACONFIG;
+            configFile = QStandardPaths::writableLocation(
+                             QStandardPaths::GenericConfigLocation) +
+                         QLatin1Char('/') + PLASMACONFIG;
 
             KDirWatch::self()->addFile(configFile);
 
@@ -65,6 +82,10 @@ namespace {
                              this, &BackgroundCache::settingsFileChanged,
                              Qt::QueuedConnection);
 
+            reloadTimer.setSingleShot(true);
+            reloadTimer.setInterval(RELOAD_DELAY);
+            QObject::connect(&reloadTimer, &QTimer::timeout,
+                             this, &BackgroundCache::reparse);
         }
 
         void settingsFileChanged(const QString &file)
@@ -73,6 +94,16 @@ namespace {
                 return;
             }
 
+            // Not restarting the timer if it is already running,
+            // otherwise a steady stream of writes would postpone
+            // the reload forever
+            if (initialized && !reloadTimer.isActive()) {
+                reloadTimer.start();
+            }
+        }
+
+        void reparse()
+        {
             if (initialized) {
                 plasmaConfig->reparseConfiguration();
                 reload();
@@ -94,7 +125,10 @@ namespace {
 
             if (models.isEmpty()) {
                 initialized = false;
+                reloadTimer.stop();
                 forActivity.clear();
+                containments.clear();
+                containmentsOfActivity.clear();
             }
         }
 
@@ -118,81 +152,178 @@ namespace {
             return QString();
         }
 
-        void reload()
+        // The bits of a containment we care about
+        struct ContainmentInfo {
+            QString activity;
+            int lastScreen;
+            QString background;
+            // hash of the containment's raw config text, see containmentStamps()
+            uint stamp;
+
+            bool operator==(const ContainmentInfo &other) const
+            {
+                return activity == other.activity
+                    && lastScreen == other.lastScreen
+                    && background == other.background;
+            }
+        };
+
+        // Out of all containments that belong to the activity, we are
+        // using the one with a proper wallpaper (not just a color)
+        // whose screen ID is the closest to zero
+        QString backgroundForActivity(const QString &activity) const
         {
-            auto newForActivity = forActivity;
-            QHash<QString, int> lastScreenForActivity;
+            QString result;
+            int resultScreen = 0;
 
-            // contains activities for which the wallpaper
-            // has updated
-            QStringList changedActivities;
+            for (const auto &containmentId: containmentsOfActivity.value(activity)) {
+                const auto &containment = containments[containmentId];
+                if (containment.background.isEmpty()) continue;
 
-            // Contains activities not covered by any containment
-            QStringList ghostActivities = forActivity.keys();
+                const bool isColor = containment.background[0] == '#';
+                const bool resultIsColor = !result.isEmpty() && result[0] == '#';
 
-            // Traversing through all containments in search for
-            // containments that define activities in plasma
-            for (const auto& containmentId: plasmaConfigContainments().groupList()) {
-                const auto containment = plasmaConfigContainments().group(containmentId);
-                const auto lastScreen  = containment.readEntry("lastScreen", 0);
-                const auto activity    = containment.readEntry("activityId", QString());
+                if (result.isEmpty()
+                        || (resultIsColor && !isColor)
+                        || (resultIsColor == isColor && containment.lastScreen < resultScreen)) {
+                    result = containment.background;
+                    resultScreen = containment.lastScreen;
+                }
+            }
 
-                // Ignore the containment if the activity is not defined
-                if (activity.isEmpty()) continue;
+            return result;
+        }
 
-                // If we have already found the same activity from another
-                // containment, we are using the new one only if
-                // the previous one was a color and not a proper wallpaper,
-                // or if the screen ID is closer to zero
-                const bool processed = !ghostActivities.contains(activity) &&
-                                        newForActivity.contains(activity) &&
-                                        (lastScreenForActivity[activity] <= lastScreen);
+        // Hashes the raw text of every containment section of the config
+        // file, subgroups included, so that only the containments whose
+        // text changed need to be read through KConfig
+        QHash<QString, uint> containmentStamps() const
+        {
+            QHash<QString, uint> stamps;
 
-                // qDebug() << "GREPME Searching containment " << containmentId
-                //          << "for the wallpaper of the " << activity << " activity - "
-                //          << "currently, we think that the wallpaper is " << processed << (processed ? newForActivity[activity] : QString())
-                //          << "last screen is" << lastScreen
-                //          ;
+            QFile file(configFile);
+            if (!file.open(QIODevice::ReadOnly)) {
+                return stamps;
+            }
 
-                if (processed &&
-                    newForActivity[activity][0] != '#') continue;
+            static const QByteArray prefix("[Containments][");
+            QString current;
 
-                // Marking the current activity as processed
-                ghostActivities.removeAll(activity);
+            while (!file.atEnd()) {
+                const QByteArray line = file.readLine();
 
-                const auto background = backgroundFromConfig(containment);
+                if (line.startsWith('[')) {
+                    current.clear();
+                    if (line.startsWith(prefix)) {
+                        const int end = line.indexOf(']', prefix.size());
+                        if (end > prefix.size()) {
+                            current = QString::fromUtf8(line.mid(prefix.size(), end - prefix.size()));
+                        }
+                    }
+                }
 
-                // qDebug() << "        GREPME Found wallpaper: " << background;
+                if (!current.isEmpty()) {
+                    stamps[current] = qHash(line, stamps.value(current));
+                }
+            }
 
-                if (background.isEmpty()) continue;
+            return stamps;
+        }
 
-                // If we got this far and we already had a new wallpaper for
-                // this activity, it means we now have a better one
-                bool foundBetterWallpaper = changedActivities.contains(activity);
+        void removeContainment(const QString &containmentId)
+        {
+            auto it = containments.find(containmentId);
+            if (it == containments.end()) return;
+
+            auto ofActivity = containmentsOfActivity.find(it->activity);
+            if (ofActivity != containmentsOfActivity.end()) {
+                ofActivity->removeAll(containmentId);
+                if (ofActivity->isEmpty()) {
+                    containmentsOfActivity.erase(ofActivity);
+                }
+            }
 
-                if (foundBetterWallpaper || newForActivity[activity] != background) {
-                    if (!foundBetterWallpaper) {
-                        changedActivities << activity;
-                    }
+            containments.erase(it);
+        }
+
+        void reload()
+        {
+            // Activities that had one of their containments
+            // added, removed or changed since the last reload
+            QSet<QString> affectedActivities;
+
+            const auto containmentsConfig = plasmaConfigContainments();
+            const auto containmentIds = containmentsConfig.groupList();
+            const auto stamps = containmentStamps();
+
+            // Forgetting the containments that have been removed
+            const auto ids = containmentIds.toSet();
+            for (const auto &containmentId: containments.keys()) {
+                if (!ids.contains(containmentId)) {
+                    affectedActivities << containments[containmentId].activity;
+                    removeContainment(containmentId);
+                }
+            }
 
-                    // qDebug() << "        GREPME Setting: " << activity << " = " << background << "," << lastScreen;
-                    newForActivity[activity] = background;
-                    lastScreenForActivity[activity] = lastScreen;
+            // Reading only the containments whose config text changed
+            for (const auto& containmentId: containmentIds) {
+                const uint stamp = stamps.value(containmentId);
+
+                auto it = containments.find(containmentId);
+                if (it != containments.end() && stamp != 0 && it->stamp == stamp) {
+                    continue;
+                }
+
+                const auto containment = containmentsConfig.group(containmentId);
+
+                ContainmentInfo info;
+                info.activity   = containment.readEntry("activityId", QString());
+                info.lastScreen = containment.readEntry("lastScreen", 0);
+                info.stamp      = stamp;
+
+                // Ignore the wallpaper if the activity is not defined
+                if (!info.activity.isEmpty()) {
+                    info.background = backgroundFromConfig(containment);
                 }
+
+                if (it != containments.end()) {
+                    if (*it == info) {
+                        it->stamp = stamp;
+                        continue;
+                    }
+                    affectedActivities << it->activity;
+                    removeContainment(containmentId);
+                }
+
+                affectedActivities << info.activity;
+                containments[containmentId] = info;
+                containmentsOfActivity[info.activity] << containmentId;
             }
 
+            affectedActivities.remove(QString());
+
             initialized = true;
 
-            // Removing the activities from the list if we haven't found them
-            // while traversing through the containments
-            for (const auto& activity: ghostActivities) {
-                newForActivity.remove(activity);
+            // contains activities for which the wallpaper
+            // has updated
+            QStringList changedActivities;
+
+            for (const auto &activity: affectedActivities) {
+                const auto background = backgroundForActivity(activity);
+
+                if (background.isEmpty()) {
+                    if (forActivity.remove(activity)) {
+                        changedActivities << activity;
+                    }
+
+                } else if (forActivity.value(activity) != background) {
+                    forActivity[activity] = background;
+                    changedActivities << activity;
+                }
             }
 
             // If we have detected the changes, lets notify everyone
             if (!changedActivities.isEmpty()) {
-                forActivity = newForActivity;
-
                 for (auto model: models) {
                     model->onBackgroundsUpdated(changedActivities);
                 }
@@ -204,10 +335,14 @@ namespace {
         }
 
         QHash<QString, QString> forActivity;
+        QMap<QString, ContainmentInfo> containments;
+        QHash<QString, QStringList> containmentsOfActivity;
         QList<SortedActivitiesModel*> models;
 
         bool initialized;
         KSharedConfig::Ptr plasmaConfig;
+        QString configFile;
+        QTimer reloadTimer;
     };
 
     static BackgroundCache &backgrounds()
@@ -218,6 +353,200 @@ namespace {
         return cache;
     }
 
+    const QString NULL_UUID = QStringLiteral("00000000-0000-0000-0000-000000000000");
+
+    // Reads the activities of all the passed windows at once. On X11, all
+    // the property requests are sent before waiting for the first reply,
+    // so this costs a single round-trip no matter how many windows we have
+    QHash<WId, QStringList> activitiesForWindows(const QList<WId> &windows)
+    {
+        QHash<WId, QStringList> result;
+
+        if (!QX11Info::isPlatformX11()) {
+            for (const auto& window: windows) {
+                KWindowInfo info(window, 0, NET::WM2Activities);
+                result[window] = info.activities();
+            }
+            return result;
+        }
+
+        auto connection = QX11Info::connection();
+
+        static xcb_atom_t activitiesAtom = XCB_ATOM_NONE;
+        if (activitiesAtom == XCB_ATOM_NONE) {
+            static const char name[] = "_KDE_NET_WM_ACTIVITIES";
+            const auto cookie = xcb_intern_atom(connection, false, strlen(name), name);
+            QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter>
+                reply(xcb_intern_atom_reply(connection, cookie, nullptr));
+            if (!reply) return result;
+            activitiesAtom = reply->atom;
+        }
+
+        QVector<xcb_get_property_cookie_t> cookies;
+        cookies.reserve(windows.size());
+
+        for (const auto& window: windows) {
+            cookies << xcb_get_property(connection, false, window, activitiesAtom,
+                                        XCB_GET_PROPERTY_TYPE_ANY, 0, 4096);
+        }
+
+        for (int i = 0; i < windows.size(); ++i) {
+            QScopedPointer<xcb_get_property_reply_t, QScopedPointerPodDeleter>
+                reply(xcb_get_property_reply(connection, cookies[i], nullptr));
+
+            QStringList activities;
+
+            if (reply && reply->format == 8) {
+                const auto length = xcb_get_property_value_length(reply.data());
+                if (length > 0) {
+                    activities = QString::fromUtf8(
+                            static_cast<const char *>(xcb_get_property_value(reply.data())),
+                            length).split(QLatin1Char(','), QString::SkipEmptyParts);
+                }
+            }
+
+            result[windows[i]] = activities;
+        }
+
+        return result;
+    }
+
+    class WindowCache: public QObject {
+    public:
+        WindowCache()
+            : initialized(false)
+        {
+            QObject::connect(KWindowSystem::self(), &KWindowSystem::windowAdded,
+                             this, &WindowCache::windowAdded);
+            QObject::connect(KWindowSystem::self(), &KWindowSystem::windowRemoved,
+                             this, &WindowCache::windowRemoved);
+            QObject::connect(KWindowSystem::self(),
+                             static_cast<void (KWindowSystem::*)(WId, NET::Properties, NET::Properties2)>
+                                 (&KWindowSystem::windowChanged),
+                             this, &WindowCache::windowChanged);
+        }
+
+        void subscribe(SortedActivitiesModel *model)
+        {
+            if (!initialized) {
+                reload();
+            }
+
+            models << model;
+        }
+
+        void unsubscribe(SortedActivitiesModel *model)
+        {
+            models.removeAll(model);
+
+            if (models.isEmpty()) {
+                initialized = false;
+                activitiesForWindow.clear();
+                windowCount.clear();
+            }
+        }
+
+        void reload()
+        {
+            activitiesForWindow.clear();
+            windowCount.clear();
+
+            const auto windows = activitiesForWindows(KWindowSystem::stackingOrder());
+
+            for (auto it = windows.constBegin(); it != windows.constEnd(); ++it) {
+                setWindowActivities(it.key(), it.value());
+            }
+
+            initialized = true;
+        }
+
+        // Updates both the window to activities map, and the
+        // window counts. Returns the activities whose count changed
+        QStringList setWindowActivities(WId window, QStringList activities)
+        {
+            // Windows on all activities are not counted
+            if (activities.contains(NULL_UUID)) {
+                activities.clear();
+            }
+
+            const auto previous = activitiesForWindow.value(window);
+
+            if (previous == activities) return QStringList();
+
+            if (activities.isEmpty()) {
+                activitiesForWindow.remove(window);
+            } else {
+                activitiesForWindow[window] = activities;
+            }
+
+            QStringList changedActivities;
+
+            for (const auto& activity: previous) {
+                if (activities.contains(activity)) continue;
+
+                if (--windowCount[activity] == 0) {
+                    windowCount.remove(activity);
+                }
+                changedActivities << activity;
+            }
+
+            for (const auto& activity: activities) {
+                if (previous.contains(activity)) continue;
+
+                ++windowCount[activity];
+                changedActivities << activity;
+            }
+
+            return changedActivities;
+        }
+
+        void notify(const QStringList &activities)
+        {
+            for (const auto& activity: activities) {
+                const int count = windowCount.value(activity);
+
+                for (auto model: models) {
+                    model->onWindowCountChanged(activity, count);
+                }
+            }
+        }
+
+        void windowAdded(WId window)
+        {
+            if (!initialized) return;
+
+            notify(setWindowActivities(window, activitiesForWindows({ window })[window]));
+        }
+
+        void windowRemoved(WId window)
+        {
+            if (!initialized) return;
+
+            notify(setWindowActivities(window, QStringList()));
+        }
+
+        void windowChanged(WId window, NET::Properties properties, NET::Properties2 properties2)
+        {
+            Q_UNUSED(properties);
+
+            if (!initialized || !(properties2 & NET::WM2Activities)) return;
+
+            notify(setWindowActivities(window, activitiesForWindows({ window })[window]));
+        }
+
+        QHash<WId, QStringList> activitiesForWindow;
+        QHash<QString, int> windowCount;
+        QList<SortedActivitiesModel*> models;
+
+        bool initialized;
+    };
+
+    static WindowCache &windows()
+    {
+        static WindowCache cache;
+        return cache;
+    }
+
 }
 
 SortedActivitiesModel::SortedActivitiesModel(QVector<KActivities::Info::State> states, QObject *parent)
@@ -233,30 +562,16 @@ SortedActivitiesModel::SortedActivitiesModel(QVector<KActivities::Info::State> s
 
     backgrounds().subscribe(this);
 
-    const QList<WId> windows = KWindowSystem::stackingOrder();
-
-    for (const auto& window: windows) {
-        KWindowInfo info(window, NET::WMVisibleName, NET::WM2Activities);
-        const QStringList activities = info.activities();
+    connect(&LastUsedStore::self(), &LastUsedStore::lastUsedChanged,
+            this,                   &SortedActivitiesModel::onLastUsedChanged);
 
-        if (activities.isEmpty() || activities.contains("00000000-0000-0000-0000-000000000000")) continue;
-
-        for (const auto& activity: activities) {
-            m_activitiesWindows[activity] << window;
-        }
-    }
-
-    connect(KWindowSystem::self(), &KWindowSystem::windowAdded,
-            this,                  &SortedActivitiesModel::onWindowAdded);
-    connect(KWindowSystem::self(), &KWindowSystem::windowRemoved,
-            this,                  &SortedActivitiesModel::onWindowRemoved);
-    connect(KWindowSystem::self(), SIGNAL(windowChanged(WId, NET::Properties, NET::Properties2)),
-            this,                  SLOT(onWindowChanged(WId, NET::Properties, NET::Properties2)));
+    windows().subscribe(this);
 }
 
 SortedActivitiesModel::~SortedActivitiesModel()
 {
     backgrounds().unsubscribe(this);
+    windows().unsubscribe(this);
 }
 
 bool SortedActivitiesModel::inhibitUpdates() const
@@ -280,10 +595,7 @@ uint SortedActivitiesModel::lastUsedTime(const QString &activity) const
         return ~(uint)0;
 
     } else {
-        KConfig config("kactivitymanagerd-switcher", KConfig::SimpleConfig);
-        KConfigGroup times(&config, "LastUsed");
-
-        return times.readEntry(activity, (uint)0);
+        return LastUsedStore::self().lastUsed(activity);
     }
 }
 
@@ -357,11 +669,12 @@ QVariant SortedActivitiesModel::data(const QModelIndex &index, int role) const
 
     } else if (role == HasWindows || role == WindowCount) {
         const auto activity = activityIdForIndex(index);
+        const auto count = windows().windowCount.value(activity);
 
         if (role == HasWindows) {
-            return (m_activitiesWindows[activity].size() > 0);
+            return (count > 0);
         } else {
-            return m_activitiesWindows[activity].size();
+            return count;
         }
 
 
@@ -433,55 +746,30 @@ void SortedActivitiesModel::onCurrentActivityChanged(const QString &currentActiv
     emit rowChanged(currentActivityRow, { LastTimeUsed, LastTimeUsedString });
 }
 
-void SortedActivitiesModel::onBackgroundsUpdated(const QStringList &activities)
+void SortedActivitiesModel::onLastUsedChanged(const QStringList &activities)
 {
     for (const auto &activity: activities) {
         const int row = rowForActivityId(activity);
-        emit rowChanged(row, { KActivities::ActivitiesModel::ActivityBackground });
-    }
-}
-
-void SortedActivitiesModel::onWindowAdded(WId window)
-{
-    KWindowInfo info(window, 0, NET::WM2Activities);
-    const QStringList activities = info.activities();
-
-    if (activities.isEmpty() || activities.contains("00000000-0000-0000-0000-000000000000")) return;
-
-    for (const auto& activity: activities) {
-        if (!m_activitiesWindows[activity].contains(window)) {
-            m_activitiesWindows[activity] << window;
-
-            rowChanged(rowForActivityId(activity),
-                m_activitiesWindows.size() == 1
-                    ? QVector<int>{WindowCount, HasWindows}
-                    : QVector<int>{WindowCount});
-        }
+        emit rowChanged(row, { LastTimeUsed, LastTimeUsedString });
     }
 }
 
-void SortedActivitiesModel::onWindowRemoved(WId window)
+void SortedActivitiesModel::onBackgroundsUpdated(const QStringList &activities)
 {
-    for (const auto& activity: m_activitiesWindows.keys()) {
-        if (m_activitiesWindows[activity].contains(window)) {
-            m_activitiesWindows[activity].removeAll(window);
-
-            rowChanged(rowForActivityId(activity),
-                m_activitiesWindows.size() == 0
-                    ? QVector<int>{WindowCount, HasWindows}
-                    : QVector<int>{WindowCount});
-        }
+    for (const auto &activity: activities) {
+        const int row = rowForActivityId(activity);
+        emit rowChanged(row, { KActivities::ActivitiesModel::ActivityBackground });
     }
 }
 
-void SortedActivitiesModel::onWindowChanged(WId window, NET::Properties properties, NET::Properties2 properties2)
+void SortedActivitiesModel::onWindowCountChanged(const QString &activity, int count)
 {
-    Q_UNUSED(properties);
-
-    if (properties2 & NET::WM2Activities) {
-        onWindowRemoved(window);
-        onWindowAdded(window);
-    }
+    // HasWindows changes only when we get the first window,
+    // or when the last one is gone
+    rowChanged(rowForActivityId(activity),
+        count <= 1
+            ? QVector<int>{WindowCount, HasWindows}
+            : QVector<int>{WindowCount});
 }
 
 void SortedActivitiesModel::rowChanged(int row, const QVector<int> &roles)
@@ -65,6 +65,7 @@ public Q_SLOTS:
 
     void onBackgroundsUpdated(const QStringList &changedBackgrounds);
     void onCurrentActivityChanged(const QString &currentActivity);
+    void onLastUsedChanged(const QStringList &activities);
 
     QString activityIdForRow(int row) const;
     QString activityIdForIndex(const QModelIndex &index) const;
@@ -72,9 +73,7 @@ public Q_SLOTS:
 
     void rowChanged(int row, const QVector<int> &roles);
 
-    void onWindowAdded(WId window);
-    void onWindowRemoved(WId window);
-    void onWindowChanged(WId window, NET::Properties properties, NET::Properties2 properties2);
+    void onWindowCountChanged(const QString &activity, int count);
 
 Q_SIGNALS:
     void inhibitUpdatesChanged(bool inhibitUpdates);
@@ -86,8 +85,6 @@ private:
 
     KActivities::ActivitiesModel *m_activitiesModel;
     KActivities::Consumer *m_activities;
-
-    QHash<QString, QVector<WId>> m_activitiesWindows;
 };
 
 #endif // SORTED_ACTIVITY_MODEL
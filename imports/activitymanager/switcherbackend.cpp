@@ -23,6 +23,9 @@
 // Self
 #include "switcherbackend.h"
 
+// Local
+#include "lastusedstore.h"
+
 // Qt
 #include <QAction>
 #include <QX11Info>
@@ -37,8 +40,6 @@
 #include <kglobalaccel.h>
 #include <klocalizedstring.h>
 #include <KIO/PreviewJob>
-#include <KConfig>
-#include <KConfigGroup>
 
 // X11
 #include <X11/keysym.h>
@@ -372,24 +373,21 @@ void SwitcherBackend::onCurrentActivityChanged(const QString &id)
     KActivities::Info activity(id);
     emit showSwitchNotification(id, activity.name(), activity.icon());
 
-    KConfig config("kactivitymanagerd-switcher");
-    KConfigGroup times(&config, "LastUsed");
+    auto &times = LastUsedStore::self();
 
     const auto now = QDateTime::currentDateTime().toTime_t();
 
     // Updating the time for the activity we just switched to
     // in the case we do not power off properly, and on the next
     // start, kamd switches to another activity for some reason
-    times.writeEntry(id, now);
+    times.setLastUsed(id, now);
 
     if (!m_previousActivity.isEmpty()) {
         // When leaving an activity, say goodbye and fondly remember
         // the last time we saw it
-        times.writeEntry(m_previousActivity, now);
+        times.setLastUsed(m_previousActivity, now);
     }
 
-    times.sync();
-
     m_previousActivity = id;
 }
 
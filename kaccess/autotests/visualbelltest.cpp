@@ -0,0 +1,147 @@
+/*
+    Copyright 2017 The KDE Project
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QApplication>
+#include <QtTest>
+#include <QX11Info>
+
+#include "visualbell.h"
+
+#include <X11/Xlib.h>
+
+// Long enough that a burst is fired well within a single flash
+static const int s_pause = 500;
+
+class VisualBellTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testBurstIsCoalesced_data();
+    void testBurstIsCoalesced();
+    void testFlashAfterPause();
+    void testGeometryFollowsArea();
+    void benchmarkBurst_data();
+    void benchmarkBurst();
+};
+
+void VisualBellTest::initTestCase()
+{
+    if (!QX11Info::isPlatformX11()) {
+        QSKIP("The visible bell needs an X server, run under Xvfb");
+    }
+}
+
+void VisualBellTest::testBurstIsCoalesced_data()
+{
+    QTest::addColumn<bool>("invert");
+
+    QTest::newRow("color") << false;
+    QTest::newRow("invert") << true;
+}
+
+void VisualBellTest::testBurstIsCoalesced()
+{
+    QFETCH(bool, invert);
+
+    VisualBell bell(s_pause);
+    const QRect area(10, 10, 300, 200);
+
+    int flashes = 0;
+    for (int i = 0; i < 100; i++) {
+        if (bell.ring(area, invert, Qt::red)) {
+            flashes++;
+        }
+    }
+
+    QCOMPARE(flashes, 1);
+    QVERIFY(bell.isVisible());
+}
+
+void VisualBellTest::testFlashAfterPause()
+{
+    VisualBell bell(50);
+    const QRect area(0, 0, 100, 100);
+
+    QVERIFY(bell.ring(area, true, Qt::red));
+    QVERIFY(!bell.ring(area, true, Qt::red));
+
+    // The flash hides by itself, the next bell flashes again
+    QTRY_VERIFY(!bell.isVisible());
+    QVERIFY(bell.ring(area, true, Qt::red));
+}
+
+void VisualBellTest::testGeometryFollowsArea()
+{
+    VisualBell bell(50);
+
+    QVERIFY(bell.ring(QRect(0, 0, 100, 100), false, Qt::red));
+    QTRY_VERIFY(!bell.isVisible());
+
+    const QRect area(20, 30, 200, 150);
+    QVERIFY(bell.ring(area, true, Qt::red));
+    QCOMPARE(bell.geometry(), area);
+
+    // Nothing to flash for an unknown window
+    QTRY_VERIFY(!bell.isVisible());
+    QVERIFY(!bell.ring(QRect(), true, Qt::red));
+    QVERIFY(!bell.isVisible());
+}
+
+void VisualBellTest::benchmarkBurst_data()
+{
+    testBurstIsCoalesced_data();
+}
+
+void VisualBellTest::benchmarkBurst()
+{
+    QFETCH(bool, invert);
+
+    VisualBell bell(s_pause);
+    const QRect area(0, 0, 800, 600);
+
+    // Like a terminal printing a file full of BEL characters
+    QBENCHMARK {
+        bell.hide();
+        for (int i = 0; i < 50; i++) {
+            bell.ring(area, invert, Qt::red);
+        }
+        // Wait until the server has done the work
+        XSync(QX11Info::display(), False);
+    }
+}
+
+// Like QTEST_MAIN, but without a display the xcb platform would abort
+// before initTestCase() gets to skip, so fall back to offscreen then
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    app.setAttribute(Qt::AA_Use96Dpi, true);
+    VisualBellTest test;
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "visualbelltest.moc"
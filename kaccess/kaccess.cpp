@@ -22,6 +22,7 @@
 #include <unistd.h>
 
 #include "kaccess.h"
+#include "visualbell.h"
 
 #include <QtCore/qprocess.h>
 #include <QTimer>
@@ -147,6 +148,8 @@ KAccessApp::KAccessApp(bool allowStyles, bool GUIenabled)
     m_error = false;
     _activeWindow = KWindowSystem::activeWindow();
     connect(KWindowSystem::self(), &KWindowSystem::activeWindowChanged, this, &KAccessApp::activeWindowChanged);
+    connect(KWindowSystem::self(), static_cast<void (KWindowSystem::*)(WId, NET::Properties, NET::Properties2)>(&KWindowSystem::windowChanged),
+            this, &KAccessApp::windowChanged);
 
     features = 0;
     requestedFeatures = 0;
@@ -451,16 +454,30 @@ bool KAccessApp::nativeEventFilter(const QByteArray& eventType, void* message, l
 }
 
 
-void VisualBell::paintEvent(QPaintEvent *event)
+void KAccessApp::activeWindowChanged(WId wid)
 {
-    QWidget::paintEvent(event);
-    QTimer::singleShot(_pause, this, &QWidget::hide);
+    _activeWindow = wid;
+    _activeWindowGeometry = QRect();
 }
 
+void KAccessApp::windowChanged(WId wid, NET::Properties properties)
+{
+    if (wid == _activeWindow && (properties & (NET::WMGeometry | NET::WMFrameExtents)))
+        _activeWindowGeometry = QRect();
+}
 
-void KAccessApp::activeWindowChanged(WId wid)
+QRect KAccessApp::activeWindowGeometry()
 {
-    _activeWindow = wid;
+    if (!_activeWindowGeometry.isValid()) {
+        NETRect frame, window;
+        NETWinInfo net(QX11Info::connection(), _activeWindow, desktop()->winId(), 0);
+
+        net.kdeGeometry(frame, window);
+
+        _activeWindowGeometry = QRect(window.pos.x, window.pos.y, window.size.width, window.size.height);
+    }
+
+    return _activeWindowGeometry;
 }
 
 
@@ -511,42 +528,8 @@ void KAccessApp::xkbBellNotify(xcb_xkb_bell_notify_event_t *event)
         if (!overlay)
             overlay = new VisualBell(_visibleBellPause);
 
-        WId id = _activeWindow;
-
-        NETRect frame, window;
-        NETWinInfo net(QX11Info::connection(), id, desktop()->winId(), 0);
-
-        net.kdeGeometry(frame, window);
-
-        overlay->setGeometry(window.pos.x, window.pos.y, window.size.width, window.size.height);
-
-        if (_visibleBellInvert) {
-            QPixmap screen = QPixmap::grabWindow(id, 0, 0, window.size.width, window.size.height);
-#ifdef __GNUC__
-#warning is this the best way to invert a pixmap?
-#endif
-//    QPixmap invert(window.size.width, window.size.height);
-            QImage i = screen.toImage();
-            i.invertPixels();
-            QPalette pal = overlay->palette();
-            pal.setBrush(overlay->backgroundRole(), QBrush(QPixmap::fromImage(i)));
-            overlay->setPalette(pal);
-            /*
-                  QPainter p(&invert);
-                  p.setRasterOp(QPainter::NotCopyROP);
-                  p.drawPixmap(0, 0, screen);
-                  overlay->setBackgroundPixmap(invert);
-            */
-        } else {
-            QPalette pal = overlay->palette();
-            pal.setColor(overlay->backgroundRole(), _visibleBellColor);
-            overlay->setPalette(pal);
-        }
-
-        // flash the overlay widget
-        overlay->raise();
-        overlay->show();
-        flush();
+        if (overlay->ring(activeWindowGeometry(), _visibleBellInvert, _visibleBellColor))
+            flush();
     }
 
     // ask Phonon to ring a nice bell
@@ -556,7 +539,9 @@ void KAccessApp::xkbBellNotify(xcb_xkb_bell_notify_event_t *event)
             _player->setParent(this);
             _player->setCurrentSource(_currentPlayerSource);
         }
-        _player->play();
+        // a burst of bells plays the sound once, not restarted for every bell
+        if (_player->state() != Phonon::PlayingState)
+            _player->play();
     }
 }
 
@@ -27,13 +27,15 @@
 #include <QWidget>
 #include <QColor>
 #include <QLabel>
-#include <QPaintEvent>
+#include <QRect>
 
 
 #include <KUniqueApplication>
 
 #include <phonon/MediaObject>
 
+#include <netwm_def.h>
+
 #include <X11/Xlib.h>
 #define explicit int_explicit        // avoid compiler name clash in XKBlib.h
 #include <xcb/xkb.h>
@@ -44,6 +46,7 @@
 class QLabel;
 class KDialog;
 class KComboBox;
+class VisualBell;
 
 class KAccessApp : public KUniqueApplication, QAbstractNativeEventFilter
 {
@@ -71,6 +74,7 @@ protected:
 private Q_SLOTS:
 
     void activeWindowChanged(WId wid);
+    void windowChanged(WId wid, NET::Properties properties);
     void notifyChanges();
     void applyChanges();
     void yesClicked();
@@ -82,6 +86,7 @@ private:
     void createDialogContents();
     void initMasks();
     void setScreenReaderEnabled(bool enabled);
+    QRect activeWindowGeometry();
 
     int xkb_opcode;
     unsigned int features;
@@ -94,12 +99,15 @@ private:
     bool    _gestures, _gestureConfirmation;
     bool    _kNotifyModifiers, _kNotifyAccessX;
 
-    QWidget *overlay;
+    VisualBell *overlay;
 
     Phonon::MediaObject *_player;
     QString _currentPlayerSource;
 
     WId _activeWindow;
+    // Geometry of the active window, invalid until the next bell after
+    // the window manager told us it changed
+    QRect _activeWindowGeometry;
 
     KDialog *dialog;
     QLabel *featuresLabel;
@@ -113,29 +121,4 @@ private:
 };
 
 
-class VisualBell : public QWidget
-{
-    Q_OBJECT
-
-public:
-
-    VisualBell(int pause)
-        : QWidget((QWidget*)0, Qt::X11BypassWindowManagerHint), _pause(pause)
-    {}
-
-
-protected:
-
-    void paintEvent(QPaintEvent *) Q_DECL_OVERRIDE;
-
-
-private:
-
-    int _pause;
-
-};
-
-
-
-
 #endif
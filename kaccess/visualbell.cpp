@@ -0,0 +1,201 @@
+/*
+    Copyright 2000 Matthias Hölzer-Klüpfel <hoelzer@kde.org>
+    Copyright 2017 The KDE Project
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "visualbell.h"
+
+#include <config-X11.h>
+
+#include <QX11Info>
+
+#include <X11/Xlib.h>
+#ifdef HAVE_XRENDER
+#include <X11/extensions/Xrender.h>
+
+static XRenderColor renderColor(const QColor &color)
+{
+    XRenderColor c;
+    c.red = color.red() * 0x101;
+    c.green = color.green() * 0x101;
+    c.blue = color.blue() * 0x101;
+    c.alpha = 0xffff;
+    return c;
+}
+#endif
+
+VisualBell::VisualBell(int pause)
+    : QWidget((QWidget*)0, Qt::X11BypassWindowManagerHint),
+      _rootPicture(None), _pixmap(None), _pixmapPicture(None), _windowPicture(None)
+{
+    // We draw the window ourselves, Qt must not paint over it
+    setAttribute(Qt::WA_PaintOnScreen);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    _hideTimer.setSingleShot(true);
+    _hideTimer.setInterval(pause);
+    connect(&_hideTimer, &QTimer::timeout, this, &QWidget::hide);
+}
+
+VisualBell::~VisualBell()
+{
+    Display *dpy = QX11Info::display();
+
+    releasePixmap();
+#ifdef HAVE_XRENDER
+    if (_windowPicture != None)
+        XRenderFreePicture(dpy, _windowPicture);
+    if (_rootPicture != None)
+        XRenderFreePicture(dpy, _rootPicture);
+#endif
+}
+
+QPaintEngine *VisualBell::paintEngine() const
+{
+    return 0;
+}
+
+void VisualBell::releasePixmap()
+{
+    Display *dpy = QX11Info::display();
+
+#ifdef HAVE_XRENDER
+    if (_pixmapPicture != None)
+        XRenderFreePicture(dpy, _pixmapPicture);
+#endif
+    if (_pixmap != None)
+        XFreePixmap(dpy, _pixmap);
+
+    _pixmapPicture = None;
+    _pixmap = None;
+    _pixmapSize = QSize();
+}
+
+void VisualBell::preparePixmap(const QSize &size)
+{
+    // Bells mostly hit the same window, so the pixmap is kept for the next one
+    if (_pixmap != None && _pixmapSize == size)
+        return;
+
+    releasePixmap();
+
+    Display *dpy = QX11Info::display();
+    const int screen = QX11Info::appScreen();
+
+    _pixmap = XCreatePixmap(dpy, QX11Info::appRootWindow(screen), size.width(), size.height(),
+                            DefaultDepth(dpy, screen));
+#ifdef HAVE_XRENDER
+    XRenderPictFormat *format = XRenderFindVisualFormat(dpy, DefaultVisual(dpy, screen));
+    _pixmapPicture = XRenderCreatePicture(dpy, _pixmap, format, 0, 0);
+#endif
+    _pixmapSize = size;
+}
+
+bool VisualBell::ring(const QRect &area, bool invert, const QColor &color)
+{
+    // One flash at a time, a burst of bells within it only shows once
+    if (isVisible())
+        return false;
+
+    if (area.isEmpty())
+        return false;
+
+    Display *dpy = QX11Info::display();
+    const int screen = QX11Info::appScreen();
+
+    preparePixmap(area.size());
+
+#ifdef HAVE_XRENDER
+    if (invert) {
+        if (_rootPicture == None) {
+            XRenderPictureAttributes attributes;
+            attributes.subwindow_mode = IncludeInferiors;
+            _rootPicture = XRenderCreatePicture(dpy, QX11Info::appRootWindow(screen),
+                                                XRenderFindVisualFormat(dpy, DefaultVisual(dpy, screen)),
+                                                CPSubwindowMode, &attributes);
+        }
+
+        // Copy what is on screen now, before the overlay covers it, then
+        // invert it: white minus the contents
+        XRenderComposite(dpy, PictOpSrc, _rootPicture, None, _pixmapPicture,
+                         area.x(), area.y(), 0, 0, 0, 0, area.width(), area.height());
+        const XRenderColor white = renderColor(Qt::white);
+        XRenderFillRectangle(dpy, PictOpDifference, _pixmapPicture, &white,
+                             0, 0, area.width(), area.height());
+    } else {
+        const XRenderColor c = renderColor(color);
+        XRenderFillRectangle(dpy, PictOpSrc, _pixmapPicture, &c,
+                             0, 0, area.width(), area.height());
+    }
+#else
+    // Without XRender the core protocol does the same on TrueColor visuals
+    XGCValues values;
+    values.subwindow_mode = IncludeInferiors;
+    GC gc = XCreateGC(dpy, _pixmap, GCSubwindowMode, &values);
+
+    if (invert) {
+        XCopyArea(dpy, QX11Info::appRootWindow(screen), _pixmap, gc,
+                  area.x(), area.y(), area.width(), area.height(), 0, 0);
+        XSetFunction(dpy, gc, GXinvert);
+    } else {
+        XColor c;
+        c.red = color.red() * 0x101;
+        c.green = color.green() * 0x101;
+        c.blue = color.blue() * 0x101;
+        c.flags = DoRed | DoGreen | DoBlue;
+        if (XAllocColor(dpy, DefaultColormap(dpy, screen), &c))
+            XSetForeground(dpy, gc, c.pixel);
+    }
+    XFillRectangle(dpy, _pixmap, gc, 0, 0, area.width(), area.height());
+    XFreeGC(dpy, gc);
+#endif
+
+    setGeometry(area);
+    raise();
+    show();
+    _hideTimer.start();
+
+    return true;
+}
+
+void VisualBell::paintEvent(QPaintEvent *)
+{
+    if (_pixmap == None)
+        return;
+
+    Display *dpy = QX11Info::display();
+
+#ifdef HAVE_XRENDER
+    if (_windowPicture == None) {
+        const int screen = QX11Info::appScreen();
+        _windowPicture = XRenderCreatePicture(dpy, winId(),
+                                              XRenderFindVisualFormat(dpy, DefaultVisual(dpy, screen)),
+                                              0, 0);
+    }
+
+    XRenderComposite(dpy, PictOpSrc, _pixmapPicture, None, _windowPicture,
+                     0, 0, 0, 0, 0, 0, _pixmapSize.width(), _pixmapSize.height());
+#else
+    GC gc = XCreateGC(dpy, winId(), 0, 0);
+    XCopyArea(dpy, _pixmap, winId(), gc, 0, 0, _pixmapSize.width(), _pixmapSize.height(), 0, 0);
+    XFreeGC(dpy, gc);
+#endif
+    XFlush(dpy);
+}
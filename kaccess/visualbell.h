@@ -0,0 +1,79 @@
+/*
+    Copyright 2000 Matthias Hölzer-Klüpfel <hoelzer@kde.org>
+    Copyright 2017 The KDE Project
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) version 3, or any
+    later version accepted by the membership of KDE e.V. (or its
+    successor approved by the membership of KDE e.V.), which shall
+    act as a proxy defined in Section 6 of version 3 of the license.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __VISUAL_BELL_H__
+#define __VISUAL_BELL_H__
+
+#include <QColor>
+#include <QRect>
+#include <QTimer>
+#include <QWidget>
+
+/**
+ * Flashes an area of the screen for the visible bell.
+ *
+ * The flash is prepared entirely on the X server: the area is copied
+ * from the root window and inverted with XRender (or the core protocol
+ * when XRender is missing), or filled with a color, so no window contents
+ * are transferred to the client. Bells that ring while a flash is still
+ * shown are merged into it.
+ */
+class VisualBell : public QWidget
+{
+    Q_OBJECT
+
+public:
+
+    explicit VisualBell(int pause);
+    ~VisualBell();
+
+    /**
+     * Flashes @p area, inverted or filled with @p color.
+     * Returns false if the bell was merged into a flash that is still shown.
+     */
+    bool ring(const QRect &area, bool invert, const QColor &color);
+
+    QPaintEngine *paintEngine() const Q_DECL_OVERRIDE;
+
+
+protected:
+
+    void paintEvent(QPaintEvent *) Q_DECL_OVERRIDE;
+
+
+private:
+
+    void preparePixmap(const QSize &size);
+    void releasePixmap();
+
+    QTimer _hideTimer;
+
+    // Server side resources, the flash is rendered into the pixmap before
+    // the overlay is mapped and copied to the window when it is exposed
+    unsigned long _rootPicture;
+    unsigned long _pixmap;
+    unsigned long _pixmapPicture;
+    unsigned long _windowPicture;
+    QSize _pixmapSize;
+
+};
+
+#endif
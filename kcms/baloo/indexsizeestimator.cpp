@@ -0,0 +1,254 @@
+/* This file is part of the KDE Project
+   Copyright (c) 2017 The KDE Project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "indexsizeestimator.h"
+#include "fileexcludefilters.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent>
+
+using namespace Baloo;
+
+namespace
+{
+// At most this many folders are walked at the same time
+const int s_maxThreads = 2;
+
+// Entries looked at per second, summed over all workers
+const int s_maxEntriesPerSecond = 20000;
+
+// Workers publish their numbers every this many entries
+const int s_publishInterval = 1000;
+
+/**
+ * Turns the exclude filters into a single expression, so a file name is
+ * matched once instead of once per filter.
+ */
+QRegularExpression compileFilters(const QStringList& filters)
+{
+    QStringList patterns;
+    Q_FOREACH (const QString& filter, filters) {
+        QString pattern;
+        for (const QChar c : filter) {
+            if (c == QLatin1Char('*')) {
+                pattern += QLatin1String(".*");
+            } else if (c == QLatin1Char('?')) {
+                pattern += QLatin1Char('.');
+            } else {
+                pattern += QRegularExpression::escape(QString(c));
+            }
+        }
+        patterns << pattern;
+    }
+
+    QRegularExpression regExp(QStringLiteral("^(?:") + patterns.join(QLatin1Char('|')) + QStringLiteral(")$"));
+    regExp.optimize();
+    return regExp;
+}
+
+/**
+ * Whether the indexer would extract the content of files of this type,
+ * as opposed to only their name and basic metadata.
+ */
+bool hasIndexableContent(const QMimeType& mimeType)
+{
+    const QString name = mimeType.name();
+    return mimeType.inherits(QStringLiteral("text/plain"))
+        || name == QLatin1String("application/pdf")
+        || name == QLatin1String("application/epub+zip")
+        || name == QLatin1String("application/msword")
+        || name.startsWith(QLatin1String("application/vnd.oasis.opendocument."))
+        || name.startsWith(QLatin1String("application/vnd.openxmlformats-officedocument."))
+        || name.startsWith(QLatin1String("application/vnd.ms-"));
+}
+}
+
+struct IndexSizeEstimator::Walk {
+    QRegularExpression excludeFilters;
+    QSet<QString> excludeMimetypes;
+    // Excluded folders, and included ones that get their own worker
+    QSet<QString> skipFolders;
+    bool contentIndexing;
+};
+
+IndexSizeEstimator::IndexSizeEstimator(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(s_maxThreads);
+
+    m_progressTimer.setInterval(250);
+    connect(&m_progressTimer, &QTimer::timeout, this, &IndexSizeEstimator::checkProgress);
+}
+
+IndexSizeEstimator::~IndexSizeEstimator()
+{
+    cancel();
+}
+
+void IndexSizeEstimator::start(const QStringList& includeFolders, const QStringList& excludeFolders,
+                               bool contentIndexing)
+{
+    cancel();
+
+    Walk walk;
+    walk.excludeFilters = compileFilters(defaultExcludeFilterList());
+    walk.excludeMimetypes = defaultExcludeMimetypes().toSet();
+    walk.contentIndexing = contentIndexing;
+
+    Q_FOREACH (const QString& folder, excludeFolders) {
+        walk.skipFolders << QDir::cleanPath(folder);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_estimates.clear();
+        Q_FOREACH (const QString& folder, includeFolders) {
+            m_estimates.insert(QDir::cleanPath(folder), Estimate());
+        }
+    }
+
+    m_cancelled = 0;
+
+    Q_FOREACH (const QString& folder, includeFolders) {
+        const QString root = QDir::cleanPath(folder);
+
+        Walk folderWalk = walk;
+        Q_FOREACH (const QString& other, includeFolders) {
+            const QString otherRoot = QDir::cleanPath(other);
+            if (otherRoot != root) {
+                folderWalk.skipFolders << otherRoot;
+            }
+        }
+
+        m_running.ref();
+        QtConcurrent::run(&m_pool, [this, root, folderWalk]() {
+            this->walk(root, folderWalk);
+            m_running.deref();
+        });
+    }
+
+    m_progressTimer.start();
+}
+
+void IndexSizeEstimator::cancel()
+{
+    m_cancelled = 1;
+    m_pool.waitForDone();
+    m_progressTimer.stop();
+}
+
+bool IndexSizeEstimator::isRunning() const
+{
+    return m_running.load() > 0;
+}
+
+QHash<QString, IndexSizeEstimator::Estimate> IndexSizeEstimator::estimates() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_estimates;
+}
+
+void IndexSizeEstimator::checkProgress()
+{
+    Q_EMIT progress();
+
+    if (!isRunning()) {
+        m_progressTimer.stop();
+        Q_EMIT finished();
+    }
+}
+
+void IndexSizeEstimator::walk(const QString& folder, const Walk& walk)
+{
+    QMimeDatabase mimeDb;
+    Estimate estimate;
+
+    const qint64 entriesPerSecond = s_maxEntriesPerSecond / s_maxThreads;
+    qint64 entries = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    auto publish = [&]() {
+        QMutexLocker locker(&m_mutex);
+        m_estimates.insert(folder, estimate);
+    };
+
+    QStringList folders;
+    folders << folder;
+
+    while (!folders.isEmpty() && !m_cancelled.load()) {
+        const QString dir = folders.takeLast();
+
+        QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+        while (it.hasNext() && !m_cancelled.load()) {
+            const QString path = it.next();
+            const QFileInfo info = it.fileInfo();
+            const QString name = info.fileName();
+
+            ++entries;
+
+            // Keep within our share of the I/O budget
+            if (entries % 64 == 0) {
+                const qint64 due = entries * 1000 / entriesPerSecond;
+                while (timer.elapsed() < due && !m_cancelled.load()) {
+                    QThread::msleep(qMin<qint64>(due - timer.elapsed(), 100));
+                }
+            }
+
+            if (entries % s_publishInterval == 0) {
+                publish();
+            }
+
+            // Like the indexer, skip hidden files and folders
+            if (name.startsWith(QLatin1Char('.')) || walk.excludeFilters.match(name).hasMatch()) {
+                continue;
+            }
+
+            if (info.isDir()) {
+                if (!walk.skipFolders.contains(path)) {
+                    folders << path;
+                }
+                continue;
+            }
+
+            const QMimeType mimeType = mimeDb.mimeTypeForFile(info, QMimeDatabase::MatchExtension);
+            if (walk.excludeMimetypes.contains(mimeType.name())) {
+                continue;
+            }
+
+            const qint64 size = info.size();
+            ++estimate.files;
+            estimate.bytes += size;
+
+            if (walk.contentIndexing && hasIndexableContent(mimeType)) {
+                estimate.contentBytes += size;
+            }
+        }
+    }
+
+    estimate.done = !m_cancelled.load();
+    publish();
+}
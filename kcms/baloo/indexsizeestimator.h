@@ -0,0 +1,93 @@
+/* This file is part of the KDE Project
+   Copyright (c) 2017 The KDE Project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _BALOO_INDEX_SIZE_ESTIMATOR_H_
+#define _BALOO_INDEX_SIZE_ESTIMATOR_H_
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace Baloo
+{
+
+/**
+ * Walks the folders that would be indexed with a given configuration and
+ * adds up what the indexer would have to go through, so exclusions can be
+ * tuned before they are saved.
+ *
+ * Every included folder is walked in its own worker thread. The workers
+ * skip what the indexer would skip, never follow symlinks and only stat
+ * a limited number of entries per second, so estimating a large home
+ * directory does not starve the rest of the system of I/O.
+ */
+class IndexSizeEstimator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Estimate {
+        qint64 files = 0;
+        qint64 bytes = 0;
+        /// Bytes of files whose content would be extracted
+        qint64 contentBytes = 0;
+        bool done = false;
+    };
+
+    explicit IndexSizeEstimator(QObject* parent = 0);
+    ~IndexSizeEstimator();
+
+    /**
+     * Cancels a running estimate and starts a new one.
+     * The default exclude filters and mimetypes are always applied.
+     */
+    void start(const QStringList& includeFolders, const QStringList& excludeFolders,
+               bool contentIndexing);
+    void cancel();
+
+    bool isRunning() const;
+
+    /// The estimates so far, by included folder
+    QHash<QString, Estimate> estimates() const;
+
+Q_SIGNALS:
+    void progress();
+    void finished();
+
+private:
+    struct Walk;
+
+    void walk(const QString& folder, const Walk& walk);
+    void checkProgress();
+
+    QThreadPool m_pool;
+    QTimer m_progressTimer;
+    QAtomicInt m_cancelled;
+    QAtomicInt m_running;
+
+    mutable QMutex m_mutex;
+    QHash<QString, Estimate> m_estimates;
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "kcm.h"
 #include "fileexcludefilters.h"
 #include "folderselectionwidget.h"
+#include "indexsizeestimator.h"
 
 #include <KPluginFactory>
 #include <KPluginLoader>
@@ -27,6 +28,7 @@
 #include <QDebug>
 #include <QStandardPaths>
 #include <KLocalizedString>
+#include <KFormat>
 
 #include <QPushButton>
 #include <QDir>
@@ -55,6 +57,7 @@ using namespace Baloo;
 
 ServerConfigModule::ServerConfigModule(QWidget* parent, const QVariantList& args)
     : KCModule(parent, args)
+    , m_estimator(new IndexSizeEstimator(this))
 {
     KAboutData* about = new KAboutData(
         QStringLiteral("kcm_baloofile"), i18n("Configure File Search"),
@@ -77,6 +80,20 @@ ServerConfigModule::ServerConfigModule(QWidget* parent, const QVariantList& args
             this, SLOT(changed()));
     connect(m_enableCheckbox, SIGNAL(stateChanged(int)),
             this, SLOT(indexingEnabledChanged()));
+
+    // Give the user a chance to finish editing before walking the folders
+    m_estimateTimer.setSingleShot(true);
+    m_estimateTimer.setInterval(500);
+    connect(&m_estimateTimer, &QTimer::timeout,
+            this, &ServerConfigModule::startEstimate);
+    connect(m_excludeFolders_FSW, &FolderSelectionWidget::changed,
+            &m_estimateTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_enableContentIndexing, &QCheckBox::stateChanged,
+            &m_estimateTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_estimator, &IndexSizeEstimator::progress,
+            this, &ServerConfigModule::updateEstimate);
+    connect(m_estimator, &IndexSizeEstimator::finished,
+            this, &ServerConfigModule::updateEstimate);
 }
 
 
@@ -99,6 +116,8 @@ void ServerConfigModule::load()
     QStringList excludeFolders = config.excludeFolders();
     m_excludeFolders_FSW->setDirectoryList(includeFolders, excludeFolders);
 
+    m_estimateTimer.start();
+
     // All values loaded -> no changes
     Q_EMIT changed(false);
 }
@@ -159,6 +178,60 @@ void ServerConfigModule::defaults()
 void ServerConfigModule::indexingEnabledChanged()
 {
     m_enableContentIndexing->setEnabled(m_enableCheckbox->isChecked());
+    m_estimateTimer.start();
+}
+
+void ServerConfigModule::startEstimate()
+{
+    if (!m_enableCheckbox->isChecked()) {
+        m_estimator->cancel();
+        m_estimateLabel->clear();
+        return;
+    }
+
+    m_estimator->start(m_excludeFolders_FSW->includeFolders(),
+                       m_excludeFolders_FSW->excludeFolders(),
+                       m_enableContentIndexing->isChecked());
+    updateEstimate();
+}
+
+void ServerConfigModule::updateEstimate()
+{
+    KFormat format;
+    QStringList lines;
+
+    const QHash<QString, IndexSizeEstimator::Estimate> estimates = m_estimator->estimates();
+    for (auto it = estimates.constBegin(); it != estimates.constEnd(); ++it) {
+        const IndexSizeEstimator::Estimate& estimate = it.value();
+
+        QString line;
+        if (m_enableContentIndexing->isChecked()) {
+            line = i18ncp("@info folder: number of files, their size, size of their content to index",
+                          "%2: %1 file, %3 (%4 of content)",
+                          "%2: %1 files, %3 (%4 of content)",
+                          estimate.files, it.key(),
+                          format.formatByteSize(estimate.bytes),
+                          format.formatByteSize(estimate.contentBytes));
+        } else {
+            line = i18ncp("@info folder: number of files, their size",
+                          "%2: %1 file, %3",
+                          "%2: %1 files, %3",
+                          estimate.files, it.key(),
+                          format.formatByteSize(estimate.bytes));
+        }
+
+        if (!estimate.done) {
+            line = i18nc("@info estimate that is still being computed", "%1…", line);
+        }
+
+        lines << line;
+    }
+
+    lines.sort();
+    if (!lines.isEmpty()) {
+        lines.prepend(i18n("Files to index:"));
+    }
+    m_estimateLabel->setText(lines.join(QLatin1Char('\n')));
 }
 
 void ServerConfigModule::onDirectoryListChanged()
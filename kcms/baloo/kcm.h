@@ -21,11 +21,14 @@
 #define _BALOO_FILE_KCM_H_
 
 #include <KCModule>
+#include <QTimer>
 #include "ui_configwidget.h"
 
 namespace Baloo
 {
 
+class IndexSizeEstimator;
+
 class ServerConfigModule : public KCModule, private Ui::ConfigWidget
 {
     Q_OBJECT
@@ -42,7 +45,12 @@ public Q_SLOTS:
 
     void onDirectoryListChanged();
 private:
+    void startEstimate();
+    void updateEstimate();
+
     bool m_previouslyEnabled;
+    IndexSizeEstimator* m_estimator;
+    QTimer m_estimateTimer;
     /**
      * @brief Check if all mount points are in the excluded from indexing list.
      *
@@ -31,7 +31,12 @@
 #include <QStackedWidget>
 #include <QStandardPaths>
 #include <QPainter>
-#include <QBitmap>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QtConcurrentMap>
 #include <QtDBus/QtDBus>
 
 #include <KAboutData>
@@ -48,10 +53,27 @@
 K_PLUGIN_FACTORY( KolorFactory, registerPlugin<KColorCm>(); )
 K_EXPORT_PLUGIN( KolorFactory("kcmcolors") )
 
+namespace {
+
+struct CachedSchemeInfo
+{
+    QDateTime mtime;
+    ColorSchemeInfo info;
+};
+
+// shared by all instances of the module, keyed by file path
+QMutex s_schemeCacheMutex;
+QHash<QString, CachedSchemeInfo> s_schemeCache;
+
+}
+
 KColorCm::KColorCm(QWidget *parent, const QVariantList &)
     : KCModule( parent ),
       m_dontLoadSelectedScheme(false),
-      m_previousSchemeItem(0)
+      m_previousSchemeItem(0),
+      m_schemeWatcher(new QFutureWatcher<ColorSchemeInfo>(this)),
+      m_pendingSchemeInUse(false),
+      m_selectingSchemeInUse(false)
 {
     KAboutData* about = new KAboutData(
         QStringLiteral("kcmcolors"), i18n("Colors"), QStringLiteral("1.0"), QString(),
@@ -70,67 +92,142 @@ KColorCm::KColorCm(QWidget *parent, const QVariantList &)
     connect(schemeList, SIGNAL(currentItemChanged(QListWidgetItem*,QListWidgetItem*)),
             this, SLOT(loadScheme(QListWidgetItem*,QListWidgetItem*)));
     schemeKnsButton->setIcon( QIcon::fromTheme(QStringLiteral("get-hot-new-stuff")) );
+    connect(m_schemeWatcher, &QFutureWatcher<ColorSchemeInfo>::resultsReadyAt, this, &KColorCm::schemesReady);
+    connect(m_schemeWatcher, &QFutureWatcher<ColorSchemeInfo>::finished, this, [this]() {
+        m_pendingSchemeName.clear();
+    });
 }
 
 KColorCm::~KColorCm()
 {
+    m_schemeWatcher->cancel();
+    m_schemeWatcher->waitForFinished();
     m_config->markAsClean();
 }
 
 void KColorCm::populateSchemeList()
 {
+    // a previous run may still be reading files
+    m_schemeWatcher->cancel();
+    m_schemeWatcher->waitForFinished();
+
     // clear the list in case this is being called from reset button click
     schemeList->clear();
 
     // add entries
     QIcon icon;
 
+    // add default entry (do this here so that the current and default entry appear at the top)
+    m_config->setReadDefaults(true);
+    icon = createSchemePreviewIcon(m_config);
+    schemeList->insertItem(0, new QListWidgetItem(icon, i18nc("Default color scheme", "Default")));
+    m_config->setReadDefaults(false);
+
+    // add current scheme entry
+    icon = createSchemePreviewIcon(m_config);
+    QListWidgetItem *currentitem = new QListWidgetItem(icon, i18nc("Current color scheme", "Current"));
+    schemeList->insertItem(0, currentitem);
+
+    // locateAll() returns the directories by priority, so the first file
+    // with a given name is the one QStandardPaths::locate() would find
     QStringList schemeFiles;
+    QSet<QString> seenFiles;
     const QStringList schemeDirs = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("color-schemes"), QStandardPaths::LocateDirectory);
     Q_FOREACH (const QString &dir, schemeDirs)
     {
         const QStringList fileNames = QDir(dir).entryList(QStringList()<<QStringLiteral("*.colors"));
         Q_FOREACH (const QString &file, fileNames)
         {
-            if( !schemeFiles.contains("color-schemes/"+file))
+            if (!seenFiles.contains(file))
             {
-                schemeFiles.append("color-schemes/"+file);
+                seenFiles.insert(file);
+                schemeFiles.append(dir + QLatin1Char('/') + file);
             }
         }
     }
-    for (QStringList::Iterator it = schemeFiles.begin(); it != schemeFiles.end(); ++it )
+
+    // reading and painting hundreds of schemes takes a while, do it in
+    // the background and insert the entries as they come in
+    m_schemeWatcher->setFuture(QtConcurrent::mapped(schemeFiles, &KColorCm::loadSchemeInfo));
+}
+
+void KColorCm::schemesReady(int begin, int end)
+{
+    for (int i = begin; i < end; ++i)
     {
-        *it = QStandardPaths::locate(QStandardPaths::GenericDataLocation, *it);
+        const ColorSchemeInfo info = m_schemeWatcher->resultAt(i);
+
+        QListWidgetItem * newItem = new QListWidgetItem(QIcon(QPixmap::fromImage(info.preview)), info.name);
+        // stash the file basename for use later
+        newItem->setData(Qt::UserRole, info.baseName);
+
+        // keep the entries sorted below the current and default entry
+        int first = 2;
+        int last = schemeList->count();
+        while (first < last)
+        {
+            const int middle = (first + last) / 2;
+            if (*schemeList->item(middle) < *newItem)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        schemeList->insertItem(first, newItem);
+
+        if (!m_pendingSchemeName.isEmpty() && info.name == m_pendingSchemeName)
+        {
+            m_pendingSchemeName.clear();
+            setCurrentSchemeItem(newItem, m_pendingSchemeInUse);
+        }
     }
+}
 
-    for (int i = 0; i < schemeFiles.size(); ++i)
+void KColorCm::selectScheme(const QString &name, bool inUse)
+{
+    QList<QListWidgetItem*> itemList = schemeList->findItems(name, Qt::MatchExactly);
+    if (!itemList.isEmpty())
     {
-        // get the file name
-        const QString filename = schemeFiles.at(i);
-        const QFileInfo info(filename);
-
-        // add the entry
-        KSharedConfigPtr config = KSharedConfig::openConfig(filename);
-        icon = createSchemePreviewIcon(config);
-        KConfigGroup group(config, "General");
-        const QString name = group.readEntry("Name", info.baseName());
-        QListWidgetItem * newItem = new QListWidgetItem(icon, name);
-        // stash the file basename for use later
-        newItem->setData(Qt::UserRole, info.baseName());
-        schemeList->addItem(newItem);
+        m_pendingSchemeName.clear();
+        setCurrentSchemeItem(itemList.first(), inUse);
     }
-    schemeList->sortItems();
+    else if (m_schemeWatcher->isRunning())
+    {
+        m_pendingSchemeName = name;
+        m_pendingSchemeInUse = inUse;
+    }
+}
 
-    // add default entry (do this here so that the current and default entry appear at the top)
-    m_config->setReadDefaults(true);
-    icon = createSchemePreviewIcon(m_config);
-    schemeList->insertItem(0, new QListWidgetItem(icon, i18nc("Default color scheme", "Default")));
-    m_config->setReadDefaults(false);
+void KColorCm::setCurrentSchemeItem(QListWidgetItem *item, bool inUse)
+{
+    m_selectingSchemeInUse = inUse;
+    schemeList->setCurrentItem(item);
+    m_selectingSchemeInUse = false;
+}
 
-    // add current scheme entry
-    icon = createSchemePreviewIcon(m_config);
-    QListWidgetItem *currentitem = new QListWidgetItem(icon, i18nc("Current color scheme", "Current"));
-    schemeList->insertItem(0, currentitem);
+ColorSchemeInfo KColorCm::loadSchemeInfo(const QString &path)
+{
+    const QFileInfo fileInfo(path);
+    const QDateTime mtime = fileInfo.lastModified();
+
+    {
+        QMutexLocker locker(&s_schemeCacheMutex);
+        auto it = s_schemeCache.constFind(path);
+        if (it != s_schemeCache.constEnd() && it->mtime == mtime)
+            return it->info;
+    }
+
+    ColorSchemeInfo info;
+    info.path = path;
+    info.baseName = fileInfo.baseName();
+
+    KSharedConfigPtr config = KSharedConfig::openConfig(path);
+    KConfigGroup group(config, "General");
+    info.name = group.readEntry("Name", info.baseName);
+    info.preview = createSchemePreviewImage(config);
+
+    QMutexLocker locker(&s_schemeCacheMutex);
+    s_schemeCache.insert(path, CachedSchemeInfo{mtime, info});
+    return info;
 }
 
 
@@ -157,6 +254,9 @@ void KColorCm::loadScheme(QListWidgetItem *currentItem, QListWidgetItem *previou
         return;
     }
 
+    // the user picked something else before the background loader was done
+    m_pendingSchemeName.clear();
+
     if (currentItem != NULL)
     {
         // load it
@@ -173,7 +273,8 @@ void KColorCm::loadScheme(QListWidgetItem *currentItem, QListWidgetItem *previou
             config->setReadDefaults(false);
             schemeEditButton->setEnabled(true);
             // load the default scheme
-            emit changed(true);
+            if (!m_selectingSchemeInUse)
+                emit changed(true);
         }
         else if (name == i18nc("Current color scheme", "Current"))
         {
@@ -198,7 +299,8 @@ void KColorCm::loadScheme(QListWidgetItem *currentItem, QListWidgetItem *previou
             KSharedConfigPtr config = KSharedConfig::openConfig(path);
             loadScheme(config);
 
-            emit changed(true);
+            if (!m_selectingSchemeInUse)
+                emit changed(true);
         }
     } else {
         schemeEditButton->setEnabled(false);
@@ -282,11 +384,7 @@ void KColorCm::on_schemeImportButton_clicked()
     config2->sync();
 
     this->populateSchemeList();
-    QList<QListWidgetItem*> itemList = schemeList->findItems(newName, Qt::MatchExactly);
-    if (!itemList.isEmpty())
-    {
-        schemeList->setCurrentItem(itemList.first());
-    }
+    selectScheme(newName);
 }
 
 void KColorCm::on_schemeKnsButton_clicked()
@@ -300,17 +398,35 @@ void KColorCm::on_schemeKnsButton_clicked()
 }
 
 QPixmap KColorCm::createSchemePreviewIcon(const KSharedConfigPtr &config)
+{
+    return QPixmap::fromImage(createSchemePreviewImage(config));
+}
+
+// QBitmap based stipple brushes can't be used outside the GUI thread,
+// so build the same pattern as a colored texture
+static QBrush patternBrush(const QColor &color, const uchar *bits)
+{
+    QImage pattern(24, 2, QImage::Format_ARGB32_Premultiplied);
+    pattern.fill(Qt::transparent);
+    for (int y = 0; y < 2; ++y) {
+        for (int x = 0; x < 24; ++x) {
+            if (bits[y * 3 + x / 8] & (1 << (x % 8))) {
+                pattern.setPixel(x, y, color.rgba());
+            }
+        }
+    }
+    return QBrush(pattern);
+}
+
+QImage KColorCm::createSchemePreviewImage(const KSharedConfigPtr &config)
 {
     const uchar bits1[] = { 0xff, 0xff, 0xff, 0x2c, 0x16, 0x0b };
     const uchar bits2[] = { 0x68, 0x34, 0x1a, 0xff, 0xff, 0xff };
-    const QSize bitsSize(24,2);
-    const QBitmap b1 = QBitmap::fromData(bitsSize, bits1);
-    const QBitmap b2 = QBitmap::fromData(bitsSize, bits2);
 
-    QPixmap pixmap(23, 16);
-    pixmap.fill(Qt::black); // ### use some color other than black for borders?
+    QImage image(23, 16, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black); // ### use some color other than black for borders?
 
-    QPainter p(&pixmap);
+    QPainter p(&image);
 
     KConfigGroup group(config, "WM");
     // NOTE: keep this in sync with kdelibs/kdeui/kernel/kglobalsettings.cpp
@@ -321,29 +437,29 @@ QPixmap KColorCm::createSchemePreviewIcon(const KSharedConfigPtr &config)
 
     KColorScheme windowScheme(QPalette::Active, KColorScheme::Window, config);
     p.fillRect( 1,  1, 7, 7, windowScheme.background());
-    p.fillRect( 2,  2, 5, 2, QBrush(windowScheme.foreground().color(), b1));
+    p.fillRect( 2,  2, 5, 2, patternBrush(windowScheme.foreground().color(), bits1));
 
     KColorScheme buttonScheme(QPalette::Active, KColorScheme::Button, config);
     p.fillRect( 8,  1, 7, 7, buttonScheme.background());
-    p.fillRect( 9,  2, 5, 2, QBrush(buttonScheme.foreground().color(), b1));
+    p.fillRect( 9,  2, 5, 2, patternBrush(buttonScheme.foreground().color(), bits1));
 
     p.fillRect(15,  1, 7, 7, activeBackground);
-    p.fillRect(16,  2, 5, 2, QBrush(activeForeground, b1));
+    p.fillRect(16,  2, 5, 2, patternBrush(activeForeground, bits1));
 
     KColorScheme viewScheme(QPalette::Active, KColorScheme::View, config);
     p.fillRect( 1,  8, 7, 7, viewScheme.background());
-    p.fillRect( 2, 12, 5, 2, QBrush(viewScheme.foreground().color(), b2));
+    p.fillRect( 2, 12, 5, 2, patternBrush(viewScheme.foreground().color(), bits2));
 
     KColorScheme selectionScheme(QPalette::Active, KColorScheme::Selection, config);
     p.fillRect( 8,  8, 7, 7, selectionScheme.background());
-    p.fillRect( 9, 12, 5, 2, QBrush(selectionScheme.foreground().color(), b2));
+    p.fillRect( 9, 12, 5, 2, patternBrush(selectionScheme.foreground().color(), bits2));
 
     p.fillRect(15,  8, 7, 7, inactiveBackground);
-    p.fillRect(16, 12, 5, 2, QBrush(inactiveForeground, b2));
+    p.fillRect(16, 12, 5, 2, patternBrush(inactiveForeground, bits2));
 
     p.end();
 
-    return pixmap;
+    return image;
 }
 
 void KColorCm::load()
@@ -354,9 +470,8 @@ void KColorCm::load()
     KConfigGroup group(m_config, "General");
     m_currentColorScheme = group.readEntry("ColorScheme");
 
-    QList<QListWidgetItem*> itemList = schemeList->findItems(m_currentColorScheme, Qt::MatchExactly);
-    if(!itemList.isEmpty()) // "Default" is already selected, so don't handle the case that itemList is empty
-        schemeList->setCurrentItem(itemList.at(0));
+    // "Default" is already selected, so don't handle the case that there is no such item
+    selectScheme(m_currentColorScheme, true);
 
     KConfig cfg(QStringLiteral("kcmdisplayrc"), KConfig::NoGlobals);
     group = KConfigGroup(&cfg, "X11");
@@ -24,6 +24,9 @@
 
 #include <KCModule>
 
+#include <QFutureWatcher>
+#include <QImage>
+
 #include "ui_colorsettings.h"
 
 class QStackedWidget;
@@ -31,6 +34,17 @@ class QListWidgetItem;
 
 class KColorButton;
 
+/**
+ * What the scheme list shows about a color scheme file.
+ */
+struct ColorSchemeInfo
+{
+    QString path;
+    QString baseName;
+    QString name;
+    QImage preview;
+};
+
 
 /**
  * The Desktop/Colors tab in kcontrol.
@@ -102,6 +116,13 @@ private Q_SLOTS:
      * It opens a dialog for the edition/creation.
      */
     void on_schemeEditButton_clicked();
+
+    /**
+     * Slot called when the background loader has read more schemes.
+     *
+     * It inserts them into schemeList, keeping the list sorted.
+     */
+    void schemesReady(int begin, int end);
 private:
 
     /**
@@ -109,6 +130,26 @@ private:
      */
     static QPixmap createSchemePreviewIcon(const KSharedConfigPtr &config);
 
+    /**
+     * Paint the preview of a color scheme, safe to call from any thread
+     */
+    static QImage createSchemePreviewImage(const KSharedConfigPtr &config);
+
+    /**
+     * Read name and preview of the scheme at @p path, cached by modification time.
+     * Runs in a worker thread.
+     */
+    static ColorSchemeInfo loadSchemeInfo(const QString &path);
+
+    /**
+     * Select the scheme called @p name, now or as soon as the background
+     * loader has inserted it. If @p inUse is true the scheme is the one
+     * already applied, so selecting it does not mark the module changed.
+     */
+    void selectScheme(const QString &name, bool inUse = false);
+
+    void setCurrentSchemeItem(QListWidgetItem *item, bool inUse);
+
     /**
      * Load from global.
      */
@@ -136,6 +177,16 @@ private:
 
     // the item previously selected in schemeList
     QListWidgetItem *m_previousSchemeItem;
+
+    // reads the scheme files for schemeList in the background
+    QFutureWatcher<ColorSchemeInfo> *m_schemeWatcher;
+
+    // scheme to select once the background loader has found it
+    QString m_pendingSchemeName;
+    bool m_pendingSchemeInUse;
+
+    // the scheme being selected is the one in use, don't emit changed()
+    bool m_selectingSchemeInUse;
 };
 
 #endif
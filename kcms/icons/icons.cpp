@@ -321,14 +321,24 @@ void KIconConfig::preview(int i)
 
     int viewedGroup = (mUsage == KIconLoader::LastGroup) ? KIconLoader::FirstGroup : mUsage;
 
-    QPixmap pm = mpLoader->loadIcon(mExample, KIconLoader::NoGroup, mSizes[viewedGroup]);
-    QImage img = pm.toImage();
-
+    const int size = mSizes[viewedGroup];
     Effect &effect = mEffects[viewedGroup][i];
 
-    img = mpEffect->apply(img, effect.type,
-	    effect.value, effect.color, effect.color2, effect.transparent);
-    pm = QPixmap::fromImage(img);
+    // Switching the usage or state back and forth renders the same
+    // handful of previews over and over, so keep the results around
+    const QString key = QStringLiteral("%1_%2_%3_%4_%5_%6_%7")
+        .arg(size).arg(effect.type).arg(effect.value)
+        .arg(effect.color.rgba()).arg(effect.color2.rgba())
+        .arg(effect.transparent).arg(mExample);
+
+    QPixmap pm = mPreviewCache.value(key);
+    if (pm.isNull()) {
+        QImage img = mpLoader->loadIcon(mExample, KIconLoader::NoGroup, size).toImage();
+        img = mpEffect->apply(img, effect.type,
+	        effect.value, effect.color, effect.color2, effect.transparent);
+        pm = QPixmap::fromImage(img);
+        mPreviewCache.insert(key, pm);
+    }
     mpPreview[i]->setPixmap(pm);
 }
 
@@ -392,6 +402,8 @@ void KIconConfig::exportToKDE4()
 
 void KIconConfig::load()
 {
+    // the icon theme may have changed in the meantime
+    mPreviewCache.clear();
     read();
     apply();
     emit changed(false);
@@ -16,6 +16,8 @@
 #include <QColor>
 #include <QImage>
 #include <QDialog>
+#include <QHash>
+#include <QPixmap>
 
 #include <KCModule>
 #include <KSharedConfig>
@@ -99,6 +101,7 @@ private:
     KSharedConfigPtr mpConfig;
 
     QLabel *mpPreview[3];
+    QHash<QString, QPixmap> mPreviewCache;
 
     QListWidget *mpUsageList;
     QComboBox *mpSizeBox;
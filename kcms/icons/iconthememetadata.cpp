@@ -0,0 +1,216 @@
+/**
+ *  Copyright (c) 2017 The KDE Project
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "iconthememetadata.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTextStream>
+
+namespace {
+
+struct CacheEntry
+{
+    QDateTime mtime;
+    IconThemeMetaData data;
+};
+
+QMutex s_cacheMutex;
+QHash<QString, CacheEntry> s_cache;
+
+// Picks the best match for "Key[locale]" the same way KConfig does:
+// full locale first, then the language only, then the untranslated key.
+struct LocalizedValue
+{
+    QString plain;
+    QString language;
+    QString full;
+
+    QString value() const
+    {
+        if (!full.isEmpty()) {
+            return full;
+        }
+        if (!language.isEmpty()) {
+            return language;
+        }
+        return plain;
+    }
+
+    void set(const QString &locale, const QString &value)
+    {
+        static const QString fullLocale = QLocale().name();
+        static const QString languageOnly = fullLocale.section(QLatin1Char('_'), 0, 0);
+
+        if (locale.isEmpty()) {
+            plain = value;
+        } else if (locale == fullLocale) {
+            full = value;
+        } else if (locale == languageOnly) {
+            language = value;
+        }
+    }
+};
+
+IconThemeMetaData parse(const QString &internalName, const QString &indexPath)
+{
+    IconThemeMetaData data;
+    data.internalName = internalName;
+    data.dir = QFileInfo(indexPath).absolutePath() + QLatin1Char('/');
+
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return data;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    LocalizedValue name;
+    LocalizedValue comment;
+    bool inHeader = false;
+    bool hasDirectories = false;
+
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+
+        if (line.startsWith(QLatin1Char('['))) {
+            if (inHeader) {
+                // everything after the header describes icon directories
+                break;
+            }
+            inHeader = (line == QLatin1String("[Icon Theme]"));
+            continue;
+        }
+
+        if (!inHeader) {
+            continue;
+        }
+
+        const int eq = line.indexOf(QLatin1Char('='));
+        if (eq <= 0) {
+            continue;
+        }
+
+        QString key = line.left(eq).trimmed();
+        const QString value = line.mid(eq + 1).trimmed();
+        QString locale;
+        const int bracket = key.indexOf(QLatin1Char('['));
+        if (bracket > 0 && key.endsWith(QLatin1Char(']'))) {
+            locale = key.mid(bracket + 1, key.length() - bracket - 2);
+            key.truncate(bracket);
+        }
+
+        if (key == QLatin1String("Name")) {
+            name.set(locale, value);
+        } else if (key == QLatin1String("Comment")) {
+            comment.set(locale, value);
+        } else if (key == QLatin1String("Hidden") && locale.isEmpty()) {
+            data.hidden = (value.compare(QLatin1String("true"), Qt::CaseInsensitive) == 0);
+        } else if (key == QLatin1String("Directories") && locale.isEmpty()) {
+            hasDirectories = !value.isEmpty();
+        }
+    }
+
+    data.name = name.value();
+    data.description = comment.value();
+    data.valid = hasDirectories;
+    if (data.name.isEmpty()) {
+        data.name = internalName;
+    }
+
+    return data;
+}
+
+}
+
+IconThemeMetaData IconThemeMetaData::read(const QString &internalName, const QString &indexPath)
+{
+    const QDateTime mtime = QFileInfo(indexPath).lastModified();
+
+    {
+        QMutexLocker locker(&s_cacheMutex);
+        auto it = s_cache.constFind(indexPath);
+        if (it != s_cache.constEnd() && it->mtime == mtime) {
+            return it->data;
+        }
+    }
+
+    const IconThemeMetaData data = parse(internalName, indexPath);
+
+    QMutexLocker locker(&s_cacheMutex);
+    s_cache.insert(indexPath, CacheEntry{mtime, data});
+    return data;
+}
+
+QStringList IconThemeMetaData::searchPaths()
+{
+    QStringList paths;
+    paths << QDir::homePath() + QStringLiteral("/.icons");
+    paths << QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("icons"), QStandardPaths::LocateDirectory);
+    paths << QStringLiteral(":/icons");
+    return paths;
+}
+
+QList<IconThemeMetaData> IconThemeMetaData::scan()
+{
+    QList<IconThemeMetaData> themes;
+    QSet<QString> seen;
+
+    foreach (const QString &path, searchPaths()) {
+        const QDir dir(path);
+        if (!dir.exists()) {
+            continue;
+        }
+
+        foreach (const QString &entry, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            if (seen.contains(entry) || entry == QLatin1String("default") || entry == QLatin1String("default.kde")) {
+                continue;
+            }
+
+            QString indexPath = dir.filePath(entry) + QStringLiteral("/index.theme");
+            if (!QFile::exists(indexPath)) {
+                indexPath = dir.filePath(entry) + QStringLiteral("/index.desktop");
+                if (!QFile::exists(indexPath)) {
+                    continue;
+                }
+            }
+
+            const IconThemeMetaData data = read(entry, indexPath);
+            if (!data.valid) {
+                continue;
+            }
+
+            seen.insert(entry);
+            themes << data;
+        }
+    }
+
+    return themes;
+}
@@ -0,0 +1,61 @@
+/**
+ *  Copyright (c) 2017 The KDE Project
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef ICONTHEMEMETADATA_H
+#define ICONTHEMEMETADATA_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * The user visible bits of an icon theme.
+ *
+ * Unlike KIconTheme this only parses the [Icon Theme] header of the
+ * theme's index file and never looks at the directory sections, which
+ * is all the theme list of the KCM needs.
+ */
+struct IconThemeMetaData
+{
+    QString internalName;
+    QString dir;
+    QString name;
+    QString description;
+    bool hidden = false;
+    bool valid = false;
+
+    /**
+     * Reads the metadata of the index file at @p indexPath.
+     * Results are cached per process and reused as long as the
+     * modification time of the index file does not change.
+     */
+    static IconThemeMetaData read(const QString &internalName, const QString &indexPath);
+
+    /**
+     * Lists all installed icon themes, in the same search order as
+     * KIconTheme::list(). Safe to call from a worker thread.
+     */
+    static QList<IconThemeMetaData> scan();
+
+    /**
+     * The directories icon themes are looked up in.
+     */
+    static QStringList searchPaths();
+};
+
+#endif // ICONTHEMEMETADATA_H
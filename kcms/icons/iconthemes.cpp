@@ -43,6 +43,8 @@
 #include <qtemporaryfile.h>
 #include <QApplication>
 #include <QProcess>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 
 #include <KBuildSycocaProgressDialog>
 #include <KLocalizedString>
@@ -63,11 +65,15 @@
 #include <KTar>
 
 static const int ThemeNameRole = Qt::UserRole + 1;
+static const int ThemeDirRole = Qt::UserRole + 2;
 
 Q_LOGGING_CATEGORY(KCM_ICONS, "kcm_icons")
 
 IconThemesConfig::IconThemesConfig(QWidget *parent)
   : KCModule(parent)
+  , m_themesWatcher(new QFutureWatcher<QList<IconThemeMetaData> >(this))
+  , m_defaultTheme(0L)
+  , m_bChanged(false)
 {
   QLoggingCategory::setFilterRules(QStringLiteral("kcm_icons.debug = true"));
   QVBoxLayout *topLayout = new QVBoxLayout(this);
@@ -131,11 +137,9 @@ IconThemesConfig::IconThemesConfig(QWidget *parent)
   lg->addWidget(m_removeButton);
   topLayout->addLayout(lg);
 
-  loadThemes();
+  connect(m_themesWatcher, &QFutureWatcher<QList<IconThemeMetaData> >::finished, this, &IconThemesConfig::themesLoaded);
+  loadThemesAsync();
 
-  m_defaultTheme=iconThemeItem(KIconTheme::current());
-  if (m_defaultTheme)
-    m_iconThemes->setCurrentItem(m_defaultTheme);
   updateRemoveButton();
 
   m_iconThemes->setFocus();
@@ -155,21 +159,50 @@ QTreeWidgetItem *IconThemesConfig::iconThemeItem(const QString &name)
 }
 
 void IconThemesConfig::loadThemes()
+{
+  // the initial scan may still be running, its outdated list must not
+  // replace this one and the selection made with it once it is done
+  disconnect(m_themesWatcher, &QFutureWatcher<QList<IconThemeMetaData> >::finished, this, &IconThemesConfig::themesLoaded);
+  populateThemes(IconThemeMetaData::scan());
+}
+
+void IconThemesConfig::loadThemesAsync()
+{
+  // Reading the theme headers touches every installed theme, keep that
+  // off the GUI thread so the module shows up right away
+  m_themesWatcher->setFuture(QtConcurrent::run(&IconThemeMetaData::scan));
+}
+
+void IconThemesConfig::themesLoaded()
+{
+  populateThemes(m_themesWatcher->result());
+  selectCurrentTheme();
+  updateRemoveButton();
+}
+
+void IconThemesConfig::selectCurrentTheme()
+{
+  m_defaultTheme=iconThemeItem(KIconTheme::current());
+  if (m_defaultTheme) {
+    // don't mark the module as changed for the initial selection
+    const bool wasChanged = m_bChanged;
+    m_iconThemes->setCurrentItem(m_defaultTheme);
+    m_bChanged = wasChanged;
+    emit changed(m_bChanged);
+  }
+}
+
+void IconThemesConfig::populateThemes(const QList<IconThemeMetaData> &themes)
 {
   m_iconThemes->clear();
-  const QStringList themelist(KIconTheme::list());
   QString name;
   QString tname;
-  QStringList::const_iterator it;
   QMap <QString, QString> themeNames;
-  qCDebug(KCM_ICONS) << "Theme list:" << themelist << "<<"; // this is empty when I run it - jr
-  for (it=themelist.constBegin(); it != themelist.constEnd(); ++it)
+  foreach (const IconThemeMetaData &theme, themes)
   {
-    KIconTheme icontheme(*it);
-    if (!icontheme.isValid()) qCDebug(KCM_ICONS) << "not a valid theme" << *it;
-    if (icontheme.isHidden()) continue;
+    if (theme.hidden) continue;
 
-    name=icontheme.name();
+    name=theme.name;
     tname=name;
 
  //  Just in case we have duplicated icon theme names on separate directories
@@ -178,11 +211,12 @@ void IconThemesConfig::loadThemes()
 
     QTreeWidgetItem *newitem = new QTreeWidgetItem();
     newitem->setText(0, name);
-    newitem->setText(1, icontheme.description());
-    newitem->setData(0, ThemeNameRole, *it);
+    newitem->setText(1, theme.description);
+    newitem->setData(0, ThemeNameRole, theme.internalName);
+    newitem->setData(0, ThemeDirRole, theme.dir);
     m_iconThemes->addTopLevelItem(newitem);
 
-    themeNames.insert(name, *it);
+    themeNames.insert(name, theme.internalName);
   }
   m_iconThemes->resizeColumnToContents(0);
 }
@@ -349,13 +383,13 @@ void IconThemesConfig::removeSelectedTheme()
   int r=KMessageBox::warningContinueCancel(this,question,i18n("Confirmation"),KStandardGuiItem::del());
   if (r!=KMessageBox::Continue) return;
 
-  KIconTheme icontheme(selected->data(0, ThemeNameRole).toString());
+  const QString themeDir = selected->data(0, ThemeDirRole).toString();
 
   // delete the index file before the async KIO::del so loadThemes() will
   // ignore that dir.
-  unlink(QFile::encodeName(icontheme.dir()+"/index.theme").data());
-  unlink(QFile::encodeName(icontheme.dir()+"/index.desktop").data());
-  KIO::del(QUrl( icontheme.dir() ));
+  unlink(QFile::encodeName(themeDir+"/index.theme").data());
+  unlink(QFile::encodeName(themeDir+"/index.desktop").data());
+  KIO::del(QUrl::fromLocalFile( themeDir ));
 
   KIconLoader::global()->newIconLoader();
 
@@ -383,8 +417,7 @@ void IconThemesConfig::updateRemoveButton()
   if (selected)
   {
     QString selectedtheme = selected->data(0, ThemeNameRole).toString();
-    KIconTheme icontheme(selectedtheme);
-    QFileInfo fi(icontheme.dir());
+    QFileInfo fi(selected->data(0, ThemeDirRole).toString());
     enabled = fi.isWritable();
     // Don't let users remove the current theme.
     if (selectedtheme == KIconTheme::current() ||
@@ -24,6 +24,10 @@
 #include <QLabel>
 #include <QLoggingCategory>
 
+#include "iconthememetadata.h"
+
+template<typename T> class QFutureWatcher;
+
 class QStringList;
 class QPushButton;
 class QTreeWidget;
@@ -40,6 +44,7 @@ public:
   virtual ~IconThemesConfig();
 
   void loadThemes();
+  void loadThemesAsync();
   bool installThemes(const QStringList &themes, const QString &archiveName);
   QStringList findThemeDirs(const QString &archiveName);
 
@@ -56,9 +61,14 @@ protected Q_SLOTS:
   void installNewTheme();
   void getNewTheme();
   void removeSelectedTheme();
+  void themesLoaded();
 
 private:
   QTreeWidgetItem *iconThemeItem(const QString &name);
+  void populateThemes(const QList<IconThemeMetaData> &themes);
+  void selectCurrentTheme();
+
+  QFutureWatcher<QList<IconThemeMetaData> > *m_themesWatcher;
 
   QTreeWidget *m_iconThemes;
   QPushButton *m_removeButton;
@@ -90,13 +90,27 @@ KeyboardDaemon::~KeyboardDaemon()
 void KeyboardDaemon::configureKeyboard()
 {
 	qCDebug(KCM_KEYBOARD) << "Configuring keyboard";
+	initializeKeyboard(false);
+}
+
+void KeyboardDaemon::configureNewKeyboard()
+{
+	qCDebug(KCM_KEYBOARD) << "Configuring keyboard for new devices";
+	initializeKeyboard(true);
+}
+
+void KeyboardDaemon::initializeKeyboard(bool devicePlugged)
+{
 	init_keyboard_hardware();
 
 	keyboardConfig.load();
 	if( keyboardConfig.configureLayouts ) {
         XkbHelper::preInitialize();
 	}
-	XkbHelper::initializeKeyboardLayouts(keyboardConfig);
+	XkbHelper::initializeKeyboardLayouts(keyboardConfig, devicePlugged);
+	if( xEventNotifier != NULL ) {
+		xEventNotifier->keymapConfigured();
+	}
 	layoutMemory.configChanged();
 
 	setupTrayIcon();
@@ -156,7 +170,7 @@ void KeyboardDaemon::registerListeners()
 		xEventNotifier = new XInputEventNotifier();
 	}
 	connect(xEventNotifier, &XInputEventNotifier::newPointerDevice, this, &KeyboardDaemon::configureMouse);
-	connect(xEventNotifier, &XInputEventNotifier::newKeyboardDevice, this, &KeyboardDaemon::configureKeyboard);
+	connect(xEventNotifier, &XInputEventNotifier::newKeyboardDevice, this, &KeyboardDaemon::configureNewKeyboard);
 	connect(xEventNotifier, &XEventNotifier::layoutMapChanged, this, &KeyboardDaemon::layoutMapChanged);
 	connect(xEventNotifier, &XEventNotifier::layoutChanged, this, &KeyboardDaemon::layoutChanged);
 	xEventNotifier->start();
@@ -167,7 +181,7 @@ void KeyboardDaemon::unregisterListeners()
 	if( xEventNotifier != NULL ) {
 		xEventNotifier->stop();
 		disconnect(xEventNotifier, &XInputEventNotifier::newPointerDevice, this, &KeyboardDaemon::configureMouse);
-		disconnect(xEventNotifier, &XInputEventNotifier::newKeyboardDevice, this, &KeyboardDaemon::configureKeyboard);
+		disconnect(xEventNotifier, &XInputEventNotifier::newKeyboardDevice, this, &KeyboardDaemon::configureNewKeyboard);
 		disconnect(xEventNotifier, &XEventNotifier::layoutChanged, this, &KeyboardDaemon::layoutChanged);
 		disconnect(xEventNotifier, &XEventNotifier::layoutMapChanged, this, &KeyboardDaemon::layoutMapChanged);
 	}
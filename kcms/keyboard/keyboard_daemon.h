@@ -50,10 +50,12 @@ class Q_DECL_EXPORT KeyboardDaemon : public KDEDModule
     void unregisterListeners();
     void unregisterShortcut();
     void setupTrayIcon();
+    void initializeKeyboard(bool devicePlugged);
 
 private Q_SLOTS:
 	void switchToNextLayout();
     void configureKeyboard();
+    void configureNewKeyboard();
     void configureMouse();
     void layoutChanged();
     void layoutMapChanged();
@@ -0,0 +1,284 @@
+/*
+ *  Copyright (C) 2017 by The KDE Project
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QtTest/QtTest>
+#include <QSignalSpy>
+
+#include <config-keyboard.h>
+
+#include "../xinput_helper.h"
+
+#ifdef HAVE_XINPUT
+#include <X11/extensions/XInput2.h>
+#include <xcb/xcb.h>
+#endif
+
+
+static const QString CONFIGURED_KEYMAP(QStringLiteral("pc105\nus,de\n,nodeadkeys\ngrp:alt_shift_toggle"));
+static const QString DEFAULT_KEYMAP(QStringLiteral("pc105\nus\n\n"));
+static const int XINPUT_OPCODE = 131;
+
+// Takes device events from the test instead of the X server, and
+// configures the keyboard the way the daemon does when asked to
+class FakeEventNotifier : public XInputEventNotifier
+{
+public:
+	FakeEventNotifier(): keymapNames(CONFIGURED_KEYMAP), keyboardConfigurations(0), pointerConfigurations(0), deviceQueries(0) {
+		xinputOpcode = XINPUT_OPCODE;
+		connect(this, &XInputEventNotifier::newKeyboardDevice, this, [this]() {
+			keyboardConfigurations++;
+			keymapNames = CONFIGURED_KEYMAP;
+			keymapConfigured();
+		});
+		connect(this, &XInputEventNotifier::newPointerDevice, this, [this]() {
+			pointerConfigurations++;
+		});
+		keymapConfigured();
+	}
+
+	using XInputEventNotifier::deviceEnabled;
+	using XInputEventNotifier::processOtherEvents;
+
+	QString keymapNames;
+	int keyboardConfigurations;
+	int pointerConfigurations;
+	// what the server says the devices are used as
+	QHash<int, DeviceType> deviceTypes;
+	int deviceQueries;
+
+protected:
+	QString serverKeymapNames() const Q_DECL_OVERRIDE {
+		return keymapNames;
+	}
+	DeviceType queryDeviceType(int deviceId) Q_DECL_OVERRIDE {
+		deviceQueries++;
+		return deviceTypes.value(deviceId, DEVICE_NONE);
+	}
+};
+
+#ifdef HAVE_XINPUT
+// An XI_HierarchyChanged event laid out the way xcb hands it to us: the 32 byte event,
+// the full sequence number xcb appends, then the device infos
+class HierarchyEvent
+{
+public:
+	explicit HierarchyEvent(int opcode=XINPUT_OPCODE): infoCount(0), flags(0) {
+		data.fill(0, EVENT_SIZE);
+		data[0] = char(XCB_GE_GENERIC);
+		data[1] = char(opcode);
+		put<quint16>(8, XI_HierarchyChanged);
+		put<quint16>(10, XIAllDevices);
+	}
+
+	HierarchyEvent& device(int deviceId, int deviceFlags) {
+		const int offset = data.size();
+		data.append(QByteArray(INFO_SIZE, 0));
+		put<quint16>(offset, deviceId);
+		put<quint8>(offset + 5, (deviceFlags & XIDeviceDisabled) ? 0 : 1);
+		put<quint32>(offset + 8, deviceFlags);
+
+		flags |= deviceFlags;
+		put<quint32>(16, flags);
+		put<quint16>(20, ++infoCount);
+		put<quint32>(4, infoCount * INFO_SIZE / 4);
+		return *this;
+	}
+
+	xcb_generic_event_t* event() {
+		return reinterpret_cast<xcb_generic_event_t*>(data.data());
+	}
+
+private:
+	static const int EVENT_SIZE = 36;
+	static const int INFO_SIZE = 12;
+
+	template<typename T>
+	void put(int offset, T value) {
+		memcpy(data.data() + offset, &value, sizeof(value));
+	}
+
+	QByteArray data;
+	int infoCount;
+	quint32 flags;
+};
+#endif
+
+class XInputHelperTest : public QObject
+{
+    Q_OBJECT
+
+	// long enough for any pending burst to be handled
+	void waitForSettle() {
+		QTest::qWait(XInputEventNotifier::DEVICE_SETTLE_INTERVAL * 2);
+	}
+
+private Q_SLOTS:
+    void testBurstIsConfiguredOnce() {
+        FakeEventNotifier notifier;
+
+        // a docking station bringing up a handful of keyboards and pointers
+        for(int i=0; i<5; i++) {
+            notifier.deviceEnabled(XInputEventNotifier::DEVICE_KEYBOARD);
+            notifier.deviceEnabled(XInputEventNotifier::DEVICE_POINTER);
+            QTest::qWait(XInputEventNotifier::DEVICE_SETTLE_INTERVAL / 10);
+        }
+        notifier.keymapNames = DEFAULT_KEYMAP;
+
+        QCOMPARE( notifier.keyboardConfigurations, 0 );
+        QCOMPARE( notifier.pointerConfigurations, 0 );
+
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 1 );
+        QCOMPARE( notifier.pointerConfigurations, 1 );
+    }
+
+    void testSeparateBursts() {
+        FakeEventNotifier notifier;
+
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_KEYBOARD);
+        notifier.keymapNames = DEFAULT_KEYMAP;
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 1 );
+
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_KEYBOARD);
+        notifier.keymapNames = DEFAULT_KEYMAP;
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 2 );
+        QCOMPARE( notifier.pointerConfigurations, 0 );
+    }
+
+    void testUnchangedKeymapIsNotReconfigured() {
+        FakeEventNotifier notifier;
+
+        // a mouse does not touch the keymap
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_POINTER);
+        waitForSettle();
+        QCOMPARE( notifier.pointerConfigurations, 1 );
+        QCOMPARE( notifier.keyboardConfigurations, 0 );
+
+        // but a pointer that brings a keyboard interface along resets it
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_POINTER);
+        notifier.keymapNames = DEFAULT_KEYMAP;
+        waitForSettle();
+        QCOMPARE( notifier.pointerConfigurations, 2 );
+        QCOMPARE( notifier.keyboardConfigurations, 1 );
+    }
+
+    void testNewKeyboardIsAlwaysConfigured() {
+        FakeEventNotifier notifier;
+
+        // the keymap is already right, but repeat rate and NumLock still have to be set up
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_KEYBOARD);
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 1 );
+        QCOMPARE( notifier.pointerConfigurations, 0 );
+    }
+
+    void testIgnoredDevices() {
+        FakeEventNotifier notifier;
+
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_NONE);
+        notifier.keymapNames = DEFAULT_KEYMAP;
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 0 );
+        QCOMPARE( notifier.pointerConfigurations, 0 );
+    }
+
+    void testHierarchyEvents() {
+#ifdef HAVE_XINPUT
+        FakeEventNotifier notifier;
+        notifier.deviceTypes.insert(10, XInputEventNotifier::DEVICE_KEYBOARD);
+        notifier.deviceTypes.insert(11, XInputEventNotifier::DEVICE_POINTER);
+        notifier.deviceTypes.insert(12, XInputEventNotifier::DEVICE_NONE);
+
+        // a keyboard with a touchpad and a power button, all in one event
+        HierarchyEvent plugged;
+        plugged.device(10, XISlaveAdded | XIDeviceEnabled)
+                .device(11, XISlaveAdded | XIDeviceEnabled)
+                .device(12, XISlaveAdded | XIDeviceEnabled);
+        notifier.processOtherEvents(plugged.event());
+        QCOMPARE( notifier.deviceQueries, 3 );
+
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 1 );
+        QCOMPARE( notifier.pointerConfigurations, 1 );
+
+        // known devices are not asked about again
+        HierarchyEvent reenabled;
+        reenabled.device(10, XIDeviceEnabled);
+        notifier.processOtherEvents(reenabled.event());
+        QCOMPARE( notifier.deviceQueries, 3 );
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 2 );
+
+        // events of other extensions and removed devices configure nothing
+        HierarchyEvent otherExtension(XINPUT_OPCODE + 1);
+        otherExtension.device(10, XISlaveAdded | XIDeviceEnabled);
+        notifier.processOtherEvents(otherExtension.event());
+        HierarchyEvent unplugged;
+        unplugged.device(10, XISlaveRemoved | XIDeviceDisabled).device(11, XISlaveRemoved | XIDeviceDisabled);
+        notifier.processOtherEvents(unplugged.event());
+        waitForSettle();
+        QCOMPARE( notifier.deviceQueries, 3 );
+        QCOMPARE( notifier.keyboardConfigurations, 2 );
+        QCOMPARE( notifier.pointerConfigurations, 1 );
+#else
+        QSKIP("Hierarchy events come from XInput");
+#endif
+    }
+
+    void testFloatingDeviceIsQueriedAgain() {
+#ifdef HAVE_XINPUT
+        FakeEventNotifier notifier;
+
+        // floating and disabled, so not used as a keyboard yet
+        HierarchyEvent added;
+        added.device(20, XISlaveAdded | XIDeviceDisabled);
+        notifier.processOtherEvents(added.event());
+        QCOMPARE( notifier.deviceQueries, 1 );
+
+        // xinput enable, now it is one
+        notifier.deviceTypes.insert(20, XInputEventNotifier::DEVICE_KEYBOARD);
+        HierarchyEvent enabled;
+        enabled.device(20, XIDeviceEnabled);
+        notifier.processOtherEvents(enabled.event());
+        QCOMPARE( notifier.deviceQueries, 2 );
+
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 1 );
+#else
+        QSKIP("Hierarchy events come from XInput");
+#endif
+    }
+
+    void testConfigReloadUpdatesKeymap() {
+        FakeEventNotifier notifier;
+
+        // the user picked other layouts, the daemon applied them outside of a hotplug
+        notifier.keymapNames = DEFAULT_KEYMAP;
+        notifier.keymapConfigured();
+
+        notifier.deviceEnabled(XInputEventNotifier::DEVICE_POINTER);
+        waitForSettle();
+        QCOMPARE( notifier.keyboardConfigurations, 0 );
+    }
+};
+
+QTEST_GUILESS_MAIN(XInputHelperTest)
+
+#include "xinput_helper_test.moc"
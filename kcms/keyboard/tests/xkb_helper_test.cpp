@@ -0,0 +1,219 @@
+/*
+ *  Copyright (C) 2017 by The KDE Project
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QX11Info>
+
+#include "../xkb_helper.h"
+#include "../x11_helper.h"
+
+#include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <X11/keysym.h>
+#include <fixx11h.h>
+
+
+// Everything the keymap maps keys to, key by key
+static QStringList dumpKeymap()
+{
+	QStringList dump;
+	Display* display = QX11Info::display();
+	XkbDescPtr xkb = XkbGetMap(display, XkbAllClientInfoMask, XkbUseCoreKbd);
+	if( xkb == NULL )
+		return dump;
+
+	for(int keycode=xkb->min_key_code; keycode<=xkb->max_key_code; keycode++) {
+		QStringList syms;
+		for(int i=0; i<XkbKeyNumSyms(xkb, keycode); i++) {
+			syms << QString::number(XkbKeySymsPtr(xkb, keycode)[i], 16);
+		}
+		dump << QStringLiteral("%1 %2x%3: %4").arg(keycode).arg(XkbKeyNumGroups(xkb, keycode))
+				.arg(XkbKeyGroupsWidth(xkb, keycode)).arg(syms.join(QLatin1Char(' ')));
+	}
+	XkbFreeClientMap(xkb, 0, True);
+	return dump;
+}
+
+static QStringList serverNames()
+{
+	XkbConfig xkbConfig;
+	X11Helper::getGroupNames(QX11Info::display(), &xkbConfig, X11Helper::ALL);
+	return QStringList() << xkbConfig.keyboardModel << xkbConfig.layouts.join(QLatin1Char(','))
+			<< xkbConfig.variants.join(QLatin1Char(',')) << xkbConfig.options.join(QLatin1Char(','));
+}
+
+static KeySym keysymOf(KeyCode keycode)
+{
+	return XkbKeycodeToKeysym(QX11Info::display(), keycode, 0, 0);
+}
+
+class XkbHelperTest : public QObject
+{
+    Q_OBJECT
+
+	QTemporaryDir homeDir;
+	QByteArray oldHome;
+
+	// puts the server on a different keymap so the next apply has to do something
+	void resetKeymap() {
+		QVERIFY( XkbHelper::runConfigLayoutCommand(QStringList() << QStringLiteral("-layout") << QStringLiteral("gb") << QStringLiteral("-option")) );
+	}
+
+private Q_SLOTS:
+    void initTestCase() {
+        // this replaces the keymap of the whole X server, so never run it on the user's session by accident,
+        // ctest sets this when the test is enabled with XKB_SERVER_TESTS
+        if( qgetenv("KCM_KEYBOARD_XKB_TEST").isEmpty() ) {
+            QSKIP("Changes the server keymap, set KCM_KEYBOARD_XKB_TEST=1 to run it on a dedicated Xvfb");
+        }
+        if( ! QX11Info::isPlatformX11() ) {
+            QSKIP("Needs an X server, e.g. Xvfb");
+        }
+        if( QStandardPaths::findExecutable(QStringLiteral("setxkbmap")).isEmpty() ) {
+            QSKIP("Needs setxkbmap to compare with");
+        }
+        // keep the user's .Xmodmap out of it
+        QVERIFY( homeDir.isValid() );
+        oldHome = qgetenv("HOME");
+        qputenv("HOME", QFile::encodeName(homeDir.path()));
+    }
+
+    void cleanupTestCase() {
+        qputenv("HOME", oldHome);
+    }
+
+    void testMatchesSetxkbmap_data() {
+        QTest::addColumn<QStringList>("arguments");
+
+        QTest::newRow("layout") << (QStringList() << QStringLiteral("-layout") << QStringLiteral("us"));
+        QTest::newRow("variants") << (QStringList() << QStringLiteral("-layout") << QStringLiteral("us,de")
+                << QStringLiteral("-variant") << QStringLiteral(",nodeadkeys"));
+        QTest::newRow("model") << (QStringList() << QStringLiteral("-model") << QStringLiteral("pc105")
+                << QStringLiteral("-layout") << QStringLiteral("fr"));
+        QTest::newRow("options") << (QStringList() << QStringLiteral("-layout") << QStringLiteral("us,ru")
+                << QStringLiteral("-option") << QStringLiteral("-option") << QStringLiteral("grp:alt_shift_toggle,ctrl:nocaps"));
+    }
+
+    void testMatchesSetxkbmap() {
+        QFETCH(QStringList, arguments);
+
+        resetKeymap();
+        QVERIFY( XkbHelper::runConfigLayoutCommand(arguments) );
+        const QStringList expectedNames = serverNames();
+        const QStringList expectedKeymap = dumpKeymap();
+
+        resetKeymap();
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        QCOMPARE( serverNames(), expectedNames );
+        QCOMPARE( dumpKeymap(), expectedKeymap );
+    }
+
+    void testXmodmap() {
+        if( QStandardPaths::findExecutable(QStringLiteral("xmodmap")).isEmpty() ) {
+            QSKIP("Needs xmodmap to compare with");
+        }
+
+        const QStringList arguments = QStringList() << QStringLiteral("-layout") << QStringLiteral("us");
+        resetKeymap();
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        const int a = XKeysymToKeycode(QX11Info::display(), XK_a);
+        const int b = XKeysymToKeycode(QX11Info::display(), XK_b);
+        QVERIFY( a != 0 && b != 0 );
+
+        QFile xmodmap(QDir(homeDir.path()).filePath(QStringLiteral(".Xmodmap")));
+        QVERIFY( xmodmap.open(QIODevice::WriteOnly | QIODevice::Text) );
+        xmodmap.write(QStringLiteral("! swap a and b\nkeycode %1 = b B\nkeycode %2 = a A\nkeycode %3 = 0x1000430 NoSymbol\n")
+                .arg(a).arg(b).arg(a+1).toLatin1());
+        xmodmap.close();
+
+        resetKeymap();
+        QVERIFY( XkbHelper::runConfigLayoutCommand(arguments) );
+        const QStringList expectedKeymap = dumpKeymap();
+        QCOMPARE( keysymOf(a), KeySym(XK_b) );
+
+        resetKeymap();
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        QCOMPARE( dumpKeymap(), expectedKeymap );
+
+        QVERIFY( xmodmap.remove() );
+    }
+
+    void testXmodmapAfterDevicePlugged() {
+        if( QStandardPaths::findExecutable(QStringLiteral("xmodmap")).isEmpty() ) {
+            QSKIP("Needs xmodmap to compare with");
+        }
+
+        const QStringList arguments = QStringList() << QStringLiteral("-layout") << QStringLiteral("us");
+        resetKeymap();
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        const KeyCode a = XKeysymToKeycode(QX11Info::display(), XK_a);
+        QVERIFY( a != 0 );
+
+        QFile xmodmap(QDir(homeDir.path()).filePath(QStringLiteral(".Xmodmap")));
+        QVERIFY( xmodmap.open(QIODevice::WriteOnly | QIODevice::Text) );
+        xmodmap.write(QStringLiteral("keycode %1 = z Z\n").arg(a).toLatin1());
+        xmodmap.close();
+
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        XSync(QX11Info::display(), False);
+        QCOMPARE( keysymOf(a), KeySym(XK_z) );
+
+        // the new keyboard came up with the plain keymap under the same names
+        KeySym plain = XK_a;
+        XChangeKeyboardMapping(QX11Info::display(), a, 1, &plain, 1);
+        XSync(QX11Info::display(), False);
+
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        QCOMPARE( keysymOf(a), KeySym(XK_a) );
+
+        QVERIFY( XkbHelper::applyConfigLayout(arguments, true) );
+        XSync(QX11Info::display(), False);
+        QCOMPARE( keysymOf(a), KeySym(XK_z) );
+
+        QVERIFY( xmodmap.remove() );
+    }
+
+    void testSkipsUpToDateKeymap() {
+        const QStringList arguments = QStringList() << QStringLiteral("-layout") << QStringLiteral("us");
+        resetKeymap();
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+
+        const KeyCode a = XKeysymToKeycode(QX11Info::display(), XK_a);
+        KeySym z = XK_z;
+        XChangeKeyboardMapping(QX11Info::display(), a, 1, &z, 1);
+        XSync(QX11Info::display(), False);
+        QCOMPARE( keysymOf(a), KeySym(XK_z) );
+
+        // same names on the server, nothing is reloaded
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        QCOMPARE( keysymOf(a), KeySym(XK_z) );
+
+        // the names changed behind our back (e.g. a keyboard was plugged in), so it is
+        resetKeymap();
+        QVERIFY( XkbHelper::applyConfigLayout(arguments) );
+        QCOMPARE( keysymOf(a), KeySym(XK_a) );
+    }
+};
+
+// need GUI for xkb protocol
+QTEST_MAIN(XkbHelperTest)
+
+#include "xkb_helper_test.moc"
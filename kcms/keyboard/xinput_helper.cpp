@@ -29,18 +29,29 @@
 #include <X11/Xatom.h>
 
 #ifdef HAVE_XINPUT
-#include <X11/extensions/XInput.h>
+#include <X11/extensions/XInput2.h>
 #include <xcb/xproto.h>
-typedef struct xcb_input_device_presence_notify_event_t {
+typedef struct xcb_input_hierarchy_event_t {
     uint8_t         response_type;
-    uint8_t         pad0;
+    uint8_t         extension;
     uint16_t        sequence;
+    uint32_t        length;
+    uint16_t        event_type;
+    uint16_t        deviceid;
     xcb_timestamp_t time;
-    uint8_t         devchange;
-    uint8_t         device_id;
-    uint16_t        control;
-    uint8_t         pad1[20];
-} xcb_input_device_presence_notify_event_t;
+    uint32_t        flags;
+    uint16_t        num_infos;
+    uint8_t         pad0[10];
+    uint32_t        full_sequence;
+} xcb_input_hierarchy_event_t;
+typedef struct xcb_input_hierarchy_info_t {
+    uint16_t        deviceid;
+    uint16_t        attachment;
+    uint8_t         type;
+    uint8_t         enabled;
+    uint8_t         pad0[2];
+    uint32_t        flags;
+} xcb_input_hierarchy_info_t;
 // FIXME: #include <xcb/xinput.h> once xcb-xinput is stable
 #endif
 
@@ -49,16 +60,23 @@ typedef struct xcb_input_device_presence_notify_event_t {
 
 #include <fixx11h.h>
 
-static const int DEVICE_NONE = 0;
-static const int DEVICE_KEYBOARD = 1;
-static const int DEVICE_POINTER = 2;
+// a dock or a hub brings up several devices within a few dozen milliseconds,
+// and X may rewrite the keymap names a bit after the device shows up
+const int XInputEventNotifier::DEVICE_SETTLE_INTERVAL = 300;
 
 XInputEventNotifier::XInputEventNotifier(QWidget* parent):
 	XEventNotifier(), //TODO: destruct properly?
-	xinputEventType(-1),
-	udevNotifier(Q_NULLPTR)
+	xinputOpcode(-1),
+	display(NULL),
+	udevNotifier(Q_NULLPTR),
+	newKeyboard(false),
+	newPointer(false)
 {
   Q_UNUSED(parent)
+
+	settleTimer.setSingleShot(true);
+	settleTimer.setInterval(DEVICE_SETTLE_INTERVAL);
+	connect(&settleTimer, &QTimer::timeout, this, &XInputEventNotifier::configureNewDevices);
 }
 
 void XInputEventNotifier::start()
@@ -66,6 +84,7 @@ void XInputEventNotifier::start()
 	if( QCoreApplication::instance() != NULL ) {
 		registerForNewDeviceEvent(QX11Info::display());
 	}
+	keymapConfigured();
 
 	XEventNotifier::start();
 }
@@ -73,23 +92,69 @@ void XInputEventNotifier::start()
 void XInputEventNotifier::stop()
 {
 	XEventNotifier::stop();
+	settleTimer.stop();
+	newKeyboard = false;
+	newPointer = false;
 
 	if( QCoreApplication::instance() != NULL ) {
 	//    XEventNotifier::unregisterForNewDeviceEvent(QX11Info::display());
 	}
 }
 
+void XInputEventNotifier::keymapConfigured()
+{
+	configuredKeymapNames = serverKeymapNames();
+}
+
+QString XInputEventNotifier::serverKeymapNames() const
+{
+	XkbConfig xkbConfig;
+	if( ! QX11Info::isPlatformX11() || ! X11Helper::getGroupNames(QX11Info::display(), &xkbConfig, X11Helper::ALL) )
+		return QString();
+
+	return QStringList({ xkbConfig.keyboardModel, xkbConfig.layouts.join(QLatin1Char(',')),
+			xkbConfig.variants.join(QLatin1Char(',')), xkbConfig.options.join(QLatin1Char(',')) }).join(QLatin1Char('\n'));
+}
+
 bool XInputEventNotifier::processOtherEvents(xcb_generic_event_t* event)
 {
-	int newDeviceType = getNewDeviceEventType(event);
-	if( newDeviceType == DEVICE_KEYBOARD ) {
-		emit(newKeyboardDevice());
+	processHierarchyEvent(event);
+	return true;
+}
+
+void XInputEventNotifier::deviceEnabled(DeviceType deviceType)
+{
+	if( deviceType == DEVICE_KEYBOARD ) {
+		newKeyboard = true;
+	}
+	else if( deviceType == DEVICE_POINTER ) {
+		newPointer = true;
+	}
+	else {
+		return;
 	}
-	else if( newDeviceType == DEVICE_POINTER ) {
+	settleTimer.start();
+}
+
+void XInputEventNotifier::configureNewDevices()
+{
+	if( newPointer ) {
 		emit(newPointerDevice());
-		emit(newKeyboardDevice());	// arghhh, looks like X resets xkb map even when only pointer device is connected
 	}
-	return true;
+
+	// a new keyboard always needs its repeat rate and NumLock set, whether the keymap was touched
+	// is left to the keyboard configuration; a pointer only matters if it brought a keyboard
+	// interface along and X reset the keymap for it
+	if( newKeyboard || serverKeymapNames() != configuredKeymapNames ) {
+		qCDebug(KCM_KEYBOARD) << "Configuring keyboard after new devices, keyboard:" << newKeyboard << "pointer:" << newPointer;
+		emit(newKeyboardDevice());
+	}
+	else {
+		qCDebug(KCM_KEYBOARD) << "Keymap is unchanged after new pointer devices";
+	}
+
+	newKeyboard = false;
+	newPointer = false;
 }
 
 
@@ -105,51 +170,113 @@ static bool isRealKeyboard(const char* deviceName)
 		&& strstr(deviceName, "WMI hotkeys") == NULL;
 }
 
-int XInputEventNotifier::getNewDeviceEventType(xcb_generic_event_t* event)
-{
-	int newDeviceType = DEVICE_NONE;
-	if( xinputEventType != -1 && event->response_type == xinputEventType ) {
-		xcb_input_device_presence_notify_event_t *xdpne = reinterpret_cast<xcb_input_device_presence_notify_event_t *>(event);
-		if( xdpne->devchange == DeviceEnabled ) {
-			int ndevices;
-			XDeviceInfo *devices = XListInputDevices(display, &ndevices);
-			if( devices != NULL ) {
-				qCDebug(KCM_KEYBOARD) << "New device id:" << xdpne->device_id;
-				for(int i=0; i<ndevices; i++) {
-					qCDebug(KCM_KEYBOARD) << "id:" << devices[i].id << "name:" << devices[i].name << "used as:" << devices[i].use;
-					if( devices[i].id == xdpne->device_id ) {
-						if( devices[i].use == IsXKeyboard || devices[i].use == IsXExtensionKeyboard ) {
-							if( isRealKeyboard(devices[i].name) ) {
-								newDeviceType = DEVICE_KEYBOARD;
-								qCDebug(KCM_KEYBOARD) << "new keyboard device, id:" << devices[i].id << "name:" << devices[i].name << "used as:" << devices[i].use;
-								break;
-							}
-						}
-						if( devices[i].use == IsXPointer || devices[i].use == IsXExtensionPointer ) {
-							newDeviceType = DEVICE_POINTER;
-							qCDebug(KCM_KEYBOARD) << "new pointer device, id:" << devices[i].id << "name:" << devices[i].name << "used as:" << devices[i].use;
-							break;
-						}
-					}
-				}
-				XFreeDeviceList(devices);
-			}
+static XInputEventNotifier::DeviceType deviceType(const XIDeviceInfo& device)
+{
+	if( device.use == XIMasterKeyboard || device.use == XISlaveKeyboard ) {
+		return isRealKeyboard(device.name) ? XInputEventNotifier::DEVICE_KEYBOARD : XInputEventNotifier::DEVICE_NONE;
+	}
+	if( device.use == XIMasterPointer || device.use == XISlavePointer ) {
+		return XInputEventNotifier::DEVICE_POINTER;
+	}
+	return XInputEventNotifier::DEVICE_NONE;
+}
+
+XInputEventNotifier::DeviceType XInputEventNotifier::queryDeviceType(int deviceId)
+{
+	DeviceType type = DEVICE_NONE;
+	int ndevices;
+	XIDeviceInfo *deviceInfo = XIQueryDevice(display, deviceId, &ndevices);
+	if( deviceInfo != NULL ) {
+		if( ndevices > 0 ) {
+			type = deviceType(deviceInfo[0]);
+			qCDebug(KCM_KEYBOARD) << "New device id:" << deviceId << "name:" << deviceInfo[0].name << "used as:" << deviceInfo[0].use;
+		}
+		XIFreeDeviceInfo(deviceInfo);
+	}
+	return type;
+}
+
+void XInputEventNotifier::processHierarchyEvent(xcb_generic_event_t* event)
+{
+	if( xinputOpcode == -1 || (event->response_type & ~0x80) != XCB_GE_GENERIC )
+		return;
+
+	xcb_input_hierarchy_event_t *hierarchyEvent = reinterpret_cast<xcb_input_hierarchy_event_t *>(event);
+	if( hierarchyEvent->extension != xinputOpcode || hierarchyEvent->event_type != XI_HierarchyChanged )
+		return;
+
+	const xcb_input_hierarchy_info_t *infos = reinterpret_cast<const xcb_input_hierarchy_info_t *>(hierarchyEvent + 1);
+	for(int i=0; i<hierarchyEvent->num_infos; i++) {
+		const xcb_input_hierarchy_info_t& info = infos[i];
+
+		if( info.flags & (XISlaveRemoved | XIMasterRemoved) ) {
+			devices.remove(info.deviceid);
+			continue;
+		}
+		// a device that was disabled or floating when we looked is not used as anything yet,
+		// so ask again once it is enabled or attached
+		const bool unknown = devices.value(info.deviceid, DEVICE_NONE) == DEVICE_NONE;
+		if( (info.flags & (XISlaveAdded | XIMasterAdded)) || ((info.flags & (XIDeviceEnabled | XISlaveAttached)) && unknown) ) {
+			devices.insert(info.deviceid, queryDeviceType(info.deviceid));
+		}
+		// only enabling a device makes X set it up with the default keymap
+		if( info.flags & XIDeviceEnabled ) {
+			deviceEnabled(devices.value(info.deviceid, DEVICE_NONE));
 		}
 	}
-	return newDeviceType;
 }
 
 int XInputEventNotifier::registerForNewDeviceEvent(Display* display_)
 {
-	int xitype;
-	XEventClass xiclass;
 	display = display_;
 
-	DevicePresence(display, xitype, xiclass);
-	XSelectExtensionEvent(display, DefaultRootWindow(display), &xiclass, 1);
-	qCDebug(KCM_KEYBOARD) << "Registered for new device events from XInput, class" << xitype;
-	xinputEventType = xitype;
-	return xitype;
+	int event, error;
+	if( ! XQueryExtension(display, "XInputExtension", &xinputOpcode, &event, &error) ) {
+		qCWarning(KCM_KEYBOARD) << "X server has no XInput extension, xkb configuration will be reset when new keyboard device is plugged in!";
+		xinputOpcode = -1;
+		return -1;
+	}
+
+	int major = 2, minor = 0;
+	if( XIQueryVersion(display, &major, &minor) != Success ) {
+		qCWarning(KCM_KEYBOARD) << "X server does not support XInput 2, xkb configuration will be reset when new keyboard device is plugged in!";
+		xinputOpcode = -1;
+		return -1;
+	}
+
+	// Qt selects XInput events on the root window too, add to its mask rather than replacing it
+	const Window root = DefaultRootWindow(display);
+	unsigned char mask[XIMaskLen(XI_LASTEVENT)] = { 0 };
+	int nmasks;
+	XIEventMask *selectedMasks = XIGetSelectedEvents(display, root, &nmasks);
+	if( selectedMasks != NULL ) {
+		for(int i=0; i<nmasks; i++) {
+			if( selectedMasks[i].deviceid == XIAllDevices ) {
+				memcpy(mask, selectedMasks[i].mask, qMin<size_t>(selectedMasks[i].mask_len, sizeof(mask)));
+			}
+		}
+		XFree(selectedMasks);
+	}
+	XISetMask(mask, XI_HierarchyChanged);
+
+	XIEventMask eventMask;
+	eventMask.deviceid = XIAllDevices;
+	eventMask.mask_len = sizeof(mask);
+	eventMask.mask = mask;
+	XISelectEvents(display, root, &eventMask, 1);
+
+	devices.clear();
+	int ndevices;
+	XIDeviceInfo *deviceInfo = XIQueryDevice(display, XIAllDevices, &ndevices);
+	if( deviceInfo != NULL ) {
+		for(int i=0; i<ndevices; i++) {
+			devices.insert(deviceInfo[i].deviceid, deviceType(deviceInfo[i]));
+		}
+		XIFreeDeviceInfo(deviceInfo);
+	}
+
+	qCDebug(KCM_KEYBOARD) << "Registered for device hierarchy events from XInput, opcode" << xinputOpcode << "devices:" << devices.count();
+	return xinputOpcode;
 }
 
 #elif defined(HAVE_UDEV)
@@ -158,16 +285,18 @@ int XInputEventNotifier::registerForNewDeviceEvent(Display* /*display*/)
 {
     if (!udevNotifier) {
         udevNotifier = new UdevDeviceNotifier(this);
-        connect(udevNotifier, &UdevDeviceNotifier::newKeyboardDevice, this, &XInputEventNotifier::newKeyboardDevice);
-        connect(udevNotifier, &UdevDeviceNotifier::newPointerDevice, this, &XInputEventNotifier::newPointerDevice);
-        // Same as with XInput notifier, also emit newKeyboardDevice when pointer device is found
-        connect(udevNotifier, &UdevDeviceNotifier::newPointerDevice, this, &XInputEventNotifier::newKeyboardDevice);
+        connect(udevNotifier, &UdevDeviceNotifier::newKeyboardDevice, this, [this]() { deviceEnabled(DEVICE_KEYBOARD); });
+        connect(udevNotifier, &UdevDeviceNotifier::newPointerDevice, this, [this]() { deviceEnabled(DEVICE_POINTER); });
     }
 
     return -1;
 }
 
-int XInputEventNotifier::getNewDeviceEventType(xcb_generic_event_t* /*event*/)
+void XInputEventNotifier::processHierarchyEvent(xcb_generic_event_t* /*event*/)
+{
+}
+
+XInputEventNotifier::DeviceType XInputEventNotifier::queryDeviceType(int /*deviceId*/)
 {
     return DEVICE_NONE;
 }
@@ -184,7 +313,11 @@ int XInputEventNotifier::registerForNewDeviceEvent(Display* /*display*/)
 	return -1;
 }
 
-int XInputEventNotifier::getNewDeviceEventType(xcb_generic_event_t* /*event*/)
+void XInputEventNotifier::processHierarchyEvent(xcb_generic_event_t* /*event*/)
+{
+}
+
+XInputEventNotifier::DeviceType XInputEventNotifier::queryDeviceType(int /*deviceId*/)
 {
 	return DEVICE_NONE;
 }
@@ -22,6 +22,9 @@
 
 #include "x11_helper.h"
 
+#include <QHash>
+#include <QTimer>
+
 #include <X11/Xlib.h>
 #include <fixx11h.h>
 
@@ -31,6 +34,11 @@ class XInputEventNotifier: public XEventNotifier {
 	Q_OBJECT
 
 public:
+	enum DeviceType { DEVICE_NONE, DEVICE_KEYBOARD, DEVICE_POINTER };
+
+	// how long device events have to stop coming before new devices are configured
+	static const int DEVICE_SETTLE_INTERVAL;
+
 	XInputEventNotifier(QWidget* parent=NULL);
 
 	void start() Q_DECL_OVERRIDE;
@@ -38,6 +46,9 @@ public:
 
 	int registerForNewDeviceEvent(Display* dpy);
 
+	// to be called once the keyboard is configured, new pointers only emit newKeyboardDevice() again if X resets the keymap
+	void keymapConfigured();
+
 Q_SIGNALS:
 	void newKeyboardDevice();
 	void newPointerDevice();
@@ -45,12 +56,29 @@ Q_SIGNALS:
 protected:
 	bool processOtherEvents(xcb_generic_event_t* event) Q_DECL_OVERRIDE;
 
+	// new devices are remembered here and configured together when the burst of events is over
+	void deviceEnabled(DeviceType deviceType);
+	// the names the server keymap was built from, X rewrites them whenever it resets the keymap
+	virtual QString serverKeymapNames() const;
+	// asks the server what a device is used as, for devices the hierarchy events tell us about
+	virtual DeviceType queryDeviceType(int deviceId);
+
+	// major opcode of the XInput extension, -1 if hierarchy events are not available
+	int xinputOpcode;
+
 private:
-	int getNewDeviceEventType(xcb_generic_event_t* event);
+	void configureNewDevices();
+	void processHierarchyEvent(xcb_generic_event_t* event);
 
-	int xinputEventType;
 	Display* display;
 	UdevDeviceNotifier *udevNotifier;
+
+	// device id -> type of the devices XInput told us about
+	QHash<int, DeviceType> devices;
+	QTimer settleTimer;
+	bool newKeyboard;
+	bool newPointer;
+	QString configuredKeymapNames;
 };
 
 #endif /* XINPUT_HELPER_H_ */
@@ -20,10 +20,17 @@
 #include "debug.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QDir>
+#include <QHash>
+#include <QMap>
+#include <QRegExp>
 #include <QString>
 #include <QStringList>
+#include <QTextStream>
 #include <QTime>
+#include <QVector>
 #include <QX11Info>
 #include <QStandardPaths>
 #include <QDebug>
@@ -31,6 +38,15 @@
 #include <kprocess.h>
 
 #include "keyboard_config.h"
+#include "xkb_rules.h"
+
+#include <X11/Xlib.h>
+#include <X11/XKBlib.h>
+#include <X11/extensions/XKBrules.h>
+#include <fixx11h.h>
+
+#include <algorithm>
+#include <stdlib.h>
 
 
 static const char SETXKBMAP_EXEC[] = "setxkbmap";
@@ -88,13 +104,344 @@ void executeXmodmap(const QString& configFileName)
 }
 
 static
-void restoreXmodmap()
+QString xmodmapFileName()
 {
 	// TODO: is just home .Xmodmap enough or should system be involved too?
 	//    QString configFileName = QDir("/etc/X11/xinit").filePath(".Xmodmap");
-	//    executeXmodmap(configFileName);
-	QString configFileName = QDir::home().filePath(QStringLiteral(".Xmodmap"));
-	executeXmodmap(configFileName);
+	return QDir::home().filePath(QStringLiteral(".Xmodmap"));
+}
+
+static
+void restoreXmodmap()
+{
+	executeXmodmap(xmodmapFileName());
+}
+
+// .Xmodmap as last read, so the same file is not parsed again on every hotplug
+struct XmodmapFile {
+	QString fileName;
+	QDateTime lastModified;
+	qint64 size;
+	// false if the file has expressions other than "keycode N = ...", those are left to xmodmap
+	bool parsed;
+	bool applied;
+	QMap<int, QVector<KeySym> > keycodes;
+
+	XmodmapFile(): size(-1), parsed(false), applied(false) {}
+};
+
+static XmodmapFile xmodmapFile;
+
+static
+bool parseXmodmap(const QString& fileName, XmodmapFile* xmodmap)
+{
+	QFile file(fileName);
+	if( ! file.open(QIODevice::ReadOnly | QIODevice::Text) )
+		return false;
+
+	QRegExp keycodeRegex(QStringLiteral("^keycode\\s+(0x[0-9a-fA-F]+|[0-9]+)\\s*=(.*)$"));
+	QTextStream in(&file);
+	while( ! in.atEnd() ) {
+		const QString line = in.readLine().trimmed();
+		if( line.isEmpty() || line.startsWith(QLatin1Char('!')) )
+			continue;
+
+		if( keycodeRegex.indexIn(line) == -1 ) {
+			qCDebug(KCM_KEYBOARD) << "Leaving" << fileName << "to xmodmap because of" << line;
+			return false;
+		}
+
+		bool ok;
+		const int keycode = keycodeRegex.cap(1).toInt(&ok, 0);
+		if( ! ok )
+			return false;
+
+		QVector<KeySym> keysyms;
+		foreach(const QString& name, keycodeRegex.cap(2).split(QRegExp(QStringLiteral("\\s+")), QString::SkipEmptyParts)) {
+			KeySym keysym = XStringToKeysym(name.toLatin1().constData());
+			if( keysym == NoSymbol && name != QLatin1String("NoSymbol") ) {
+				if( ! name.startsWith(QLatin1String("0x")) )
+					return false;
+				keysym = name.toULong(&ok, 16);
+				if( ! ok )
+					return false;
+			}
+			keysyms.append(keysym);
+		}
+		xmodmap->keycodes.insert(keycode, keysyms);
+	}
+	return true;
+}
+
+// Sends the parsed keycode expressions as one XChangeKeyboardMapping request per run of adjacent keycodes
+static
+void applyXmodmap(const XmodmapFile& xmodmap)
+{
+	Display* display = QX11Info::display();
+	int minKeycode, maxKeycode;
+	XDisplayKeycodes(display, &minKeycode, &maxKeycode);
+
+	QMap<int, QVector<KeySym> >::const_iterator it = xmodmap.keycodes.constBegin();
+	while( it != xmodmap.keycodes.constEnd() ) {
+		if( it.key() < minKeycode || it.key() > maxKeycode ) {
+			qCWarning(KCM_KEYBOARD) << "Keycode" << it.key() << "in" << xmodmap.fileName << "is out of range";
+			++it;
+			continue;
+		}
+
+		const int firstKeycode = it.key();
+		QList<const QVector<KeySym>*> run;
+		int keysymsPerKeycode = 1;
+		while( it != xmodmap.keycodes.constEnd() && it.key() == firstKeycode + run.count() && it.key() <= maxKeycode ) {
+			run.append(&it.value());
+			keysymsPerKeycode = qMax(keysymsPerKeycode, it.value().count());
+			++it;
+		}
+
+		QVector<KeySym> keysyms(run.count() * keysymsPerKeycode, NoSymbol);
+		for(int i=0; i<run.count(); i++) {
+			std::copy(run[i]->constBegin(), run[i]->constEnd(), keysyms.begin() + i * keysymsPerKeycode);
+		}
+		XChangeKeyboardMapping(display, firstKeycode, keysymsPerKeycode, keysyms.data(), run.count());
+	}
+	XFlush(display);
+}
+
+// Restores the .Xmodmap mapping; unless the keymap was just reset or a device was plugged in
+// it is only sent again if the file changed
+static
+void restoreXmodmapInProcess(bool keymapReset)
+{
+	const QFileInfo fileInfo(xmodmapFileName());
+	if( ! fileInfo.exists() ) {
+		xmodmapFile = XmodmapFile();
+		return;
+	}
+
+	if( fileInfo.absoluteFilePath() != xmodmapFile.fileName
+			|| fileInfo.lastModified() != xmodmapFile.lastModified || fileInfo.size() != xmodmapFile.size ) {
+		xmodmapFile = XmodmapFile();
+		xmodmapFile.fileName = fileInfo.absoluteFilePath();
+		xmodmapFile.lastModified = fileInfo.lastModified();
+		xmodmapFile.size = fileInfo.size();
+		xmodmapFile.parsed = parseXmodmap(xmodmapFile.fileName, &xmodmapFile);
+		if( ! xmodmapFile.parsed ) {
+			xmodmapFile.keycodes.clear();
+		}
+	}
+
+	if( ! keymapReset && xmodmapFile.applied )
+		return;
+
+	if( xmodmapFile.parsed ) {
+		applyXmodmap(xmodmapFile);
+	}
+	else {
+		executeXmodmap(xmodmapFile.fileName);
+	}
+	xmodmapFile.applied = true;
+}
+
+static
+QString takeString(char* str)
+{
+	const QString result = QString::fromLatin1(str);
+	free(str);
+	return result;
+}
+
+// The names a keymap is built from, as stored in the _XKB_RULES_NAMES root window property
+struct KeymapNames {
+	QString rules;
+	QString model;
+	QString layout;
+	QString variant;
+	QString options;
+
+	bool operator==(const KeymapNames& other) const {
+		return rules == other.rules && model == other.model && layout == other.layout
+				&& variant == other.variant && options == other.options;
+	}
+	QString key() const {
+		return QStringList({rules, model, layout, variant, options}).join(QLatin1Char('\n'));
+	}
+};
+
+static
+KeymapNames getServerKeymapNames()
+{
+	KeymapNames names;
+	char* rulesFile = NULL;
+	XkbRF_VarDefsRec varDefs;
+	memset(&varDefs, 0, sizeof(varDefs));
+	if( XkbRF_GetNamesProp(QX11Info::display(), &rulesFile, &varDefs) ) {
+		names.rules = takeString(rulesFile);
+		names.model = takeString(varDefs.model);
+		names.layout = takeString(varDefs.layout);
+		names.variant = takeString(varDefs.variant);
+		names.options = takeString(varDefs.options);
+	}
+	return names;
+}
+
+// Merges the setxkbmap arguments into the names the server currently has, the way setxkbmap does
+static
+bool mergeKeymapNames(const QStringList& setxkbmapCommandArguments, KeymapNames* names)
+{
+	QStringList options = names->options.split(COMMAND_OPTIONS_SEPARATOR, QString::SkipEmptyParts);
+	bool variantSet = false;
+
+	for(int i=0; i<setxkbmapCommandArguments.count(); i++) {
+		const QString& argument = setxkbmapCommandArguments[i];
+		const bool hasValue = i+1 < setxkbmapCommandArguments.count() && ! setxkbmapCommandArguments[i+1].startsWith(QLatin1Char('-'));
+
+		if( argument == QLatin1String("-option") ) {
+			const QString value = hasValue ? setxkbmapCommandArguments[++i] : QString();
+			if( value.isEmpty() ) {	// an empty option resets the old ones
+				options.clear();
+			}
+			foreach(const QString& option, value.split(COMMAND_OPTIONS_SEPARATOR, QString::SkipEmptyParts)) {
+				if( ! options.contains(option) ) {
+					options.append(option);
+				}
+			}
+		}
+		else if( ! hasValue ) {
+			return false;
+		}
+		else if( argument == QLatin1String("-model") ) {
+			names->model = setxkbmapCommandArguments[++i];
+		}
+		else if( argument == QLatin1String("-layout") ) {
+			names->layout = setxkbmapCommandArguments[++i];
+			if( ! variantSet ) {
+				names->variant.clear();
+			}
+		}
+		else if( argument == QLatin1String("-variant") ) {
+			names->variant = setxkbmapCommandArguments[++i];
+			variantSet = true;
+		}
+		else {
+			return false;
+		}
+	}
+
+	if( names->rules.isEmpty() ) {
+		names->rules = QStringLiteral("evdev");
+	}
+	names->options = options.join(COMMAND_OPTIONS_SEPARATOR);
+	return ! names->layout.isEmpty();
+}
+
+// Keymap components the rules resolve to, by KeymapNames::key()
+struct KeymapComponents {
+	QByteArray keycodes;
+	QByteArray types;
+	QByteArray compat;
+	QByteArray symbols;
+	QByteArray geometry;
+};
+
+static QHash<QString, KeymapComponents> keymapComponentsCache;
+
+static
+char* nullIfEmpty(QByteArray& str)
+{
+	return str.isEmpty() ? NULL : str.data();
+}
+
+static
+bool resolveKeymapComponents(const KeymapNames& names, KeymapComponents* components)
+{
+	QByteArray rulesPath = QStringLiteral("%1/rules/%2").arg(Rules::findXkbDir(), names.rules).toLocal8Bit();
+	QByteArray locale("C");
+	XkbRF_RulesPtr rules = XkbRF_Load(rulesPath.data(), locale.data(), False, True);
+	if( rules == NULL ) {
+		qCWarning(KCM_KEYBOARD) << "Failed to load xkb rules" << rulesPath;
+		return false;
+	}
+
+	QByteArray model = names.model.toLatin1();
+	QByteArray layout = names.layout.toLatin1();
+	QByteArray variant = names.variant.toLatin1();
+	QByteArray options = names.options.toLatin1();
+
+	XkbRF_VarDefsRec varDefs;
+	memset(&varDefs, 0, sizeof(varDefs));
+	varDefs.model = nullIfEmpty(model);
+	varDefs.layout = nullIfEmpty(layout);
+	varDefs.variant = nullIfEmpty(variant);
+	varDefs.options = nullIfEmpty(options);
+
+	XkbComponentNamesRec componentNames;
+	memset(&componentNames, 0, sizeof(componentNames));
+	const bool resolved = XkbRF_GetComponents(rules, &varDefs, &componentNames);
+	XkbRF_Free(rules, True);
+
+	components->keycodes = componentNames.keycodes;
+	components->types = componentNames.types;
+	components->compat = componentNames.compat;
+	components->symbols = componentNames.symbols;
+	components->geometry = componentNames.geometry;
+	free(componentNames.keymap);
+	free(componentNames.keycodes);
+	free(componentNames.types);
+	free(componentNames.compat);
+	free(componentNames.symbols);
+	free(componentNames.geometry);
+
+	if( ! resolved || components->symbols.isEmpty() ) {
+		qCWarning(KCM_KEYBOARD) << "Failed to resolve keymap components for" << names.key();
+		return false;
+	}
+	return true;
+}
+
+static
+bool loadKeymap(const KeymapNames& names)
+{
+	QHash<QString, KeymapComponents>::iterator it = keymapComponentsCache.find(names.key());
+	if( it == keymapComponentsCache.end() ) {
+		KeymapComponents components;
+		if( ! resolveKeymapComponents(names, &components) )
+			return false;
+		it = keymapComponentsCache.insert(names.key(), components);
+	}
+
+	KeymapComponents components = it.value();
+	XkbComponentNamesRec componentNames;
+	memset(&componentNames, 0, sizeof(componentNames));
+	componentNames.keycodes = nullIfEmpty(components.keycodes);
+	componentNames.types = nullIfEmpty(components.types);
+	componentNames.compat = nullIfEmpty(components.compat);
+	componentNames.symbols = nullIfEmpty(components.symbols);
+	componentNames.geometry = nullIfEmpty(components.geometry);
+
+	Display* display = QX11Info::display();
+	XkbDescPtr xkb = XkbGetKeyboardByName(display, XkbUseCoreKbd, &componentNames,
+			XkbGBN_AllComponentsMask, XkbGBN_AllComponentsMask & (~XkbGBN_GeometryMask), True);
+	if( xkb == NULL ) {
+		qCWarning(KCM_KEYBOARD) << "X server failed to load the keymap for" << names.key();
+		keymapComponentsCache.erase(it);
+		return false;
+	}
+	XkbFreeKeyboard(xkb, XkbAllComponentsMask, True);
+
+	QByteArray rules = names.rules.toLatin1();
+	QByteArray model = names.model.toLatin1();
+	QByteArray layout = names.layout.toLatin1();
+	QByteArray variant = names.variant.toLatin1();
+	QByteArray options = names.options.toLatin1();
+
+	XkbRF_VarDefsRec varDefs;
+	memset(&varDefs, 0, sizeof(varDefs));
+	varDefs.model = nullIfEmpty(model);
+	varDefs.layout = nullIfEmpty(layout);
+	varDefs.variant = nullIfEmpty(variant);
+	varDefs.options = nullIfEmpty(options);
+	XkbRF_SetNamesProp(display, rules.data(), &varDefs);
+	return true;
 }
 
 //TODO: make private
@@ -119,6 +466,35 @@ bool XkbHelper::runConfigLayoutCommand(const QStringList& setxkbmapCommandArgume
 	return false;
 }
 
+bool XkbHelper::applyConfigLayout(const QStringList& setxkbmapCommandArguments, bool devicePlugged)
+{
+	if( ! QX11Info::isPlatformX11() )
+		return runConfigLayoutCommand(setxkbmapCommandArguments);
+
+	QTime timer;
+	timer.start();
+
+	const KeymapNames serverNames = getServerKeymapNames();
+	KeymapNames names = serverNames;
+	if( ! mergeKeymapNames(setxkbmapCommandArguments, &names) ) {
+		qCDebug(KCM_KEYBOARD) << "Can't apply" << setxkbmapCommandArguments << "in-process, running" << SETXKBMAP_EXEC;
+		return runConfigLayoutCommand(setxkbmapCommandArguments);
+	}
+
+	// the server resets _XKB_RULES_NAMES along with the keymap, e.g. when a keyboard is plugged in,
+	// so if they still match ours the keymap is still the one we loaded
+	const bool reload = ! (names == serverNames);
+	if( reload && ! loadKeymap(names) ) {
+		return runConfigLayoutCommand(setxkbmapCommandArguments);
+	}
+	qCDebug(KCM_KEYBOARD) << (reload ? "Loaded keymap in" : "Keymap is up to date, checked in") << timer.elapsed() << "ms" << names.key();
+
+	// a new device gets its core mapping from the keymap, not from what xmodmap changed on the others
+	restoreXmodmapInProcess(reload || devicePlugged);
+	qCDebug(KCM_KEYBOARD) << "\t and with xmodmap" << timer.elapsed() << "ms";
+	return true;
+}
+
 bool XkbHelper::initializeKeyboardLayouts(const QList<LayoutUnit>& layoutUnits)
 {
 	QStringList layouts;
@@ -136,10 +512,10 @@ bool XkbHelper::initializeKeyboardLayouts(const QList<LayoutUnit>& layoutUnits)
 		setxkbmapCommandArguments.append(variants.join(COMMAND_OPTIONS_SEPARATOR));
 	}
 
-	return runConfigLayoutCommand(setxkbmapCommandArguments);
+	return applyConfigLayout(setxkbmapCommandArguments);
 }
 
-bool XkbHelper::initializeKeyboardLayouts(KeyboardConfig& config)
+bool XkbHelper::initializeKeyboardLayouts(KeyboardConfig& config, bool devicePlugged)
 {
 	QStringList setxkbmapCommandArguments;
 	if( ! config.keyboardModel.isEmpty() ) {
@@ -175,7 +551,7 @@ bool XkbHelper::initializeKeyboardLayouts(KeyboardConfig& config)
 	}
 
 	if( ! setxkbmapCommandArguments.isEmpty() ) {
-		return runConfigLayoutCommand(setxkbmapCommandArguments);
+		return applyConfigLayout(setxkbmapCommandArguments, devicePlugged);
 		if( config.configureLayouts ) {
 			X11Helper::setDefaultLayout();
 		}
@@ -27,9 +27,12 @@ class KeyboardConfig;
 
 class XkbHelper {
 public:
-	static bool initializeKeyboardLayouts(KeyboardConfig& config);
+	static bool initializeKeyboardLayouts(KeyboardConfig& config, bool devicePlugged=false);
 	static bool initializeKeyboardLayouts(const QList<LayoutUnit>& layouts);
 	static bool runConfigLayoutCommand(const QStringList& setxkbmapCommandArguments);
+	// Applies setxkbmap arguments without running setxkbmap and xmodmap, falls back to them if needed;
+	// devicePlugged re-applies .Xmodmap even if the keymap itself is up to date
+	static bool applyConfigLayout(const QStringList& setxkbmapCommandArguments, bool devicePlugged=false);
     static bool preInitialize();
 };
 
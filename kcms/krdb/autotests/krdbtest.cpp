@@ -0,0 +1,149 @@
+/*
+   This file is part of the KDE base distribution
+   Copyright (c) 2017 The KDE Project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "../krdb.h"
+
+#include <QtTest/QtTest>
+#include <QX11Info>
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+#include <limits.h>
+
+class KrdbTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void testMerge();
+    void testDefines();
+    void testRemove();
+    void testUnchanged();
+    void testMultiLineValue();
+    void testNeedsPreprocessor();
+
+private:
+    QByteArray resources() const;
+    void setResources(const QByteArray &data);
+};
+
+QByteArray KrdbTest::resources() const
+{
+    Display *dpy = QX11Info::display();
+    Atom type;
+    int format;
+    unsigned long count, remaining;
+    unsigned char *data = nullptr;
+    QByteArray result;
+    if (XGetWindowProperty(dpy, RootWindow(dpy, 0), XA_RESOURCE_MANAGER, 0, LONG_MAX / 4, False, XA_STRING,
+                           &type, &format, &count, &remaining, &data) == Success && data) {
+        result = QByteArray(reinterpret_cast<const char *>(data), count);
+        XFree(data);
+    }
+    return result;
+}
+
+void KrdbTest::setResources(const QByteArray &data)
+{
+    Display *dpy = QX11Info::display();
+    XChangeProperty(dpy, RootWindow(dpy, 0), XA_RESOURCE_MANAGER, XA_STRING, 8, PropModeReplace,
+                    reinterpret_cast<const unsigned char *>(data.constData()), data.size());
+    XSync(dpy, False);
+}
+
+void KrdbTest::initTestCase()
+{
+    if (!QX11Info::isPlatformX11()) {
+        QSKIP("This test needs an X server, e.g. Xvfb");
+    }
+}
+
+void KrdbTest::init()
+{
+    setResources("Xcursor.theme:\tbreeze_cursors\n*background:\t#000000\n");
+}
+
+void KrdbTest::testMerge()
+{
+    QVERIFY(mergeXResources("*background: #ffffff\nXft.dpi: 96\n"));
+    QCOMPARE(resources(), QByteArray("*background:\t#ffffff\nXcursor.theme:\tbreeze_cursors\nXft.dpi:\t96\n"));
+}
+
+void KrdbTest::testDefines()
+{
+    QVERIFY(mergeXResources("#define BACKGROUND #eff0f1\n"
+                            "#define FOREGROUND #31363b\n"
+                            "! a comment\n"
+                            "*background: BACKGROUND\n"
+                            "*foreground:\tFOREGROUND\n"
+                            "*Button.activeBackground: \\\nBACKGROUND\n"));
+    QCOMPARE(resources(), QByteArray("*Button.activeBackground:\t#eff0f1\n*background:\t#eff0f1\n*foreground:\t#31363b\nXcursor.theme:\tbreeze_cursors\n"));
+}
+
+void KrdbTest::testRemove()
+{
+    setResources("Xft.dpi:\t120\nXcursor.theme:\tbreeze_cursors\n");
+    QVERIFY(mergeXResources("Xcursor.size: 24\n", QList<QByteArray>() << "Xft.dpi"));
+    QCOMPARE(resources(), QByteArray("Xcursor.size:\t24\nXcursor.theme:\tbreeze_cursors\n"));
+}
+
+void KrdbTest::testUnchanged()
+{
+    const QByteArray sorted("*background:\t#000000\nXcursor.theme:\tbreeze_cursors\n");
+    setResources(sorted);
+
+    // a property write would generate a PropertyNotify on the root window
+    Display *dpy = QX11Info::display();
+    XSelectInput(dpy, RootWindow(dpy, 0), PropertyChangeMask);
+    XSync(dpy, False);
+
+    QVERIFY(mergeXResources("Xcursor.theme: breeze_cursors\n"));
+    XSync(dpy, False);
+
+    XEvent event;
+    QVERIFY(!XCheckTypedWindowEvent(dpy, RootWindow(dpy, 0), PropertyNotify, &event));
+    XSelectInput(dpy, RootWindow(dpy, 0), NoEventMask);
+    QCOMPARE(resources(), sorted);
+}
+
+void KrdbTest::testMultiLineValue()
+{
+    const QByteArray translations("*VT100.translations:\t#override \\n\\\n"
+                                  "\t<Key>F1: string(\"a\") \\n\\\n"
+                                  "\t<Key>F2: string(\"b\")\n");
+    setResources(translations + "*background:\t#000000\nXcursor.theme:\tbreeze_cursors\n");
+
+    QVERIFY(mergeXResources("*background: #ffffff\n"));
+    QCOMPARE(resources(), translations + "*background:\t#ffffff\nXcursor.theme:\tbreeze_cursors\n");
+}
+
+void KrdbTest::testNeedsPreprocessor()
+{
+    const QByteArray before = resources();
+    QVERIFY(!mergeXResources("#ifdef COLOR\n*background: #ffffff\n#endif\n"));
+    QVERIFY(!mergeXResources("#include \"foo\"\n"));
+    QVERIFY(!mergeXResources("/* comment */\n*background: #ffffff\n"));
+    QVERIFY(!mergeXResources("#define RGB(r, g, b) r g b\n"));
+    QCOMPARE(resources(), before);
+}
+
+QTEST_MAIN(KrdbTest)
+#include "krdbtest.moc"
@@ -33,6 +33,10 @@
 
 #include <QPixmap>
 #include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QTemporaryFile>
 #include <QTextStream>
 #include <QDateTime>
 #include <QtDBus/QtDBus>
@@ -48,6 +52,7 @@
 #include "krdb.h"
 #if HAVE_X11
 #include <X11/Xlib.h>
+#include <X11/Xatom.h>
 #include <QX11Info>
 #endif
 inline const char * gtkEnvVar(int version)
@@ -229,17 +234,278 @@ static void addColorDef(QString& s, const char* n, const QColor& col)
 
 // -----------------------------------------------------------------------------
 
-static void copyFile(QFile& tmp, QString const& filename, bool )
+static void copyFile(QByteArray& tmp, QString const& filename, bool )
 {
   QFile f( filename );
   if ( f.open(QIODevice::ReadOnly) ) {
-      QByteArray buf( 8192, ' ' );
-      while ( !f.atEnd() ) {
-          int read = f.read( buf.data(), buf.size() );
-          if ( read > 0 )
-              tmp.write( buf.data(), read );
-      }
+      tmp += f.readAll();
+      // the next file must start on a line of its own
+      if ( !tmp.isEmpty() && !tmp.endsWith('\n') )
+          tmp += '\n';
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+static bool isIdentifierChar( char c )
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static QByteArray expandMacros( const QByteArray& line, const QHash<QByteArray, QByteArray>& macros )
+{
+  if ( macros.isEmpty() )
+    return line;
+
+  QByteArray result;
+  result.reserve( line.size() );
+  bool inString = false;
+  int i = 0;
+  while ( i < line.size() ) {
+    const char c = line.at( i );
+    if ( c == '"' )
+      inString = !inString;
+    if ( inString || !isIdentifierChar( c ) ) {
+      result += c;
+      ++i;
+      continue;
+    }
+    int end = i;
+    while ( end < line.size() && isIdentifierChar( line.at( end ) ) )
+      ++end;
+    const QByteArray token = line.mid( i, end - i );
+    result += macros.value( token, token );
+    i = end;
   }
+  return result;
+}
+
+/*
+ * xrdb has cpp predefine symbols describing the display (SERVERHOST, WIDTH,
+ * COLOR, ...) and cpp adds a few of its own. We don't define any of them,
+ * so input that refers to one is left to xrdb rather than merged unexpanded.
+ */
+static bool usesXrdbSymbol( const QByteArray& line, const QHash<QByteArray, QByteArray>& macros )
+{
+  static const QSet<QByteArray> symbols = {
+    "SERVERHOST", "HOST", "DISPLAY_NUM", "CLIENTHOST", "VERSION", "REVISION",
+    "VENDOR", "RELEASE", "NUM_SCREENS", "BITS_PER_RGB", "CLASS", "COLOR",
+    "WIDTH", "HEIGHT", "X_RESOLUTION", "Y_RESOLUTION", "PLANES", "unix", "linux"
+  };
+  static const QByteArray prefixes[] = { "SRVR_", "CLNT_", "VNDR_", "CLASS_", "EXT_", "__" };
+
+  bool inString = false;
+  int i = 0;
+  while ( i < line.size() ) {
+    const char c = line.at( i );
+    if ( c == '"' )
+      inString = !inString;
+    if ( inString || !isIdentifierChar( c ) ) {
+      ++i;
+      continue;
+    }
+    int end = i;
+    while ( end < line.size() && isIdentifierChar( line.at( end ) ) )
+      ++end;
+    const QByteArray token = line.mid( i, end - i );
+    i = end;
+    if ( macros.contains( token ) )
+      continue;
+    if ( symbols.contains( token ) )
+      return true;
+    for ( const QByteArray& prefix : prefixes )
+      if ( token.startsWith( prefix ) )
+        return true;
+  }
+  return false;
+}
+
+/*
+ * Does the small part of what cpp does for "xrdb -merge" that our own
+ * generated resources and the usual ~/.Xresources need: line splicing and
+ * object-like #define/#undef. Returns false if anything else shows up,
+ * including the symbols only xrdb defines, the caller must leave such
+ * input to xrdb then.
+ */
+static bool preprocessResources( const QByteArray& input, QList<QByteArray>& lines )
+{
+  if ( input.contains( "/*" ) )
+    return false;
+
+  QByteArray spliced = input;
+  spliced.replace( "\\\n", "" );
+
+  QHash<QByteArray, QByteArray> macros;
+  foreach ( const QByteArray& rawLine, spliced.split( '\n' ) ) {
+    const QByteArray line = rawLine.trimmed();
+    if ( !line.startsWith( '#' ) ) {
+      if ( usesXrdbSymbol( rawLine, macros ) )
+        return false;
+      lines << expandMacros( rawLine, macros );
+      continue;
+    }
+
+    const QByteArray directive = line.mid( 1 ).trimmed();
+    if ( directive.isEmpty() )
+      continue;
+
+    int nameEnd = 0;
+    while ( nameEnd < directive.size() && isIdentifierChar( directive.at( nameEnd ) ) )
+      ++nameEnd;
+    const QByteArray keyword = directive.left( nameEnd );
+    const QByteArray rest = directive.mid( nameEnd ).trimmed();
+
+    int macroEnd = 0;
+    while ( macroEnd < rest.size() && isIdentifierChar( rest.at( macroEnd ) ) )
+      ++macroEnd;
+    const QByteArray macro = rest.left( macroEnd );
+    if ( macro.isEmpty() )
+      return false;
+
+    if ( keyword == "define" ) {
+      // function-like macros are cpp's business
+      if ( rest.size() > macroEnd && rest.at( macroEnd ) == '(' )
+        return false;
+      macros.insert( macro, expandMacros( rest.mid( macroEnd ).trimmed(), macros ) );
+    } else if ( keyword == "undef" ) {
+      macros.remove( macro );
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses "resource: value" lines the way xrdb stores them, later entries win.
+static void parseResources( const QList<QByteArray>& lines, QMap<QByteArray, QByteArray>& db )
+{
+  foreach ( const QByteArray& line, lines ) {
+    const QByteArray trimmed = line.trimmed();
+    if ( trimmed.isEmpty() || trimmed.startsWith( '!' ) )
+      continue;
+
+    const int colon = line.indexOf( ':' );
+    if ( colon < 0 )
+      continue;
+
+    QByteArray name = line.left( colon ).simplified();
+    name.replace( ' ', "" );
+    if ( name.isEmpty() )
+      continue;
+
+    QByteArray value = line.mid( colon + 1 );
+    int start = 0;
+    while ( start < value.size() && (value.at( start ) == ' ' || value.at( start ) == '\t') )
+      ++start;
+    value = value.mid( start );
+    if ( value.endsWith( '\r' ) )
+      value.chop( 1 );
+
+    db.insert( name, value );
+  }
+}
+
+// Splits the resource database into entries, keeping backslash-newline
+// continuations of multi-line values such as translations inside their entry.
+static QList<QByteArray> splitResourceLines( const QByteArray& data )
+{
+  QList<QByteArray> lines;
+  bool continued = false;
+  foreach ( const QByteArray& line, data.split( '\n' ) ) {
+    if ( continued )
+      lines.last() += '\n' + line;
+    else
+      lines << line;
+
+    int backslashes = 0;
+    while ( backslashes < line.size() && line.at( line.size() - 1 - backslashes ) == '\\' )
+      ++backslashes;
+    continued = backslashes % 2 == 1;
+  }
+  return lines;
+}
+
+bool mergeXResources( const QByteArray& entries, const QList<QByteArray>& remove )
+{
+#if HAVE_X11
+  if ( !QX11Info::isPlatformX11() )
+    return false;
+
+  QList<QByteArray> lines;
+  if ( !preprocessResources( entries, lines ) )
+    return false;
+
+  Display *dpy = QX11Info::display();
+  const Window root = RootWindow( dpy, 0 );
+
+  QByteArray current;
+  Atom type;
+  int format;
+  unsigned long count, remaining;
+  unsigned char *data = nullptr;
+  if ( XGetWindowProperty( dpy, root, XA_RESOURCE_MANAGER, 0, LONG_MAX / 4, False, XA_STRING,
+                           &type, &format, &count, &remaining, &data ) == Success && data ) {
+    if ( type == XA_STRING && format == 8 )
+      current = QByteArray( reinterpret_cast<const char *>( data ), count );
+    XFree( data );
+  }
+
+  QMap<QByteArray, QByteArray> db;
+  parseResources( splitResourceLines( current ), db );
+  parseResources( lines, db );
+  foreach ( const QByteArray& name, remove )
+    db.remove( name );
+
+  QByteArray merged;
+  merged.reserve( current.size() + entries.size() );
+  for ( auto it = db.constBegin(); it != db.constEnd(); ++it )
+    merged += it.key() + ":\t" + it.value() + '\n';
+
+  if ( merged != current ) {
+    XChangeProperty( dpy, root, XA_RESOURCE_MANAGER, XA_STRING, 8, PropModeReplace,
+                     reinterpret_cast<const unsigned char *>( merged.constData() ), merged.size() );
+    XFlush( dpy );
+  }
+  return true;
+#else
+  Q_UNUSED( entries )
+  Q_UNUSED( remove )
+  return false;
+#endif
+}
+
+static void runXrdb( const QByteArray& entries, const QList<QByteArray>& remove )
+{
+  if ( !remove.isEmpty() )
+  {
+    KProcess proc;
+    proc << QStringLiteral("xrdb") << QStringLiteral("-quiet") << QStringLiteral("-remove") << QStringLiteral("-nocpp");
+    proc.start();
+    if (proc.waitForStarted())
+    {
+      foreach ( const QByteArray& name, remove )
+        proc.write( name + '\n' );
+      proc.closeWriteChannel();
+      proc.waitForFinished();
+    }
+  }
+
+  QTemporaryFile tmpFile;
+  if (!tmpFile.open())
+  {
+    qDebug() << "Couldn't open temp file";
+    exit(0);
+  }
+  tmpFile.write( entries );
+  tmpFile.flush();
+
+  KProcess proc;
+#ifndef NDEBUG
+  proc << QStringLiteral("xrdb") << QStringLiteral("-merge") << tmpFile.fileName();
+#else
+  proc << "xrdb" << "-quiet" << "-merge" << tmpFile.fileName();
+#endif
+  proc.execute();
 }
 
 
@@ -415,13 +681,8 @@ void runRdb( uint flags )
   KConfigGroup kglobals(kglobalcfg, "KDE");
   QPalette newPal = KColorScheme::createApplicationPalette(kglobalcfg);
 
-  QTemporaryFile tmpFile;
-  if (!tmpFile.open())
-  {
-    qDebug() << "Couldn't open temp file";
-    exit(0);
-  }
-
+  QByteArray preprocessed;
+  QList<QByteArray> removedResources;
 
   KConfigGroup generalCfgGroup(kglobalcfg, "General");
 
@@ -454,7 +715,7 @@ void runRdb( uint flags )
     addColorDef(preproc, "ACTIVE_FOREGROUND"  , g.readEntry("activeBackground", QColor(48, 174, 232)));
     //---------------------------------------------------------------
 
-    tmpFile.write( preproc.toLatin1(), preproc.length() );
+    preprocessed += preproc.toLatin1();
 
     QStringList list;
 
@@ -472,7 +733,7 @@ void runRdb( uint flags )
     }
 
     for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it)
-      copyFile(tmpFile, QStandardPaths::locate(QStandardPaths::GenericDataLocation, "kdisplay/app-defaults/"+(*it)), true);
+      copyFile(preprocessed, QStandardPaths::locate(QStandardPaths::GenericDataLocation, "kdisplay/app-defaults/"+(*it)), true);
   }
 
   // Merge ~/.Xresources or fallback to ~/.Xdefaults
@@ -481,9 +742,9 @@ void runRdb( uint flags )
 
   // very primitive support for ~/.Xresources by appending it
   if ( QFile::exists( xResources ) )
-    copyFile(tmpFile, xResources, true);
+    copyFile(preprocessed, xResources, true);
   else
-    copyFile(tmpFile, homeDir + "/.Xdefaults", true);
+    copyFile(preprocessed, homeDir + "/.Xdefaults", true);
 
   // Export the Xcursor theme & size settings
   KConfigGroup mousecfg(KSharedConfig::openConfig( QStringLiteral("kcminputrc") ), "Mouse" );
@@ -537,31 +798,16 @@ void runRdb( uint flags )
     if( cfgfonts.readEntry( "forceFontDPI", 0 ) != 0 )
       contents += "Xft.dpi: " + cfgfonts.readEntry( "forceFontDPI" ) + '\n';
     else
-    {
-      KProcess proc;
-      proc << QStringLiteral("xrdb") << QStringLiteral("-quiet") << QStringLiteral("-remove") << QStringLiteral("-nocpp");
-      proc.start();
-      if (proc.waitForStarted())
-      {
-        proc.write( QByteArray( "Xft.dpi\n" ) );
-        proc.closeWriteChannel();
-        proc.waitForFinished();
-      }
-    }
+      removedResources << QByteArrayLiteral("Xft.dpi");
   }
 
   if (contents.length() > 0)
-    tmpFile.write( contents.toLatin1(), contents.length() );
-
-  tmpFile.flush();
+    preprocessed += contents.toLatin1();
 
-  KProcess proc;
-#ifndef NDEBUG
-  proc << QStringLiteral("xrdb") << QStringLiteral("-merge") << tmpFile.fileName();
-#else
-  proc << "xrdb" << "-quiet" << "-merge" << tmpFile.fileName();
-#endif
-  proc.execute();
+  // Merging in-process is a single property round trip, xrdb is only
+  // needed for input that requires the real preprocessor
+  if ( !mergeXResources( preprocessed, removedResources ) )
+    runXrdb( preprocessed, removedResources );
 
   applyGtkStyles(exportColors, 1);
   applyGtkStyles(exportColors, 2);
@@ -20,6 +20,9 @@
 #ifndef _KRDB_H_
 #define _KRDB_H_
 
+#include <QByteArray>
+#include <QList>
+
 enum KRdbAction
 {
    KRdbExportColors      = 0x0001,   // Export colors to non-(KDE/Qt) apps
@@ -31,4 +34,15 @@ enum KRdbAction
 
 void runRdb( uint flags );
 
+/**
+ * Merges the X resources in @p entries into the RESOURCE_MANAGER property
+ * of the root window and drops the resources named in @p remove, which is
+ * what "xrdb -merge" and "xrdb -remove" do. The property is only rewritten
+ * if its contents change.
+ *
+ * @return false if there is no X connection or @p entries needs more of the
+ * C preprocessor than object-like macros; nothing is changed in that case.
+ */
+bool mergeXResources( const QByteArray& entries, const QList<QByteArray>& remove = QList<QByteArray>() );
+
 #endif
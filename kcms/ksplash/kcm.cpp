@@ -18,6 +18,7 @@
 */
 
 #include "kcm.h"
+#include "../lookandfeel/lookandfeelcatalogue.h"
 
 #include <KPluginFactory>
 #include <KPluginLoader>
@@ -59,29 +60,6 @@ KCMSplashScreen::KCMSplashScreen(QObject* parent, const QVariantList& args)
     m_model->setItemRoleNames(roles);
 }
 
-QList<Plasma::Package> KCMSplashScreen::availablePackages(const QString &component)
-{
-    QList<Plasma::Package> packages;
-    QStringList paths;
-    QStringList dataPaths = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
-
-    for (const QString &path : dataPaths) {
-        QDir dir(path + "/plasma/look-and-feel");
-        paths << dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-    }
-
-    for (const QString &path : paths) {
-        Plasma::Package pkg = Plasma::PluginLoader::self()->loadPackage(QStringLiteral("Plasma/LookAndFeel"));
-        pkg.setPath(path);
-        pkg.setFallbackPackage(Plasma::Package());
-        if (component.isEmpty() || !pkg.filePath(component.toUtf8()).isEmpty()) {
-            packages << pkg;
-        }
-    }
-
-    return packages;
-}
-
 QStandardItemModel *KCMSplashScreen::splashModel()
 {
     return m_model;
@@ -126,11 +104,11 @@ void KCMSplashScreen::load()
     row->setData("None", PluginNameRole);
     m_model->appendRow(row);
 
-    const QList<Plasma::Package> pkgs = availablePackages(QStringLiteral("splashmainscript"));
-    for (const Plasma::Package &pkg : pkgs) {
-        QStandardItem* row = new QStandardItem(pkg.metadata().name());
-        row->setData(pkg.metadata().pluginName(), PluginNameRole);
-        row->setData(pkg.filePath("previews", QStringLiteral("splash.png")), ScreenhotRole);
+    const QList<LookAndFeelCatalogue::Entry> pkgs = LookAndFeelCatalogue::packages(LookAndFeelCatalogue::HasSplash);
+    for (const LookAndFeelCatalogue::Entry &pkg : pkgs) {
+        QStandardItem* row = new QStandardItem(pkg.name);
+        row->setData(pkg.pluginName, PluginNameRole);
+        row->setData(pkg.splashPreview, ScreenhotRole);
         m_model->appendRow(row);
     }
     setNeedsSave(false);
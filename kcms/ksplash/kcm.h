@@ -42,8 +42,6 @@ public:
     };
     KCMSplashScreen(QObject* parent, const QVariantList& args);
 
-    QList<Plasma::Package> availablePackages(const QString &component);
-
     QStandardItemModel *splashModel();
 
     QString selectedPlugin() const;
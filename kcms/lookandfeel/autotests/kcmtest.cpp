@@ -40,6 +40,7 @@ private Q_SLOTS:
     void testLockScreen();
     void testWindowSwitcher();
     void testDesktopSwitcher();
+    void testBatchedApply();
     void testKCMSave();
 
 private:
@@ -177,6 +178,37 @@ void KcmTest::testDesktopSwitcher()
     QCOMPARE(cg.readEntry("DesktopListLayout", QString()), QStringLiteral("customTestValue"));
 }
 
+void KcmTest::testBatchedApply()
+{
+    m_KCMLookandFeel->beginBatch();
+    m_KCMLookandFeel->setPlasmaTheme(QStringLiteral("batchedTestValue"));
+    m_KCMLookandFeel->setWindowSwitcher(QStringLiteral("batchedTestValue"));
+    m_KCMLookandFeel->setDesktopSwitcher(QStringLiteral("batchedTestValue"));
+
+    // nothing reaches the disk before the batch ends
+    {
+        KConfig plasmaConfig(QStringLiteral("plasmarc"));
+        KConfigGroup cg(&plasmaConfig, "Theme");
+        QCOMPARE(cg.readEntry("name", QString()), QString("customTestValue"));
+
+        KConfig kwinConfig(QStringLiteral("kwinrc"));
+        cg = KConfigGroup(&kwinConfig, "TabBox");
+        QCOMPARE(cg.readEntry("LayoutName", QString()), QStringLiteral("customTestValue"));
+    }
+
+    m_KCMLookandFeel->endBatch();
+
+    KConfig plasmaConfig(QStringLiteral("plasmarc"));
+    KConfigGroup cg(&plasmaConfig, "Theme");
+    QCOMPARE(cg.readEntry("name", QString()), QString("batchedTestValue"));
+
+    KConfig kwinConfig(QStringLiteral("kwinrc"));
+    cg = KConfigGroup(&kwinConfig, "TabBox");
+    QCOMPARE(cg.readEntry("LayoutName", QString()), QStringLiteral("batchedTestValue"));
+    QCOMPARE(cg.readEntry("DesktopLayout", QString()), QStringLiteral("batchedTestValue"));
+    QCOMPARE(cg.readEntry("DesktopListLayout", QString()), QStringLiteral("batchedTestValue"));
+}
+
 void KcmTest::testKCMSave()
 {
     m_KCMLookandFeel->save();
@@ -18,6 +18,7 @@
 */
 
 #include "kcm.h"
+#include "lookandfeelcatalogue.h"
 #include "../krdb/krdb.h"
 #include "../cursortheme/xcursor/xcursortheme.h"
 #include "config-kcm.h"
@@ -61,6 +62,9 @@ KCMLookandFeel::KCMLookandFeel(QObject* parent, const QVariantList& args)
     : KQuickAddons::ConfigModule(parent, args)
     , m_config(QStringLiteral("kdeglobals"))
     , m_configGroup(m_config.group("KDE"))
+    , m_batching(false)
+    , m_pendingChanges(NoChange)
+    , m_pendingRdbFlags(0)
     , m_applyColors(true)
     , m_applyWidgetStyle(true)
     , m_applyIcons(true)
@@ -153,29 +157,6 @@ int KCMLookandFeel::selectedPluginIndex() const
     return -1;
 }
 
-QList<Plasma::Package> KCMLookandFeel::availablePackages(const QString &component)
-{
-    QList<Plasma::Package> packages;
-    QStringList paths;
-    const QStringList dataPaths = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
-
-    for (const QString &path : dataPaths) {
-        QDir dir(path + "/plasma/look-and-feel");
-        paths << dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-    }
-
-    for (const QString &path : paths) {
-        Plasma::Package pkg = Plasma::PluginLoader::self()->loadPackage(QStringLiteral("Plasma/LookAndFeel"));
-        pkg.setPath(path);
-        pkg.setFallbackPackage(Plasma::Package());
-        if (component.isEmpty() || !pkg.filePath(component.toUtf8()).isEmpty()) {
-            packages << pkg;
-        }
-    }
-
-    return packages;
-}
-
 void KCMLookandFeel::load()
 {
     m_package = Plasma::PluginLoader::self()->loadPackage(QStringLiteral("Plasma/LookAndFeel"));
@@ -192,54 +173,28 @@ void KCMLookandFeel::load()
     setSelectedPlugin(m_package.metadata().pluginName());
 
     m_model->clear();
+    // Themes may have been installed or removed since the last load
+    m_cursorThemeDirs.clear();
 
-    const QList<Plasma::Package> pkgs = availablePackages();
-    for (const Plasma::Package &pkg : pkgs) {
-        if (!pkg.metadata().isValid()) {
-            continue;
-        }
-        QStandardItem* row = new QStandardItem(pkg.metadata().name());
-        row->setData(pkg.metadata().pluginName(), PluginNameRole);
-        row->setData(pkg.filePath("preview"), ScreenhotRole);
-        row->setData(pkg.filePath("fullscreenpreview"), FullScreenPreviewRole);
+    const QList<LookAndFeelCatalogue::Entry> pkgs = LookAndFeelCatalogue::packages();
+    for (const LookAndFeelCatalogue::Entry &pkg : pkgs) {
+        QStandardItem* row = new QStandardItem(pkg.name);
+        row->setData(pkg.pluginName, PluginNameRole);
+        row->setData(pkg.preview, ScreenhotRole);
+        row->setData(pkg.fullScreenPreview, FullScreenPreviewRole);
 
         //What the package provides
-        row->setData(!pkg.filePath("splashmainscript").isEmpty(), HasSplashRole);
-        row->setData(!pkg.filePath("lockscreenmainscript").isEmpty(), HasLockScreenRole);
-        row->setData(!pkg.filePath("runcommandmainscript").isEmpty(), HasRunCommandRole);
-        row->setData(!pkg.filePath("logoutmainscript").isEmpty(), HasLogoutRole);
-
-        if (!pkg.filePath("defaults").isEmpty()) {
-            KSharedConfigPtr conf = KSharedConfig::openConfig(pkg.filePath("defaults"));
-            KConfigGroup cg(conf, "kdeglobals");
-            cg = KConfigGroup(&cg, "General");
-            bool hasColors = !cg.readEntry("ColorScheme", QString()).isEmpty();
-            if (!hasColors) {
-                hasColors = !pkg.filePath("colors").isEmpty();
-            }
-            row->setData(hasColors, HasColorsRole);
-            cg = KConfigGroup(&cg, "KDE");
-            row->setData(!cg.readEntry("widgetStyle", QString()).isEmpty(), HasWidgetStyleRole);
-            cg = KConfigGroup(conf, "kdeglobals");
-            cg = KConfigGroup(&cg, "Icons");
-            row->setData(!cg.readEntry("Theme", QString()).isEmpty(), HasIconsRole);
-
-            cg = KConfigGroup(conf, "kdeglobals");
-            cg = KConfigGroup(&cg, "Theme");
-            row->setData(!cg.readEntry("name", QString()).isEmpty(), HasPlasmaThemeRole);
-
-            cg = KConfigGroup(conf, "kcminputrc");
-            cg = KConfigGroup(&cg, "Mouse");
-            row->setData(!cg.readEntry("cursorTheme", QString()).isEmpty(), HasCursorsRole);
-
-            cg = KConfigGroup(conf, "kwinrc");
-            cg = KConfigGroup(&cg, "WindowSwitcher");
-            row->setData(!cg.readEntry("LayoutName", QString()).isEmpty(), HasWindowSwitcherRole);
-
-            cg = KConfigGroup(conf, "kwinrc");
-            cg = KConfigGroup(&cg, "DesktopSwitcher");
-            row->setData(!cg.readEntry("LayoutName", QString()).isEmpty(), HasDesktopSwitcherRole);
-        }
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasSplash), HasSplashRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasLockScreen), HasLockScreenRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasRunCommand), HasRunCommandRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasLogout), HasLogoutRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasColors), HasColorsRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasWidgetStyle), HasWidgetStyleRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasIcons), HasIconsRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasPlasmaTheme), HasPlasmaThemeRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasCursors), HasCursorsRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasWindowSwitcher), HasWindowSwitcherRole);
+        row->setData(bool(pkg.capabilities & LookAndFeelCatalogue::HasDesktopSwitcher), HasDesktopSwitcherRole);
 
         m_model->appendRow(row);
     }
@@ -256,6 +211,8 @@ void KCMLookandFeel::save()
         return;
     }
 
+    beginBatch();
+
     m_configGroup.writeEntry("LookAndFeelPackage", m_selectedPlugin);
 
     QDBusMessage message;
@@ -364,10 +321,7 @@ void KCMLookandFeel::save()
 
         // Reload KWin if something changed, but only once.
         if (m_applyWindowSwitcher || m_applyDesktopSwitcher || m_applyWindowDecoration) {
-            QDBusMessage message = QDBusMessage::createSignal(QStringLiteral("/KWin"),
-                                                    QStringLiteral("org.kde.KWin"),
-                                                    QStringLiteral("reloadConfig"));
-            QDBusConnection::sessionBus().send(message);
+            m_pendingChanges |= KWinChange;
         }
     }
 
@@ -375,8 +329,97 @@ void KCMLookandFeel::save()
     setSplashScreen(m_selectedPlugin);
     setLockScreen(m_selectedPlugin);
 
-    m_configGroup.sync();
-    runRdb(KRdbExportQtColors | KRdbExportGtkTheme | KRdbExportColors | KRdbExportQtSettings | KRdbExportXftSettings);
+    m_pendingChanges |= ResourcesChange;
+    m_pendingRdbFlags |= KRdbExportQtColors | KRdbExportGtkTheme | KRdbExportColors | KRdbExportQtSettings | KRdbExportXftSettings;
+    endBatch();
+}
+
+void KCMLookandFeel::beginBatch()
+{
+    m_batching = true;
+}
+
+void KCMLookandFeel::endBatch()
+{
+    if (!m_batching) {
+        return;
+    }
+    m_batching = false;
+
+    // every file is written once, and before anyone is told to reload it
+    m_config.sync();
+    for (const KSharedConfigPtr &config : qAsConst(m_stagedConfigs)) {
+        config->sync();
+    }
+    m_stagedConfigs.clear();
+
+    const PendingChanges changes = m_pendingChanges;
+    const uint rdbFlags = m_pendingRdbFlags;
+    m_pendingChanges = NoChange;
+    m_pendingRdbFlags = 0;
+
+    notifyChanges(changes, rdbFlags);
+}
+
+KSharedConfigPtr KCMLookandFeel::stagedConfig(const QString &name)
+{
+    // the shared instance keeps staged entries around until endBatch()
+    return KSharedConfig::openConfig(name);
+}
+
+void KCMLookandFeel::commitConfig(const KSharedConfigPtr &config)
+{
+    if (!m_batching) {
+        config->sync();
+    } else if (!m_stagedConfigs.contains(config)) {
+        m_stagedConfigs << config;
+    }
+}
+
+void KCMLookandFeel::commitGlobals()
+{
+    if (!m_batching) {
+        m_config.sync();
+    }
+}
+
+void KCMLookandFeel::notifyChanges(PendingChanges changes, uint rdbFlags)
+{
+    if (m_batching) {
+        m_pendingChanges |= changes;
+        m_pendingRdbFlags |= rdbFlags;
+        return;
+    }
+
+    if (changes & ResourcesChange) {
+        runRdb(rdbFlags);
+    }
+
+    if (changes & PaletteChange) {
+        KGlobalSettings::self()->emitChange(KGlobalSettings::PaletteChanged);
+    }
+
+    if (changes & StyleChange) {
+        //FIXME: changing style on the fly breaks QQuickWidgets
+        KGlobalSettings::self()->emitChange(KGlobalSettings::StyleChanged);
+    }
+
+    if (changes & IconChange) {
+        for (int i=0; i < KIconLoader::LastGroup; i++) {
+            KIconLoader::emitChange(KIconLoader::Group(i));
+        }
+    }
+
+    if (changes & CursorChange) {
+        KGlobalSettings::self()->emitChange(KGlobalSettings::CursorChanged);
+    }
+
+    if (changes & KWinChange) {
+        QDBusMessage message = QDBusMessage::createSignal(QStringLiteral("/KWin"),
+                                                          QStringLiteral("org.kde.KWin"),
+                                                          QStringLiteral("reloadConfig"));
+        QDBusConnection::sessionBus().send(message);
+    }
 }
 
 void KCMLookandFeel::defaults()
@@ -395,9 +438,8 @@ void KCMLookandFeel::setWidgetStyle(const QString &style)
     }
 
     m_configGroup.writeEntry("widgetStyle", style);
-    m_configGroup.sync();
-    //FIXME: changing style on the fly breaks QQuickWidgets
-    KGlobalSettings::self()->emitChange(KGlobalSettings::StyleChanged);
+    commitGlobals();
+    notifyChanges(StyleChange);
 }
 
 void KCMLookandFeel::setColors(const QString &scheme, const QString &colorFile)
@@ -407,7 +449,7 @@ void KCMLookandFeel::setColors(const QString &scheme, const QString &colorFile)
     }
     KConfigGroup configGroup(&m_config, "General");
     configGroup.writeEntry("ColorScheme", scheme);
-    configGroup.sync();
+    commitGlobals();
 
     KSharedConfigPtr conf = KSharedConfig::openConfig(colorFile);
     foreach (const QString &grp, conf->groupList()) {
@@ -415,7 +457,7 @@ void KCMLookandFeel::setColors(const QString &scheme, const QString &colorFile)
       KConfigGroup cg2(&m_config, grp);
       cg.copyTo(&cg2);
     }
-    KGlobalSettings::self()->emitChange(KGlobalSettings::PaletteChanged);
+    notifyChanges(PaletteChange);
 }
 
 void KCMLookandFeel::setIcons(const QString &theme)
@@ -426,11 +468,9 @@ void KCMLookandFeel::setIcons(const QString &theme)
 
     KConfigGroup cg(&m_config, "Icons");
     cg.writeEntry("Theme", theme);
-    cg.sync();
+    commitGlobals();
 
-    for (int i=0; i < KIconLoader::LastGroup; i++) {
-        KIconLoader::emitChange(KIconLoader::Group(i));
-    }
+    notifyChanges(IconChange);
 }
 
 void KCMLookandFeel::setPlasmaTheme(const QString &theme)
@@ -439,10 +479,10 @@ void KCMLookandFeel::setPlasmaTheme(const QString &theme)
         return;
     }
 
-    KConfig config(QStringLiteral("plasmarc"));
-    KConfigGroup cg(&config, "Theme");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("plasmarc"));
+    KConfigGroup cg(config, "Theme");
     cg.writeEntry("name", theme);
-    cg.sync();
+    commitConfig(config);
 }
 
 void KCMLookandFeel::setCursorTheme(const QString themeName)
@@ -452,10 +492,10 @@ void KCMLookandFeel::setCursorTheme(const QString themeName)
         return;
     }
 
-    KConfig config(QStringLiteral("kcminputrc"));
-    KConfigGroup cg(&config, "Mouse");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("kcminputrc"));
+    KConfigGroup cg(config, "Mouse");
     cg.writeEntry("cursorTheme", themeName);
-    cg.sync();
+    commitConfig(config);
 
     // Require the Xcursor version that shipped with X11R6.9 or greater, since
     // in previous versions the Xfixes code wasn't enabled due to a bug in the
@@ -479,11 +519,9 @@ void KCMLookandFeel::setCursorTheme(const QString themeName)
                                        QDBusConnection::sessionBus());
     klauncher.setLaunchEnv(QStringLiteral("XCURSOR_THEME"), themeName);
 
-    // Update the Xcursor X resources
-    runRdb(0);
-
-    // Notify all applications that the cursor theme has changed
-    KGlobalSettings::self()->emitChange(KGlobalSettings::CursorChanged);
+    // Update the Xcursor X resources and notify all applications that
+    // the cursor theme has changed
+    notifyChanges(ResourcesChange | CursorChange);
 
     // Reload the standard cursors
     QStringList names;
@@ -523,6 +561,26 @@ QDir KCMLookandFeel::cursorThemeDir(const QString &theme, const int depth)
         return QDir();
     }
 
+    // Resolving a theme walks all search paths and their inherited themes,
+    // so remember the answer until the theme list is reloaded
+    auto it = m_cursorThemeDirs.find(theme);
+    if (it != m_cursorThemeDirs.end()) {
+        const QDir cached(*it);
+        if (cached.exists()) {
+            return cached;
+        }
+        m_cursorThemeDirs.erase(it);
+    }
+
+    const QDir dir = findCursorThemeDir(theme, depth);
+    if (dir.exists()) {
+        m_cursorThemeDirs.insert(theme, dir.path());
+    }
+    return dir;
+}
+
+QDir KCMLookandFeel::findCursorThemeDir(const QString &theme, const int depth)
+{
     // Search each icon theme directory for 'theme'
     foreach (const QString &baseDir, cursorSearchPaths()) {
         QDir dir(baseDir);
@@ -605,12 +663,12 @@ void KCMLookandFeel::setSplashScreen(const QString &theme)
         return;
     }
 
-    KConfig config(QStringLiteral("ksplashrc"));
-    KConfigGroup cg(&config, "KSplash");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("ksplashrc"));
+    KConfigGroup cg(config, "KSplash");
     cg.writeEntry("Theme", theme);
     //TODO: a way to set none as spash in the l&f
     cg.writeEntry("Engine", "KSplashQML");
-    cg.sync();
+    commitConfig(config);
 }
 
 void KCMLookandFeel::setLockScreen(const QString &theme)
@@ -619,10 +677,10 @@ void KCMLookandFeel::setLockScreen(const QString &theme)
         return;
     }
 
-    KConfig config(QStringLiteral("kscreenlockerrc"));
-    KConfigGroup cg(&config, "Greeter");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("kscreenlockerrc"));
+    KConfigGroup cg(config, "Greeter");
     cg.writeEntry("Theme", theme);
-    cg.sync();
+    commitConfig(config);
 }
 
 void KCMLookandFeel::setWindowSwitcher(const QString &theme)
@@ -631,10 +689,10 @@ void KCMLookandFeel::setWindowSwitcher(const QString &theme)
         return;
     }
 
-    KConfig config(QStringLiteral("kwinrc"));
-    KConfigGroup cg(&config, "TabBox");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("kwinrc"));
+    KConfigGroup cg(config, "TabBox");
     cg.writeEntry("LayoutName", theme);
-    cg.sync();
+    commitConfig(config);
 }
 
 void KCMLookandFeel::setDesktopSwitcher(const QString &theme)
@@ -643,11 +701,11 @@ void KCMLookandFeel::setDesktopSwitcher(const QString &theme)
         return;
     }
 
-    KConfig config(QStringLiteral("kwinrc"));
-    KConfigGroup cg(&config, "TabBox");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("kwinrc"));
+    KConfigGroup cg(config, "TabBox");
     cg.writeEntry("DesktopLayout", theme);
     cg.writeEntry("DesktopListLayout", theme);
-    cg.sync();
+    commitConfig(config);
 }
 
 void KCMLookandFeel::setWindowDecoration(const QString &library, const QString &theme)
@@ -656,17 +714,14 @@ void KCMLookandFeel::setWindowDecoration(const QString &library, const QString &
         return;
     }
 
-    KConfig config(QStringLiteral("kwinrc"));
-    KConfigGroup cg(&config, "org.kde.kdecoration2");
+    KSharedConfigPtr config = stagedConfig(QStringLiteral("kwinrc"));
+    KConfigGroup cg(config, "org.kde.kdecoration2");
     cg.writeEntry("library", library);
     cg.writeEntry("theme", theme);
-    
-    cg.sync();
+    commitConfig(config);
+
     // Reload KWin.
-    QDBusMessage message = QDBusMessage::createSignal(QStringLiteral("/KWin"),
-                                                      QStringLiteral("org.kde.KWin"),
-                                                      QStringLiteral("reloadConfig"));
-    QDBusConnection::sessionBus().send(message);
+    notifyChanges(KWinChange);
 }
 
 void KCMLookandFeel::setApplyColors(bool apply)
@@ -22,6 +22,7 @@
 
 #include <KConfig>
 #include <KConfigGroup>
+#include <KSharedConfig>
 #include <QListWidget>
 #include <QDir>
 
@@ -65,11 +66,21 @@ public:
         HasWindowSwitcherRole,
         HasDesktopSwitcherRole
     };
+
+    enum PendingChange {
+        NoChange = 0,
+        PaletteChange = 1 << 0,
+        StyleChange = 1 << 1,
+        IconChange = 1 << 2,
+        CursorChange = 1 << 3,
+        KWinChange = 1 << 4,
+        ResourcesChange = 1 << 5
+    };
+    Q_DECLARE_FLAGS(PendingChanges, PendingChange)
+
     KCMLookandFeel(QObject* parent, const QVariantList& args);
     ~KCMLookandFeel();
 
-    QList<Plasma::Package> availablePackages(const QString &component = QString());
-
     QStandardItemModel *lookAndFeelModel();
 
     QString selectedPlugin() const;
@@ -89,6 +100,18 @@ public:
     void setDesktopSwitcher(const QString &theme);
     void setWindowDecoration(const QString &library, const QString &theme);
 
+    /**
+     * Starts a batched apply: until endBatch() the setters above only stage
+     * their config writes and remember which change notifications are due.
+     */
+    void beginBatch();
+    /**
+     * Writes every config file touched since beginBatch() once, updates the
+     * X resources once and then sends a single notification per kind of
+     * change, so running applications reload everything in one pass.
+     */
+    void endBatch();
+
     void setApplyColors(bool apply);
     bool applyColors() const;
     void setApplyWidgetStyle(bool apply);
@@ -124,17 +147,30 @@ Q_SIGNALS:
     void selectedPluginIndexChanged();
 
 private:
+    KSharedConfigPtr stagedConfig(const QString &name);
+    void commitConfig(const KSharedConfigPtr &config);
+    void commitGlobals();
+    void notifyChanges(PendingChanges changes, uint rdbFlags = 0);
+
     QDir cursorThemeDir(const QString &theme, const int depth);
+    QDir findCursorThemeDir(const QString &theme, const int depth);
     const QStringList cursorSearchPaths();
     QStandardItemModel *m_model;
     Plasma::Package m_package;
     QString m_selectedPlugin;
     QStringList m_cursorSearchPaths;
+    QHash<QString, QString> m_cursorThemeDirs;
     QPointer<KNS3::DownloadDialog> m_newStuffDialog;
 
     KConfig m_config;
     KConfigGroup m_configGroup;
 
+    // state of a batched apply, see beginBatch()
+    bool m_batching;
+    PendingChanges m_pendingChanges;
+    uint m_pendingRdbFlags;
+    QList<KSharedConfigPtr> m_stagedConfigs;
+
     bool m_applyColors : 1;
     bool m_applyWidgetStyle : 1;
     bool m_applyIcons : 1;
@@ -146,4 +182,6 @@ private:
     bool m_applyWindowDecoration : 1;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KCMLookandFeel::PendingChanges)
+
 #endif
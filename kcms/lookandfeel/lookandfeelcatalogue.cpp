@@ -0,0 +1,234 @@
+/* This file is part of the KDE Project
+   Copyright (c) 2017 The KDE Project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "lookandfeelcatalogue.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <Plasma/Package>
+#include <Plasma/PluginLoader>
+
+// bump whenever the probing below changes, so old caches are thrown away
+static const int s_cacheVersion = 1;
+
+// Everything probing looks at lives in one of these, adding or removing a
+// package file touches at least one of them.
+static QString packageStamp(const QString &path)
+{
+    static const QStringList files = {
+        QString(),
+        QStringLiteral("/metadata.desktop"),
+        QStringLiteral("/metadata.json"),
+        QStringLiteral("/contents"),
+        QStringLiteral("/contents/defaults"),
+        QStringLiteral("/contents/previews")
+    };
+
+    QStringList stamp;
+    for (const QString &file : files) {
+        const QFileInfo info(path + file);
+        stamp << (info.exists() ? QString::number(info.lastModified().toMSecsSinceEpoch()) : QStringLiteral("-"));
+    }
+    return stamp.join(QLatin1Char(':'));
+}
+
+static LookAndFeelCatalogue::Entry probePackage(const QString &path)
+{
+    LookAndFeelCatalogue::Entry entry;
+
+    Plasma::Package pkg = Plasma::PluginLoader::self()->loadPackage(QStringLiteral("Plasma/LookAndFeel"));
+    pkg.setPath(path);
+    pkg.setFallbackPackage(Plasma::Package());
+    if (!pkg.metadata().isValid()) {
+        return entry;
+    }
+
+    entry.pluginName = pkg.metadata().pluginName();
+    entry.name = pkg.metadata().name();
+    entry.path = path;
+    entry.preview = pkg.filePath("preview");
+    entry.fullScreenPreview = pkg.filePath("fullscreenpreview");
+    entry.splashPreview = pkg.filePath("previews", QStringLiteral("splash.png"));
+
+    //What the package provides
+    LookAndFeelCatalogue::Capabilities caps;
+    if (!pkg.filePath("splashmainscript").isEmpty()) {
+        caps |= LookAndFeelCatalogue::HasSplash;
+    }
+    if (!pkg.filePath("lockscreenmainscript").isEmpty()) {
+        caps |= LookAndFeelCatalogue::HasLockScreen;
+    }
+    if (!pkg.filePath("runcommandmainscript").isEmpty()) {
+        caps |= LookAndFeelCatalogue::HasRunCommand;
+    }
+    if (!pkg.filePath("logoutmainscript").isEmpty()) {
+        caps |= LookAndFeelCatalogue::HasLogout;
+    }
+
+    if (!pkg.filePath("defaults").isEmpty()) {
+        KSharedConfigPtr conf = KSharedConfig::openConfig(pkg.filePath("defaults"));
+        KConfigGroup cg(conf, "kdeglobals");
+        cg = KConfigGroup(&cg, "General");
+        bool hasColors = !cg.readEntry("ColorScheme", QString()).isEmpty();
+        if (!hasColors) {
+            hasColors = !pkg.filePath("colors").isEmpty();
+        }
+        if (hasColors) {
+            caps |= LookAndFeelCatalogue::HasColors;
+        }
+        cg = KConfigGroup(&cg, "KDE");
+        if (!cg.readEntry("widgetStyle", QString()).isEmpty()) {
+            caps |= LookAndFeelCatalogue::HasWidgetStyle;
+        }
+        cg = KConfigGroup(conf, "kdeglobals");
+        cg = KConfigGroup(&cg, "Icons");
+        if (!cg.readEntry("Theme", QString()).isEmpty()) {
+            caps |= LookAndFeelCatalogue::HasIcons;
+        }
+
+        cg = KConfigGroup(conf, "kdeglobals");
+        cg = KConfigGroup(&cg, "Theme");
+        if (!cg.readEntry("name", QString()).isEmpty()) {
+            caps |= LookAndFeelCatalogue::HasPlasmaTheme;
+        }
+
+        cg = KConfigGroup(conf, "kcminputrc");
+        cg = KConfigGroup(&cg, "Mouse");
+        if (!cg.readEntry("cursorTheme", QString()).isEmpty()) {
+            caps |= LookAndFeelCatalogue::HasCursors;
+        }
+
+        cg = KConfigGroup(conf, "kwinrc");
+        cg = KConfigGroup(&cg, "WindowSwitcher");
+        if (!cg.readEntry("LayoutName", QString()).isEmpty()) {
+            caps |= LookAndFeelCatalogue::HasWindowSwitcher;
+        }
+
+        cg = KConfigGroup(conf, "kwinrc");
+        cg = KConfigGroup(&cg, "DesktopSwitcher");
+        if (!cg.readEntry("LayoutName", QString()).isEmpty()) {
+            caps |= LookAndFeelCatalogue::HasDesktopSwitcher;
+        }
+    }
+    entry.capabilities = caps;
+
+    return entry;
+}
+
+static void writeEntry(KConfigGroup &cg, const QString &stamp, const LookAndFeelCatalogue::Entry &entry)
+{
+    cg.writeEntry("Stamp", stamp);
+    cg.writeEntry("PluginName", entry.pluginName);
+    cg.writeEntry("Name", entry.name);
+    cg.writeEntry("Preview", entry.preview);
+    cg.writeEntry("FullScreenPreview", entry.fullScreenPreview);
+    cg.writeEntry("SplashPreview", entry.splashPreview);
+    cg.writeEntry("Capabilities", int(entry.capabilities));
+}
+
+static LookAndFeelCatalogue::Entry readEntry(const KConfigGroup &cg, const QString &path)
+{
+    LookAndFeelCatalogue::Entry entry;
+    entry.pluginName = cg.readEntry("PluginName", QString());
+    if (entry.pluginName.isEmpty()) {
+        return entry;
+    }
+    entry.name = cg.readEntry("Name", QString());
+    entry.path = path;
+    entry.preview = cg.readEntry("Preview", QString());
+    entry.fullScreenPreview = cg.readEntry("FullScreenPreview", QString());
+    entry.splashPreview = cg.readEntry("SplashPreview", QString());
+    entry.capabilities = LookAndFeelCatalogue::Capabilities(cg.readEntry("Capabilities", 0));
+    return entry;
+}
+
+QList<LookAndFeelCatalogue::Entry> LookAndFeelCatalogue::packages(Capabilities required)
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    QDir().mkpath(cacheDir);
+    KConfig cache(cacheDir + QStringLiteral("/plasma-lookandfeel-catalogue"), KConfig::SimpleConfig);
+
+    // package names are cached translated, so a language change invalidates them too
+    const QString locale = QLocale::system().name() + QLatin1Char(':') + QString::fromLocal8Bit(qgetenv("LANGUAGE"));
+
+    KConfigGroup general(&cache, "General");
+    if (general.readEntry("Version", 0) != s_cacheVersion || general.readEntry("Locale", QString()) != locale) {
+        for (const QString &group : cache.groupList()) {
+            cache.deleteGroup(group);
+        }
+        general.writeEntry("Version", s_cacheVersion);
+        general.writeEntry("Locale", locale);
+    }
+
+    QList<Entry> result;
+    QSet<QString> seenPaths;
+    QSet<QString> seenPlugins;
+
+    const QStringList dataPaths = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataPath : dataPaths) {
+        const QDir dir(dataPath + "/plasma/look-and-feel");
+        const QStringList names = dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
+
+        for (const QString &name : names) {
+            const QString path = dir.absoluteFilePath(name);
+            seenPaths.insert(path);
+
+            const QString stamp = packageStamp(path);
+            KConfigGroup cg(&cache, path);
+            Entry entry;
+            if (cg.readEntry("Stamp", QString()) == stamp) {
+                entry = readEntry(cg, path);
+            } else {
+                entry = probePackage(path);
+                writeEntry(cg, stamp, entry);
+            }
+
+            // the same package in a directory with a higher priority wins
+            if (entry.pluginName.isEmpty() || seenPlugins.contains(entry.pluginName)) {
+                continue;
+            }
+            seenPlugins.insert(entry.pluginName);
+
+            if ((entry.capabilities & required) == required) {
+                result << entry;
+            }
+        }
+    }
+
+    // forget about removed packages
+    for (const QString &group : cache.groupList()) {
+        if (group != QLatin1String("General") && !seenPaths.contains(group)) {
+            cache.deleteGroup(group);
+        }
+    }
+
+    if (cache.isDirty()) {
+        cache.sync();
+    }
+
+    return result;
+}
@@ -0,0 +1,72 @@
+/* This file is part of the KDE Project
+   Copyright (c) 2017 The KDE Project
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef LOOKANDFEELCATALOGUE_H
+#define LOOKANDFEELCATALOGUE_H
+
+#include <QList>
+#include <QString>
+
+/**
+ * An index of the installed look and feel packages.
+ *
+ * Probing a package means loading it and checking a dozen files plus its
+ * defaults file, so the results are kept in a cache file shared by all the
+ * modules that list look and feel packages. Only packages whose directory
+ * changed since the last listing (e.g. installed or removed through
+ * KNewStuff) are probed again.
+ */
+class LookAndFeelCatalogue
+{
+public:
+    enum Capability {
+        NoCapabilities = 0,
+        HasSplash = 1 << 0,
+        HasLockScreen = 1 << 1,
+        HasRunCommand = 1 << 2,
+        HasLogout = 1 << 3,
+        HasColors = 1 << 4,
+        HasWidgetStyle = 1 << 5,
+        HasIcons = 1 << 6,
+        HasPlasmaTheme = 1 << 7,
+        HasCursors = 1 << 8,
+        HasWindowSwitcher = 1 << 9,
+        HasDesktopSwitcher = 1 << 10
+    };
+    Q_DECLARE_FLAGS(Capabilities, Capability)
+
+    struct Entry {
+        QString pluginName;
+        QString name;
+        QString path;
+        QString preview;
+        QString fullScreenPreview;
+        QString splashPreview;
+        Capabilities capabilities;
+    };
+
+    /**
+     * @return the valid packages that provide all of @p required,
+     * in the order they are found in the data directories
+     */
+    static QList<Entry> packages(Capabilities required = NoCapabilities);
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(LookAndFeelCatalogue::Capabilities)
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "evdevkeyboardmonitor.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+namespace
+{
+/*
+ * A keyboard made up through uinput, so the monitor reads a real event
+ * device that can be plugged in and out at will. It only types keys that
+ * nothing is bound to, as the session gets them too.
+ */
+class VirtualKeyboard
+{
+public:
+    VirtualKeyboard() : m_fd(open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC))
+    {
+        if (m_fd < 0) {
+            return;
+        }
+
+        uinput_user_dev device;
+        memset(&device, 0, sizeof(device));
+        strncpy(device.name, "kcm_touchpad test keyboard", UINPUT_MAX_NAME_SIZE - 1);
+        device.id.bustype = BUS_VIRTUAL;
+
+        bool ok = ioctl(m_fd, UI_SET_EVBIT, EV_KEY) >= 0;
+        for (int key = KEY_ESC; ok && key <= KEY_MICMUTE; key++) {
+            ok = ioctl(m_fd, UI_SET_KEYBIT, key) >= 0;
+        }
+        if (!ok || write(m_fd, &device, sizeof(device)) != sizeof(device) ||
+                ioctl(m_fd, UI_DEV_CREATE) < 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    ~VirtualKeyboard()
+    {
+        unplug();
+    }
+
+    bool isValid() const { return m_fd >= 0; }
+
+    void unplug()
+    {
+        if (m_fd >= 0) {
+            ioctl(m_fd, UI_DEV_DESTROY);
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    void key(quint16 code, bool pressed)
+    {
+        emitEvent(EV_KEY, code, pressed ? 1 : 0);
+        emitEvent(EV_SYN, SYN_REPORT, 0);
+    }
+
+private:
+    void emitEvent(quint16 type, quint16 code, qint32 value)
+    {
+        input_event event;
+        memset(&event, 0, sizeof(event));
+        event.type = type;
+        event.code = code;
+        event.value = value;
+        QCOMPARE(write(m_fd, &event, sizeof(event)), ssize_t(sizeof(event)));
+    }
+
+    int m_fd;
+};
+}
+
+class EvdevKeyboardMonitorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testNoKeyboards();
+    void testTyping();
+    void testHotplug();
+    void testUnplugWhileTyping();
+
+private:
+    EvdevKeyboardMonitor *createMonitor(VirtualKeyboard &keyboard);
+};
+
+EvdevKeyboardMonitor *EvdevKeyboardMonitorTest::createMonitor(VirtualKeyboard &keyboard)
+{
+    if (!keyboard.isValid()) {
+        return nullptr;
+    }
+
+    // udev needs a moment to give us access to the new node
+    EvdevKeyboardMonitor *monitor = nullptr;
+    for (int i = 0; i < 50 && !monitor; i++) {
+        QTest::qWait(100);
+        monitor = EvdevKeyboardMonitor::create(this);
+    }
+    // Other keyboards may have been readable before ours
+    QTest::qWait(500);
+    return monitor;
+}
+
+void EvdevKeyboardMonitorTest::testNoKeyboards()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QVERIFY(!EvdevKeyboardMonitor::create(this, dir.path()));
+}
+
+void EvdevKeyboardMonitorTest::testTyping()
+{
+    VirtualKeyboard keyboard;
+    QScopedPointer<EvdevKeyboardMonitor> monitor(createMonitor(keyboard));
+    if (!monitor) {
+        QSKIP("Needs access to /dev/uinput and the event devices");
+    }
+    QSignalSpy started(monitor.data(), &KeyboardActivitySource::keyboardActivityStarted);
+    QSignalSpy finished(monitor.data(), &KeyboardActivitySource::keyboardActivityFinished);
+
+    keyboard.key(KEY_F24, true);
+    QVERIFY(started.wait(5000));
+    keyboard.key(KEY_F24, false);
+    QVERIFY(finished.wait(5000));
+
+    // Shortcuts are not typing
+    keyboard.key(KEY_LEFTCTRL, true);
+    keyboard.key(KEY_F23, true);
+    keyboard.key(KEY_F23, false);
+    keyboard.key(KEY_LEFTCTRL, false);
+    QVERIFY(!started.wait(500));
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(finished.count(), 1);
+}
+
+void EvdevKeyboardMonitorTest::testHotplug()
+{
+    VirtualKeyboard keyboard;
+    QScopedPointer<EvdevKeyboardMonitor> monitor(createMonitor(keyboard));
+    if (!monitor) {
+        QSKIP("Needs access to /dev/uinput and the event devices");
+    }
+    const int devices = monitor->deviceCount();
+
+    // The unplugged keyboard is closed
+    keyboard.unplug();
+    QTRY_COMPARE_WITH_TIMEOUT(monitor->deviceCount(), devices - 1, 5000);
+
+    // A keyboard plugged in later is read as well
+    VirtualKeyboard other;
+    QVERIFY(other.isValid());
+    QTRY_COMPARE_WITH_TIMEOUT(monitor->deviceCount(), devices, 5000);
+
+    QSignalSpy started(monitor.data(), &KeyboardActivitySource::keyboardActivityStarted);
+    other.key(KEY_F24, true);
+    QVERIFY(started.wait(5000));
+    other.key(KEY_F24, false);
+}
+
+void EvdevKeyboardMonitorTest::testUnplugWhileTyping()
+{
+    VirtualKeyboard keyboard;
+    QScopedPointer<EvdevKeyboardMonitor> monitor(createMonitor(keyboard));
+    if (!monitor) {
+        QSKIP("Needs access to /dev/uinput and the event devices");
+    }
+    QSignalSpy started(monitor.data(), &KeyboardActivitySource::keyboardActivityStarted);
+    QSignalSpy finished(monitor.data(), &KeyboardActivitySource::keyboardActivityFinished);
+
+    keyboard.key(KEY_F24, true);
+    QVERIFY(started.wait(5000));
+
+    // The key never comes up, the touchpad must not stay disabled
+    keyboard.unplug();
+    QVERIFY(finished.count() || finished.wait(5000));
+    QCOMPARE(finished.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(EvdevKeyboardMonitorTest)
+
+#include "evdevkeyboardmonitortest.moc"
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QSignalSpy>
+#include <QtTest>
+
+#include "replaykeyboardsource.h"
+
+#include <algorithm>
+
+namespace
+{
+// Made up key codes, any will do
+const quint32 KeyShift = 50;
+const quint32 KeyCtrl = 37;
+const quint32 KeyA = 38;
+const quint32 KeyS = 39;
+const quint32 KeyD = 40;
+
+/*
+ * Does what the touchpad daemon does with the activity signals, and
+ * counts how often the touchpad property would really be written.
+ */
+class Disabler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Disabler(KeyboardActivitySource *source)
+        : m_off(false), writes(0)
+    {
+        connect(source, &KeyboardActivitySource::keyboardActivityStarted,
+                this, [this]() { setOff(true); });
+        connect(source, &KeyboardActivitySource::keyboardActivityFinished,
+                this, [this]() { setOff(false); });
+    }
+
+    void setOff(bool off)
+    {
+        // The backend skips writes that would not change anything
+        if (m_off == off) {
+            return;
+        }
+        m_off = off;
+        writes++;
+    }
+
+    bool m_off;
+    int writes;
+};
+}
+
+class KeyboardActivityTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testKeystroke();
+    void testShiftIsIgnored();
+    void testShortcutIsNotTyping();
+    void testBatchedKeystroke();
+    void testTimedReplay();
+    void benchmarkActivityDetection();
+
+private:
+    static QVector<ReplayKeyboardSource::TimedKeyEvent> typing(int keystrokes, int interval);
+};
+
+QVector<ReplayKeyboardSource::TimedKeyEvent> KeyboardActivityTest::typing(int keystrokes, int interval)
+{
+    // Keys overlap like in fast typing: the next key goes down
+    // before the previous one is released
+    static const quint32 keys[] = { KeyA, KeyS, KeyD };
+    QVector<ReplayKeyboardSource::TimedKeyEvent> events;
+    for (int i = 0; i < keystrokes; i++) {
+        const quint32 key = keys[i % 3];
+        events.append({ i * interval, key, true });
+        events.append({ i * interval + interval + interval / 2, key, false });
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const ReplayKeyboardSource::TimedKeyEvent &a,
+                        const ReplayKeyboardSource::TimedKeyEvent &b) {
+                         return a.msec < b.msec;
+                     });
+    return events;
+}
+
+void KeyboardActivityTest::testKeystroke()
+{
+    ReplayKeyboardSource source;
+    source.setModifiers({ KeyShift, KeyCtrl }, { KeyShift });
+    QSignalSpy started(&source, &KeyboardActivitySource::keyboardActivityStarted);
+    QSignalSpy finished(&source, &KeyboardActivitySource::keyboardActivityFinished);
+
+    source.feed(KeyA, true);
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(finished.count(), 0);
+
+    // Autorepeat or a second press changes nothing
+    source.feed(KeyA, true);
+    QCOMPARE(started.count(), 1);
+
+    source.feed(KeyA, false);
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(finished.count(), 1);
+}
+
+void KeyboardActivityTest::testShiftIsIgnored()
+{
+    ReplayKeyboardSource source;
+    source.setModifiers({ KeyShift, KeyCtrl }, { KeyShift });
+    QSignalSpy started(&source, &KeyboardActivitySource::keyboardActivityStarted);
+
+    source.feed(KeyShift, true);
+    QCOMPARE(started.count(), 0);
+    source.feed(KeyA, true);
+    QCOMPARE(started.count(), 1);
+}
+
+void KeyboardActivityTest::testShortcutIsNotTyping()
+{
+    ReplayKeyboardSource source;
+    source.setModifiers({ KeyShift, KeyCtrl }, { KeyShift });
+    QSignalSpy started(&source, &KeyboardActivitySource::keyboardActivityStarted);
+    QSignalSpy finished(&source, &KeyboardActivitySource::keyboardActivityFinished);
+
+    source.feed(KeyCtrl, true);
+    source.feed(KeyA, true);
+    source.feed(KeyA, false);
+    source.feed(KeyCtrl, false);
+
+    QCOMPARE(started.count(), 0);
+    QCOMPARE(finished.count(), 0);
+}
+
+void KeyboardActivityTest::testBatchedKeystroke()
+{
+    ReplayKeyboardSource source;
+    QSignalSpy started(&source, &KeyboardActivitySource::keyboardActivityStarted);
+    QSignalSpy finished(&source, &KeyboardActivitySource::keyboardActivityFinished);
+    QSignalSpy done(&source, &ReplayKeyboardSource::replayFinished);
+
+    // Press and release delivered together
+    source.replay({ { 0, KeyA, true }, { 0, KeyA, false } });
+    QVERIFY(done.count() || done.wait(5000));
+
+    QCOMPARE(started.count(), 1);
+    QCOMPARE(finished.count(), 1);
+}
+
+void KeyboardActivityTest::testTimedReplay()
+{
+    ReplayKeyboardSource source;
+    Disabler disabler(&source);
+    QSignalSpy done(&source, &ReplayKeyboardSource::replayFinished);
+
+    source.replay(typing(20, 5));
+    QVERIFY(done.count() || done.wait(5000));
+
+    // One continuous burst of typing: disabled once, enabled once
+    QCOMPARE(disabler.writes, 2);
+    QVERIFY(!disabler.m_off);
+}
+
+/*
+ * How long telling typing from key events takes for sustained typing.
+ * The backends feed their key events through the same code; what they
+ * do with the signals is only stood in for by the Disabler.
+ */
+void KeyboardActivityTest::benchmarkActivityDetection()
+{
+    const QVector<ReplayKeyboardSource::TimedKeyEvent> events = typing(10000, 1);
+
+    QBENCHMARK {
+        ReplayKeyboardSource source;
+        Disabler disabler(&source);
+
+        for (const ReplayKeyboardSource::TimedKeyEvent &e : events) {
+            source.feed(e.key, e.pressed);
+        }
+
+        QCOMPARE(disabler.writes, 2);
+    }
+}
+
+QTEST_GUILESS_MAIN(KeyboardActivityTest)
+
+#include "keyboardactivitytest.moc"
@@ -1,7 +1,7 @@
 # // krazy:excludeall=copyright,license
 find_package(X11 REQUIRED)
 find_package(X11_XCB REQUIRED)
-find_package(XCB REQUIRED)
+find_package(XCB REQUIRED COMPONENTS XCB XINPUT)
 find_package(PkgConfig REQUIRED)
 
 if(NOT X11_Xinput_FOUND)
@@ -30,6 +30,15 @@ SET(backend_SRCS
     backends/x11/xrecordkeyboardmonitor.cpp
 )
 
+check_include_files(linux/input.h HAVE_LINUX_INPUT_H)
+if(HAVE_LINUX_INPUT_H)
+    add_definitions(-DHAVE_EVDEV)
+    SET(backend_SRCS
+        ${backend_SRCS}
+        backends/x11/evdevkeyboardmonitor.cpp
+    )
+endif()
+
 SET(backend_LIBS
     ${backend_LIBS}
     ${XCB_LIBRARIES}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "evdevkeyboardmonitor.h"
+
+#include <cerrno>
+
+#include <QDir>
+#include <QFile>
+#include <QScopedPointer>
+#include <QSocketNotifier>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#include "logging.h"
+
+namespace
+{
+
+bool testBit(const unsigned long *bits, int bit)
+{
+    const int bitsPerLong = sizeof(unsigned long) * 8;
+    return (bits[bit / bitsPerLong] >> (bit % bitsPerLong)) & 1;
+}
+
+bool isKeyboard(int fd)
+{
+    const int bitsPerLong = sizeof(unsigned long) * 8;
+    unsigned long evBits[EV_MAX / bitsPerLong + 1] = {};
+    unsigned long keyBits[KEY_MAX / bitsPerLong + 1] = {};
+
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), evBits) < 0 ||
+            !testBit(evBits, EV_KEY))
+    {
+        return false;
+    }
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) < 0) {
+        return false;
+    }
+
+    // Power buttons and the like have EV_KEY too
+    return testBit(keyBits, KEY_A) && testBit(keyBits, KEY_Z) &&
+            testBit(keyBits, KEY_SPACE);
+}
+
+}
+
+EvdevKeyboardMonitor *EvdevKeyboardMonitor::create(QObject *parent,
+                                                   const QString &directory)
+{
+    QScopedPointer<EvdevKeyboardMonitor> monitor(
+            new EvdevKeyboardMonitor(directory, nullptr));
+
+    if (!monitor->deviceCount()) {
+        qCDebug(KCM_TOUCHPAD) << "No readable keyboard event devices";
+        return nullptr;
+    }
+
+    monitor->setParent(parent);
+    return monitor.take();
+}
+
+EvdevKeyboardMonitor::EvdevKeyboardMonitor(const QString &directory,
+                                           QObject *parent)
+    : KeyboardActivitySource(parent), m_directory(directory), m_inotifyFd(-1)
+{
+    setModifierKeys({ KEY_LEFTSHIFT, KEY_RIGHTSHIFT, KEY_CAPSLOCK,
+                      KEY_LEFTCTRL, KEY_RIGHTCTRL, KEY_LEFTALT, KEY_RIGHTALT,
+                      KEY_LEFTMETA, KEY_RIGHTMETA, KEY_NUMLOCK },
+                    { KEY_LEFTSHIFT, KEY_RIGHTSHIFT });
+
+    // Watch before scanning so that no keyboard falls in between. Nodes
+    // are created by the kernel before udev gives the user access to
+    // them, so changed attributes are what really tell they can be read.
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0 &&
+            inotify_add_watch(m_inotifyFd, QFile::encodeName(directory).constData(),
+                              IN_CREATE | IN_ATTRIB | IN_DELETE) < 0)
+    {
+        close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+    if (m_inotifyFd >= 0) {
+        QSocketNotifier *notifier =
+                new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+        connect(notifier, SIGNAL(activated(int)), SLOT(readDirectoryChanges()));
+    } else {
+        qCWarning(KCM_TOUCHPAD) << "Can't watch" << directory
+                                << "for new keyboards";
+    }
+
+    scanDevices();
+}
+
+EvdevKeyboardMonitor::~EvdevKeyboardMonitor()
+{
+    Q_FOREACH (QSocketNotifier *notifier, m_devices) {
+        const int fd = notifier->socket();
+        delete notifier;
+        close(fd);
+    }
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+    }
+}
+
+void EvdevKeyboardMonitor::scanDevices()
+{
+    const QStringList names =
+            QDir(m_directory).entryList(QStringList(QStringLiteral("event*")),
+                                        QDir::System);
+
+    Q_FOREACH (const QString &name, m_devices.keys()) {
+        if (!names.contains(name)) {
+            removeDevice(name);
+        }
+    }
+    Q_FOREACH (const QString &name, names) {
+        addDevice(name);
+    }
+}
+
+bool EvdevKeyboardMonitor::addDevice(const QString &name)
+{
+    if (m_devices.contains(name)) {
+        return true;
+    }
+
+    const QByteArray path = QFile::encodeName(QDir(m_directory).filePath(name));
+    int fd = open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    if (!isKeyboard(fd)) {
+        close(fd);
+        return false;
+    }
+
+    QSocketNotifier *notifier =
+            new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), SLOT(readEvents(int)));
+    m_devices.insert(name, notifier);
+    return true;
+}
+
+void EvdevKeyboardMonitor::removeDevice(const QString &name)
+{
+    QSocketNotifier *notifier = m_devices.take(name);
+    if (!notifier) {
+        return;
+    }
+
+    // May be called from the notifier's own signal
+    const int fd = notifier->socket();
+    notifier->setEnabled(false);
+    close(fd);
+    notifier->deleteLater();
+
+    // An unplugged keyboard never tells that its keys went up, so let go
+    // of those not also held on another keyboard
+    const QSet<quint32> keysPressed = m_keysPressed.take(fd);
+    QVector<KeyEvent> keyEvents;
+    Q_FOREACH (quint32 key, keysPressed) {
+        bool heldElsewhere = false;
+        Q_FOREACH (const QSet<quint32> &keys, m_keysPressed) {
+            if (keys.contains(key)) {
+                heldElsewhere = true;
+                break;
+            }
+        }
+        if (!heldElsewhere) {
+            keyEvents.append({ key, false });
+        }
+    }
+    processKeyEvents(keyEvents.constData(), keyEvents.size());
+
+    // Only now, so that what it still sent comes before its keys go up
+    if (unplugged) {
+        Q_FOREACH (QSocketNotifier *notifier, m_devices) {
+            if (notifier->socket() == fd) {
+                removeDevice(m_devices.key(notifier));
+                break;
+            }
+        }
+    }
+}
+
+void EvdevKeyboardMonitor::readDirectoryChanges()
+{
+    char buffer[4096]
+            __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        ssize_t n = read(m_inotifyFd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+
+        for (char *p = buffer; p < buffer + n;
+             p += sizeof(inotify_event) + reinterpret_cast<inotify_event *>(p)->len)
+        {
+            const inotify_event *event = reinterpret_cast<inotify_event *>(p);
+            if (event->mask & IN_Q_OVERFLOW) {
+                scanDevices();
+                continue;
+            }
+
+            const QString name = QFile::decodeName(event->name);
+            if (!event->len || !name.startsWith(QLatin1String("event"))) {
+                continue;
+            }
+            if (event->mask & IN_DELETE) {
+                removeDevice(name);
+            } else {
+                addDevice(name);
+            }
+        }
+    }
+}
+
+void EvdevKeyboardMonitor::readEvents(int fd)
+{
+    input_event events[64];
+    QVector<KeyEvent> keyEvents;
+    QSet<quint32> &keysPressed = m_keysPressed[fd];
+    bool unplugged = false;
+
+    for (;;) {
+        ssize_t n = read(fd, events, sizeof(events));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Keyboard unplugged, the node may still linger for a while
+            unplugged = errno != EAGAIN;
+            break;
+        }
+
+        const int count = n / sizeof(input_event);
+        for (int i = 0; i < count; i++) {
+            // value 2 is autorepeat, which changes nothing. Buttons of
+            // pointing devices built into the keyboard are not typing.
+            if (events[i].type == EV_KEY && events[i].value != 2 &&
+                    (events[i].code < BTN_MISC || events[i].code >= KEY_OK))
+            {
+                keyEvents.append({ events[i].code, events[i].value == 1 });
+                if (events[i].value == 1) {
+                    keysPressed.insert(events[i].code);
+                } else {
+                    keysPressed.remove(events[i].code);
+                }
+            }
+        }
+
+        if (count < int(sizeof(events) / sizeof(input_event))) {
+            break;
+        }
+    }
+
+    processKeyEvents(keyEvents.constData(), keyEvents.size());
+}
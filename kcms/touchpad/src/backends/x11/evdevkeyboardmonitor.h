@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef EVDEVKEYBOARDMONITOR_H
+#define EVDEVKEYBOARDMONITOR_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+#include "keyboardactivitysource.h"
+
+class QSocketNotifier;
+
+/*
+ * Reads key events straight from the keyboards' evdev nodes, so the X
+ * server does not have to copy every key event to us like with RECORD.
+ * Only works when the user may read the event devices. Keyboards plugged
+ * in later are picked up by watching the device directory with inotify.
+ */
+class EvdevKeyboardMonitor : public KeyboardActivitySource
+{
+    Q_OBJECT
+
+public:
+    // Returns nullptr if no keyboard can be read
+    static EvdevKeyboardMonitor *create(QObject *parent = nullptr,
+            const QString &directory = QStringLiteral("/dev/input"));
+    ~EvdevKeyboardMonitor();
+
+    // Number of keyboards currently being read
+    int deviceCount() const { return m_devices.size(); }
+
+private Q_SLOTS:
+    void readEvents(int fd);
+    void readDirectoryChanges();
+
+private:
+    EvdevKeyboardMonitor(const QString &directory, QObject *parent);
+
+    void scanDevices();
+    bool addDevice(const QString &name);
+    void removeDevice(const QString &name);
+
+    QString m_directory;
+    int m_inotifyFd;
+    QHash<QString, QSocketNotifier *> m_devices;
+    // Keys held down on each keyboard, by file descriptor
+    QHash<int, QSet<quint32> > m_keysPressed;
+};
+
+#endif // EVDEVKEYBOARDMONITOR_H
@@ -36,26 +36,19 @@ const struct Parameter libinputProperties[] = {
 
 LibinputTouchpad::LibinputTouchpad(Display *display, int deviceId): XlibTouchpad(display, deviceId)
 {
-    loadSupportedProperties(libinputProperties);
-
     /* FIXME: has a different format than Synaptics Off but we don't expose
        the toggle so this is just to stop it from crashing when we check
        m_touchpadOffAtom  */
-    m_touchpadOffAtom.intern(m_connection,
-                             "libinput Send Events Mode enabled");
+    setTouchpadOffProperty("libinput Send Events Mode enabled");
+    addProperty("libinput Scroll Methods Available");
 
+    loadSupportedProperties(libinputProperties);
 
-    XcbAtom scroll_methods(m_connection,
-                           "libinput Scroll Methods Available",
-                           true);
-    if (scroll_methods.atom() != 0) {
-        PropertyInfo methods(m_display,
-                             m_deviceId,
-                             scroll_methods.atom(),
-                             0);
-        if (!methods.value(0).toInt())
+    PropertyInfo *methods = getDevProperty(QLatin1String("libinput Scroll Methods Available"));
+    if (methods) {
+        if (!methods->value(0).toInt())
             m_supported.removeAll("VertTwoFingerScroll");
-        else if (!methods.value(1).toInt())
+        else if (!methods->value(1).toInt())
             m_supported.removeAll("VertEdgeScroll");
     }
 }
@@ -18,11 +18,17 @@
 
 #include "propertyinfo.h"
 
+#include <cstdlib>
+#include <cstring>
+
+#include <QScopedPointer>
 #include <QVariant>
 
 #include <X11/Xlib.h>
+#include <X11/Xlib-xcb.h>
 #include <X11/Xatom.h>
 #include <X11/extensions/XInput2.h>
+#include <xcb/xinput.h>
 
 void XDeleter(void* p)
 {
@@ -46,7 +52,12 @@ PropertyInfo::PropertyInfo(Display *display, int device, Atom prop, Atom floatTy
     XIGetProperty(display, device, prop, 0, 1000, False,
                     AnyPropertyType, &type, &format, &nitems,
                     &bytes_after, &dataPtr);
-    data = QSharedPointer<unsigned char>(dataPtr, XDeleter);
+    setData(dataPtr, XDeleter, floatType);
+}
+
+void PropertyInfo::setData(unsigned char *dataPtr, void (*deleter)(void *), Atom floatType)
+{
+    data = QSharedPointer<unsigned char>(dataPtr, deleter);
 
     if (format == CHAR_BIT && type == XA_INTEGER) {
         b = reinterpret_cast<char *>(dataPtr);
@@ -88,3 +99,45 @@ void PropertyInfo::set()
     XIChangeProperty(display, device, prop, type, format,
                         XIPropModeReplace, data.data(), nitems);
 }
+
+QVector<PropertyInfo> PropertyInfo::fetch(Display *display,
+                                          const QVector<PropertyRequest> &requests,
+                                          Atom floatType)
+{
+    xcb_connection_t *connection = XGetXCBConnection(display);
+
+    QVector<xcb_input_xi_get_property_cookie_t> cookies;
+    cookies.reserve(requests.size());
+    Q_FOREACH(const PropertyRequest &request, requests) {
+        cookies.append(xcb_input_xi_get_property(connection, request.device, 0,
+                                                 request.prop,
+                                                 XCB_GET_PROPERTY_TYPE_ANY,
+                                                 0, 1000));
+    }
+
+    QVector<PropertyInfo> result;
+    result.reserve(requests.size());
+    for (int n = 0; n < requests.size(); n++) {
+        PropertyInfo p;
+        p.display = display;
+        p.device = requests[n].device;
+        p.prop = requests[n].prop;
+
+        QScopedPointer<xcb_input_xi_get_property_reply_t, QScopedPointerPodDeleter>
+                reply(xcb_input_xi_get_property_reply(connection, cookies[n], 0));
+        if (reply && reply->type != XCB_NONE) {
+            p.type = reply->type;
+            p.format = reply->format;
+            p.nitems = reply->num_items;
+
+            const size_t size = p.nitems * (p.format / CHAR_BIT);
+            unsigned char *dataPtr = static_cast<unsigned char *>(std::malloc(qMax<size_t>(size, 1)));
+            std::memcpy(dataPtr, xcb_input_xi_get_property_items(reply.data()), size);
+            p.setData(dataPtr, std::free, floatType);
+        }
+
+        result.append(p);
+    }
+
+    return result;
+}
@@ -20,11 +20,18 @@
 #define PROPERTYINFO_H
 
 #include <QSharedPointer>
+#include <QVector>
 #include <QX11Info>
 #include <X11/Xdefs.h>
 
 void XDeleter(void *p);
 
+struct PropertyRequest
+{
+    int device;
+    Atom prop;
+};
+
 struct PropertyInfo
 {
     Atom type;
@@ -45,6 +52,18 @@ struct PropertyInfo
     QVariant value(unsigned offset) const;
 
     void set();
+
+    /*
+     * Sends all requests before waiting for the first reply, so fetching
+     * any number of properties costs a single round trip.
+     * Missing properties come back without data.
+     */
+    static QVector<PropertyInfo> fetch(Display *display,
+                                       const QVector<PropertyRequest> &requests,
+                                       Atom floatType);
+
+private:
+    void setData(unsigned char *dataPtr, void (*deleter)(void *), Atom floatType);
 };
 
 #endif // PROPERTYINFO_H
@@ -131,32 +131,33 @@ const struct Parameter synapticsProperties[] = {
 SynapticsTouchpad::SynapticsTouchpad(Display *display, int deviceId): XlibTouchpad(display, deviceId),
     m_resX(1), m_resY(1)
 {
-    m_capsAtom.intern(m_connection, SYNAPTICS_PROP_CAPABILITIES);
-    m_touchpadOffAtom.intern(m_connection, SYNAPTICS_PROP_OFF);
-    XcbAtom resolutionAtom(m_connection, SYNAPTICS_PROP_RESOLUTION);
-    XcbAtom edgesAtom(m_connection, SYNAPTICS_PROP_EDGES);
+    setTouchpadOffProperty(SYNAPTICS_PROP_OFF);
+    // Fetched together with the parameters below
+    addProperty(SYNAPTICS_PROP_CAPABILITIES);
+    addProperty(SYNAPTICS_PROP_RESOLUTION);
+    addProperty(SYNAPTICS_PROP_EDGES);
 
     loadSupportedProperties(synapticsProperties);
 
     m_toRadians.append("CircScrollDelta");
 
-    PropertyInfo edges(m_display, m_deviceId, edgesAtom, 0);
-    if (edges.i && edges.nitems == 4) {
-        int w = qAbs(edges.i[1] - edges.i[0]);
-        int h = qAbs(edges.i[3] - edges.i[2]);
+    PropertyInfo *edges = getDevProperty(QLatin1String(SYNAPTICS_PROP_EDGES));
+    if (edges && edges->i && edges->nitems == 4) {
+        int w = qAbs(edges->i[1] - edges->i[0]);
+        int h = qAbs(edges->i[3] - edges->i[2]);
         m_resX = w / 90;
         m_resY = h / 50;
         qDebug() << "Width: " << w << " height: " << h;
         qDebug() << "Approx. resX: " << m_resX << " resY: " << m_resY;
     }
 
-    PropertyInfo resolution(m_display, m_deviceId, resolutionAtom, 0);
-    if (resolution.i && resolution.nitems == 2 &&
-        resolution.i[0] > 1 && resolution.i[1] > 1)
+    PropertyInfo *resolution = getDevProperty(QLatin1String(SYNAPTICS_PROP_RESOLUTION));
+    if (resolution && resolution->i && resolution->nitems == 2 &&
+        resolution->i[0] > 1 && resolution->i[1] > 1)
     {
-        m_resY = qMin(static_cast<unsigned long>(resolution.i[0]),
+        m_resY = qMin(static_cast<unsigned long>(resolution->i[0]),
                 static_cast<unsigned long>(INT_MAX));
-        m_resX = qMin(static_cast<unsigned long>(resolution.i[1]),
+        m_resX = qMin(static_cast<unsigned long>(resolution->i[1]),
                 static_cast<unsigned long>(INT_MAX));
         qDebug() << "Touchpad resolution: x: " << m_resX << " y: " << m_resY;
     }
@@ -174,8 +175,8 @@ SynapticsTouchpad::SynapticsTouchpad(Display *display, int deviceId): XlibTouchp
     m_supported.append(m_negate.values());
     m_supported.append("Coasting");
 
-    PropertyInfo caps(m_display, m_deviceId, m_capsAtom.atom(), 0);
-    if (!caps.b) {
+    PropertyInfo *caps = getDevProperty(QLatin1String(SYNAPTICS_PROP_CAPABILITIES));
+    if (!caps || !caps->b) {
         return;
     }
 
@@ -192,7 +193,7 @@ SynapticsTouchpad::SynapticsTouchpad(Display *display, int deviceId): XlibTouchp
     };
 
     QVector<bool> cap(TouchpadCapsCount, false);
-    qCopy(caps.b, caps.b + qMin(cap.size(), static_cast<int>(caps.nitems)),
+    qCopy(caps->b, caps->b + qMin(cap.size(), static_cast<int>(caps->nitems)),
           cap.begin());
 
     if (!cap[TouchpadTwoFingerDetect]) {
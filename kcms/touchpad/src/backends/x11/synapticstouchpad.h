@@ -31,7 +31,6 @@ protected:
     double getPropertyScale(const QString &name) const Q_DECL_OVERRIDE;
 
 private:
-    XcbAtom m_capsAtom;
     int m_resX, m_resY;
     QStringList m_scaleByResX, m_scaleByResY, m_toRadians;
 };
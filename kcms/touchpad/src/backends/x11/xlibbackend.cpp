@@ -27,6 +27,9 @@
 
 //Includes are ordered this way because of #defines in Xorg's headers
 #include "xrecordkeyboardmonitor.h" // krazy:exclude=includes
+#ifdef HAVE_EVDEV
+#include "evdevkeyboardmonitor.h" // krazy:exclude=includes
+#endif
 #include "xlibbackend.h" // krazy:exclude=includes
 #include "xlibnotifications.h" // krazy:exclude=includes
 #include "libinputtouchpad.h"
@@ -74,7 +77,8 @@ XlibBackend::~XlibBackend()
 
 XlibBackend::XlibBackend(QObject *parent) :
     TouchpadBackend(parent),
-    m_display(XOpenDisplay(0)), m_connection(0)
+    m_display(XOpenDisplay(0)), m_connection(0), m_touchpadOff(-1),
+    m_mousesValid(false)
 {
     if (m_display) {
         m_connection = XGetXCBConnection(m_display.data());
@@ -188,7 +192,12 @@ void XlibBackend::setTouchpadOff(TouchpadBackend::TouchpadOffState state)
         return;
     }
 
+    if (touchpadOff == m_touchpadOff) {
+        return;
+    }
+
     m_device->setTouchpadOff(touchpadOff);
+    m_touchpadOff = touchpadOff;
 }
 
 bool XlibBackend::isTouchpadAvailable()
@@ -210,7 +219,10 @@ TouchpadBackend::TouchpadOffState XlibBackend::getTouchpadOff()
     if (!m_device) {
         return TouchpadFullyDisabled;
     }
-    int value = m_device->touchpadOff();
+    if (m_touchpadOff < 0) {
+        m_touchpadOff = m_device->touchpadOff();
+    }
+    int value = m_touchpadOff;
     switch (value) {
     case 0:
         return TouchpadEnabled;
@@ -228,13 +240,18 @@ void XlibBackend::touchpadDetached()
 {
     qWarning() << "Touchpad detached";
     m_device.reset();
+    m_touchpadOff = -1;
+    m_mousesValid = false;
     Q_EMIT touchpadReset();
 }
 
 void XlibBackend::devicePlugged(int device)
 {
+    m_mousesValid = false;
+
     if (!m_device) {
         m_device.reset(findTouchpad());
+        m_touchpadOff = -1;
         if (m_device) {
             qWarning() << "Touchpad reset";
             m_notifications.reset();
@@ -249,6 +266,15 @@ void XlibBackend::devicePlugged(int device)
 
 void XlibBackend::propertyChanged(xcb_atom_t prop)
 {
+    if (m_device) {
+        m_device->propertyChanged(prop);
+    }
+
+    if (m_device && prop == m_device->touchpadOffAtom().atom()) {
+        // Might have been changed by someone else, read it again when needed
+        m_touchpadOff = -1;
+    }
+
     if ((m_device && prop == m_device->touchpadOffAtom().atom()) ||
             prop == m_enabledAtom.atom())
     {
@@ -257,11 +283,30 @@ void XlibBackend::propertyChanged(xcb_atom_t prop)
 }
 
 QStringList XlibBackend::listMouses(const QStringList &blacklist)
+{
+    if (!m_mousesValid) {
+        m_mouses = enabledMouses();
+        // Without notifications we would not know when to list them again
+        m_mousesValid = !m_notifications.isNull();
+    }
+
+    QStringList list;
+    Q_FOREACH (const QString &name, m_mouses) {
+        if (!blacklist.contains(name, Qt::CaseInsensitive)) {
+            list.append(name);
+        }
+    }
+
+    return list;
+}
+
+QStringList XlibBackend::enabledMouses()
 {
     int nDevices = 0;
     QScopedPointer<XDeviceInfo, DeviceListDeleter>
             info(XListInputDevices(m_display.data(), &nDevices));
-    QStringList list;
+    QStringList names;
+    QVector<PropertyRequest> requests;
     for (XDeviceInfo *i = info.data(); i != info.data() + nDevices; i++) {
         if (m_device && i->id == static_cast<XID>(m_device->deviceId())) {
             continue;
@@ -274,15 +319,19 @@ QStringList XlibBackend::listMouses(const QStringList &blacklist)
         if (i->type != m_mouseAtom.atom() && i->type != m_keyboardAtom.atom()) {
             continue;
         }
-        QString name(i->name);
-        if (blacklist.contains(name, Qt::CaseInsensitive)) {
-            continue;
-        }
-        PropertyInfo enabled(m_display.data(), i->id, m_enabledAtom.atom(), 0);
-        if (enabled.value(0) == false) {
+        names.append(QString(i->name));
+        requests.append({ static_cast<int>(i->id), m_enabledAtom.atom() });
+    }
+
+    const QVector<PropertyInfo> enabled =
+            PropertyInfo::fetch(m_display.data(), requests, 0);
+
+    QStringList list;
+    for (int n = 0; n < names.size(); n++) {
+        if (enabled[n].value(0) == false) {
             continue;
         }
-        list.append(name);
+        list.append(names[n]);
     }
 
     return list;
@@ -298,6 +347,10 @@ void XlibBackend::watchForEvents(bool keyboard)
                 SLOT(touchpadDetached()));
         connect(m_notifications.data(), SIGNAL(propertyChanged(xcb_atom_t)),
                 SLOT(propertyChanged(xcb_atom_t)));
+
+        if (m_device) {
+            m_device->setWatched(true);
+        }
     }
 
     if (keyboard == !m_keyboard.isNull()) {
@@ -309,7 +362,15 @@ void XlibBackend::watchForEvents(bool keyboard)
         return;
     }
 
-    m_keyboard.reset(new XRecordKeyboardMonitor(m_display.data()));
+    KeyboardActivitySource *source = nullptr;
+#ifdef HAVE_EVDEV
+    source = EvdevKeyboardMonitor::create();
+#endif
+    if (!source) {
+        source = new XRecordKeyboardMonitor(m_display.data());
+    }
+
+    m_keyboard.reset(source);
     connect(m_keyboard.data(), SIGNAL(keyboardActivityStarted()),
             SIGNAL(keyboardActivityStarted()));
     connect(m_keyboard.data(), SIGNAL(keyboardActivityFinished()),
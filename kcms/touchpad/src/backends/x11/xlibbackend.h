@@ -37,7 +37,7 @@
 
 class XlibTouchpad;
 class XlibNotifications;
-class XRecordKeyboardMonitor;
+class KeyboardActivitySource;
 
 class XlibBackend : public TouchpadBackend
 {
@@ -86,11 +86,21 @@ protected:
     XcbAtom m_libinputIdentifierAtom;
 
     XlibTouchpad *findTouchpad();
+    QStringList enabledMouses();
     QScopedPointer<XlibTouchpad> m_device;
 
     QString m_errorString;
     QScopedPointer<XlibNotifications> m_notifications;
-    QScopedPointer<XRecordKeyboardMonitor> m_keyboard;
+    QScopedPointer<KeyboardActivitySource> m_keyboard;
+
+    // Last known value of the device's touchpad off property, -1 if unknown.
+    // Keyboard activity toggles it a lot, and most toggles are no-ops.
+    int m_touchpadOff;
+
+    // Names of the enabled mice, kept while hotplug events tell us
+    // when it goes stale
+    QStringList m_mouses;
+    bool m_mousesValid;
 };
 
 #endif // XLIBBACKEND_H
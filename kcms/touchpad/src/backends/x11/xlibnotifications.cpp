@@ -135,11 +135,16 @@ void XlibNotifications::processEvent(XEvent *event)
                     return;
                 }
             }
-            if (hierarchyEvent->info[i].use != XISlavePointer) {
+            // Keyboard type devices can be listed as mice too, and
+            // floating ones may be attached later, so any slave counts
+            if (hierarchyEvent->info[i].use == XIMasterPointer ||
+                    hierarchyEvent->info[i].use == XIMasterKeyboard)
+            {
                 continue;
             }
             if (hierarchyEvent->info[i].flags &
-                    (XIDeviceEnabled | XIDeviceDisabled))
+                    (XISlaveAdded | XISlaveRemoved | XISlaveAttached |
+                     XISlaveDetached | XIDeviceEnabled | XIDeviceDisabled))
             {
                 Q_EMIT devicePlugged(hierarchyEvent->info[i].deviceid);
             }
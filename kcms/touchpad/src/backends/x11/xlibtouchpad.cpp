@@ -19,15 +19,22 @@ static QVariant negateVariant(const QVariant &value)
 XlibTouchpad::XlibTouchpad(Display *display, int deviceId) :
     m_display(display),
     m_connection(XGetXCBConnection(display)),
-    m_deviceId(deviceId)
+    m_deviceId(deviceId),
+    m_paramList(0),
+    m_touchpadOffName(0),
+    m_watched(false)
 {
     m_floatType.intern(m_connection, "FLOAT");
     m_enabledAtom.intern(m_connection, XI_PROP_ENABLED);
+    addProperty(XI_PROP_ENABLED);
 }
 
 bool XlibTouchpad::applyConfig(const QVariantHash& p)
 {
-    m_props.clear();
+    if (!m_watched) {
+        m_props.clear();
+    }
+    fetchProperties();
 
     bool error = false;
     Q_FOREACH(const QString &name, m_supported) {
@@ -82,7 +89,10 @@ bool XlibTouchpad::getConfig(QVariantHash& p)
         return false;
     }
 
-    m_props.clear();
+    if (!m_watched) {
+        m_props.clear();
+    }
+    fetchProperties();
 
     bool error = false;
     Q_FOREACH(const QString &name, m_supported) {
@@ -129,18 +139,76 @@ bool XlibTouchpad::getConfig(QVariantHash& p)
     return !error;
 }
 
+void XlibTouchpad::addProperty(const char *name)
+{
+    QLatin1String propName(name);
+
+    if (!m_atoms.contains(propName)) {
+        m_atoms.insert(propName, QSharedPointer<XcbAtom>(
+                        new XcbAtom(m_connection, name)));
+    }
+}
+
+void XlibTouchpad::setTouchpadOffProperty(const char *name)
+{
+    m_touchpadOffAtom.intern(m_connection, name);
+    m_touchpadOffName = QLatin1String(name);
+    addProperty(name);
+}
+
+void XlibTouchpad::fetchProperties()
+{
+    QList<QLatin1String> names;
+    QVector<PropertyRequest> requests;
+
+    for (QMap<QLatin1String, QSharedPointer<XcbAtom> >::ConstIterator i = m_atoms.constBegin();
+         i != m_atoms.constEnd(); ++i)
+    {
+        if (m_props.contains(i.key()) || !i.value()) {
+            continue;
+        }
+
+        xcb_atom_t prop = i.value()->atom();
+        if (!prop) {
+            continue;
+        }
+
+        names.append(i.key());
+        requests.append({ m_deviceId, prop });
+    }
+
+    if (requests.isEmpty()) {
+        return;
+    }
+
+    const QVector<PropertyInfo> props =
+            PropertyInfo::fetch(m_display, requests, m_floatType.atom());
+    for (int n = 0; n < props.size(); n++) {
+        m_props.insert(names[n], props[n]);
+    }
+}
+
+void XlibTouchpad::propertyChanged(xcb_atom_t prop)
+{
+    for (QMap<QLatin1String, QSharedPointer<XcbAtom> >::ConstIterator i = m_atoms.constBegin();
+         i != m_atoms.constEnd(); ++i)
+    {
+        // Values we are about to write win over what is on the server
+        if (i.value() && i.value()->atom() == prop && !m_changed.contains(i.key())) {
+            m_props.remove(i.key());
+        }
+    }
+}
+
 void XlibTouchpad::loadSupportedProperties(const Parameter* props)
 {
     m_paramList = props;
     for (const Parameter *param = props; param->name; param++) {
-        QLatin1String name(param->prop_name);
-
-        if (!m_atoms.contains(name)) {
-            m_atoms.insert(name, QSharedPointer<XcbAtom>(
-                            new XcbAtom(m_connection, param->prop_name)));
-        }
+        addProperty(param->prop_name);
     }
 
+    fetchProperties();
+
     for (const Parameter *p = props; p->name; p++) {
         if (getParameter(p).isValid()) {
             m_supported.append(p->name);
@@ -177,24 +245,24 @@ double XlibTouchpad::getPropertyScale(const QString& name) const
 
 PropertyInfo* XlibTouchpad::getDevProperty(const QLatin1String& propName)
 {
-    if (m_props.contains(propName)) {
-        return &m_props[propName];
-    }
+    if (!m_props.contains(propName)) {
+        if (!m_atoms.contains(propName) || !m_atoms[propName]) {
+            return 0;
+        }
 
-    if (!m_atoms.contains(propName) || !m_atoms[propName]) {
-        return 0;
-    }
+        xcb_atom_t prop = m_atoms[propName]->atom();
+        if (!prop) {
+            return 0;
+        }
 
-    xcb_atom_t prop = m_atoms[propName]->atom();
-    if (!prop) {
-        return 0;
+        m_props.insert(propName, PropertyInfo(m_display, m_deviceId, prop, m_floatType.atom()));
     }
 
-    PropertyInfo p(m_display, m_deviceId, prop, m_floatType.atom());
-    if (!p.b && !p.f && !p.i) {
+    PropertyInfo *p = &m_props[propName];
+    if (!p->b && !p->f && !p->i) {
         return 0;
     }
-    return &m_props.insert(propName, p).value();
+    return p;
 }
 
 bool XlibTouchpad::setParameter(const Parameter *par, const QVariant &value)
@@ -236,10 +304,15 @@ bool XlibTouchpad::setParameter(const Parameter *par, const QVariant &value)
 
 void XlibTouchpad::setEnabled(bool enable)
 {
-    PropertyInfo enabled(m_display, m_deviceId, m_enabledAtom.atom(), 0);
-    if (enabled.b && *(enabled.b) != enable) {
-        *(enabled.b) = enable;
-        enabled.set();
+    const QLatin1String name(XI_PROP_ENABLED);
+    if (!m_watched) {
+        m_props.remove(name);
+    }
+
+    PropertyInfo *enabled = getDevProperty(name);
+    if (enabled && enabled->b && *(enabled->b) != enable) {
+        *(enabled->b) = enable;
+        m_changed.insert(name);
     }
 
     flush();
@@ -247,17 +320,26 @@ void XlibTouchpad::setEnabled(bool enable)
 
 bool XlibTouchpad::enabled()
 {
-    PropertyInfo enabled(m_display, m_deviceId, m_enabledAtom.atom(), 0);
-    return enabled.value(0).toBool();
+    const QLatin1String name(XI_PROP_ENABLED);
+    if (!m_watched) {
+        m_props.remove(name);
+    }
+
+    PropertyInfo *enabled = getDevProperty(name);
+    return enabled && enabled->value(0).toBool();
 }
 
 
 void XlibTouchpad::setTouchpadOff(int touchpadOff)
 {
-    PropertyInfo off(m_display, m_deviceId, m_touchpadOffAtom.atom(), 0);
-    if (off.b && *(off.b) != touchpadOff) {
-        *(off.b) = touchpadOff;
-        off.set();
+    if (!m_watched) {
+        m_props.remove(m_touchpadOffName);
+    }
+
+    PropertyInfo *off = getDevProperty(m_touchpadOffName);
+    if (off && off->b && *(off->b) != touchpadOff) {
+        *(off->b) = touchpadOff;
+        m_changed.insert(m_touchpadOffName);
     }
 
     flush();
@@ -265,8 +347,12 @@ void XlibTouchpad::setTouchpadOff(int touchpadOff)
 
 int XlibTouchpad::touchpadOff()
 {
-    PropertyInfo off(m_display, m_deviceId, m_touchpadOffAtom.atom(), 0);
-    return  off.value(0).toInt();
+    if (!m_watched) {
+        m_props.remove(m_touchpadOffName);
+    }
+
+    PropertyInfo *off = getDevProperty(m_touchpadOffName);
+    return off ? off->value(0).toInt() : 0;
 }
 
 XcbAtom& XlibTouchpad::touchpadOffAtom()
@@ -59,7 +59,18 @@ public:
 
     XcbAtom &touchpadOffAtom();
 
+    /*
+     * Whether property events of this device are being delivered.
+     * Only then the cached property values can be trusted, otherwise
+     * every read goes back to the server.
+     */
+    void setWatched(bool watched) { m_watched = watched; }
+    void propertyChanged(xcb_atom_t prop);
+
 protected:
+    void addProperty(const char *name);
+    void setTouchpadOffProperty(const char *name);
+    void fetchProperties();
     void loadSupportedProperties(const Parameter *props);
     bool setParameter(const struct Parameter *, const QVariant &);
     QVariant getParameter(const struct Parameter *);
@@ -77,10 +88,14 @@ protected:
     QMap<QLatin1String, QSharedPointer<XcbAtom> > m_atoms;
 
     QMap<QString, QString> m_negate;
+    // Values of the properties in m_atoms, including ones the device does
+    // not have, so those are not asked for again
     QMap<QLatin1String, struct PropertyInfo> m_props;
     QSet<QLatin1String> m_changed;
     QStringList m_supported;
     const struct Parameter *m_paramList;
+    QLatin1String m_touchpadOffName;
+    bool m_watched;
 };
 
 #endif
@@ -19,7 +19,6 @@
 #include "xrecordkeyboardmonitor.h"
 
 #include <cstdlib>
-#include <limits>
 
 #include <QScopedPointer>
 
@@ -27,8 +26,7 @@
 #include <X11/Xlib.h>
 
 XRecordKeyboardMonitor::XRecordKeyboardMonitor(Display *display)
-    : m_connection(xcb_connect(XDisplayString(display), 0)),
-      m_modifiersPressed(0), m_keysPressed(0)
+    : m_connection(xcb_connect(XDisplayString(display), 0))
 {
     if (!m_connection) {
         return;
@@ -54,17 +52,17 @@ XRecordKeyboardMonitor::XRecordKeyboardMonitor(Display *display)
 
     int nModifiers = xcb_get_modifier_mapping_keycodes_length(modmap.data());
     xcb_keycode_t *modifiers = xcb_get_modifier_mapping_keycodes(modmap.data());
-    m_modifier.fill(false, std::numeric_limits<xcb_keycode_t>::max() + 1);
+    QVector<quint32> modifierKeys, ignoredKeys;
     for (xcb_keycode_t *i = modifiers; i < modifiers + nModifiers; i++) {
-        m_modifier[*i] = true;
+        modifierKeys << *i;
     }
-    m_ignore.fill(false, std::numeric_limits<xcb_keycode_t>::max() + 1);
+    // The first row of the modifier map is Shift
     for (xcb_keycode_t *i = modifiers;
          i < modifiers + modmap->keycodes_per_modifier; i++)
     {
-        m_ignore[*i] = true;
+        ignoredKeys << *i;
     }
-    m_pressed.fill(false, std::numeric_limits<xcb_keycode_t>::max() + 1);
+    setModifierKeys(modifierKeys, ignoredKeys);
 
     m_cookie = xcb_record_enable_context(m_connection, m_context);
     xcb_flush(m_connection);
@@ -119,13 +117,13 @@ void XRecordKeyboardMonitor::processNextReply()
 
 void XRecordKeyboardMonitor::process(xcb_record_enable_context_reply_t *reply)
 {
-    bool prevActivity = activity();
-
     xcb_key_press_event_t *events = reinterpret_cast<xcb_key_press_event_t*>
             (xcb_record_enable_context_data(reply));
     int nEvents = xcb_record_enable_context_data_length(reply) /
             sizeof(xcb_key_press_event_t);
-    bool wasActivity = prevActivity;
+
+    QVector<KeyEvent> keyEvents;
+    keyEvents.reserve(nEvents);
     for (xcb_key_press_event_t *e = events; e < events + nEvents; e++) {
         if (e->response_type != XCB_KEY_PRESS &&
                 e->response_type != XCB_KEY_RELEASE)
@@ -133,30 +131,8 @@ void XRecordKeyboardMonitor::process(xcb_record_enable_context_reply_t *reply)
             continue;
         }
 
-        if (m_ignore[e->detail]) {
-            continue;
-        }
-
-        bool pressed = (e->response_type == XCB_KEY_PRESS);
-        if (m_pressed[e->detail] == pressed) {
-            continue;
-        }
-        m_pressed[e->detail] = pressed;
-
-        int &counter = m_modifier[e->detail] ? m_modifiersPressed :
-                                               m_keysPressed;
-        if (pressed) {
-            counter++;
-        } else {
-            counter--;
-        }
-
-        wasActivity = wasActivity || activity();
+        keyEvents.append({ e->detail, e->response_type == XCB_KEY_PRESS });
     }
 
-    if (!prevActivity && activity()) {
-        Q_EMIT keyboardActivityStarted();
-    } else if (!activity() && wasActivity) {
-        Q_EMIT keyboardActivityFinished();
-    }
+    processKeyEvents(keyEvents.constData(), keyEvents.size());
 }
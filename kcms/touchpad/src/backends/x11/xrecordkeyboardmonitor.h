@@ -26,7 +26,9 @@
 #include <xcb/xcb.h>
 #include <xcb/record.h>
 
-class XRecordKeyboardMonitor : public QObject
+#include "keyboardactivitysource.h"
+
+class XRecordKeyboardMonitor : public KeyboardActivitySource
 {
     Q_OBJECT
 
@@ -34,24 +36,16 @@ public:
     XRecordKeyboardMonitor(Display *display);
     ~XRecordKeyboardMonitor();
 
-Q_SIGNALS:
-    void keyboardActivityStarted();
-    void keyboardActivityFinished();
-
 private Q_SLOTS:
     void processNextReply();
 
 private:
     void process(xcb_record_enable_context_reply_t *reply);
-    bool activity() const { return m_keysPressed && !m_modifiersPressed; }
 
     QSocketNotifier *m_notifier;
     xcb_connection_t *m_connection;
     xcb_record_context_t m_context;
     xcb_record_enable_context_cookie_t m_cookie;
-
-    QVector<bool> m_modifier, m_ignore, m_pressed;
-    int m_modifiersPressed, m_keysPressed;
 };
 
 #endif // XRECORDKEYBOARDMONITOR_H
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "keyboardactivitysource.h"
+
+KeyboardActivitySource::KeyboardActivitySource(QObject *parent)
+    : QObject(parent), m_modifiersPressed(0), m_keysPressed(0)
+{
+}
+
+KeyboardActivitySource::~KeyboardActivitySource()
+{
+}
+
+void KeyboardActivitySource::ensureKey(quint32 key)
+{
+    if (key < static_cast<quint32>(m_pressed.size())) {
+        return;
+    }
+
+    const int size = key + 1;
+    m_modifier.resize(size);
+    m_ignore.resize(size);
+    m_pressed.resize(size);
+}
+
+void KeyboardActivitySource::setModifierKeys(const QVector<quint32> &modifiers,
+                                             const QVector<quint32> &ignored)
+{
+    m_modifier.fill(false);
+    m_ignore.fill(false);
+
+    for (quint32 key : modifiers) {
+        ensureKey(key);
+        m_modifier[key] = true;
+    }
+    for (quint32 key : ignored) {
+        ensureKey(key);
+        m_ignore[key] = true;
+    }
+}
+
+void KeyboardActivitySource::processKeyEvents(const KeyEvent *events, int count)
+{
+    bool prevActivity = activity();
+    bool wasActivity = prevActivity;
+
+    for (const KeyEvent *e = events; e < events + count; e++) {
+        ensureKey(e->key);
+
+        if (m_ignore[e->key]) {
+            continue;
+        }
+
+        if (m_pressed[e->key] == e->pressed) {
+            continue;
+        }
+        m_pressed[e->key] = e->pressed;
+
+        int &counter = m_modifier[e->key] ? m_modifiersPressed :
+                                            m_keysPressed;
+        if (e->pressed) {
+            counter++;
+        } else {
+            counter--;
+        }
+
+        wasActivity = wasActivity || activity();
+    }
+
+    if (!prevActivity && activity()) {
+        Q_EMIT keyboardActivityStarted();
+    } else if (!activity() && wasActivity) {
+        if (!prevActivity) {
+            // Whole keystroke within one batch
+            Q_EMIT keyboardActivityStarted();
+        }
+        Q_EMIT keyboardActivityFinished();
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KEYBOARDACTIVITYSOURCE_H
+#define KEYBOARDACTIVITYSOURCE_H
+
+#include <QObject>
+#include <QVector>
+
+/*
+ * Tells when the user starts and stops typing.
+ *
+ * Implementations only feed in raw key presses and releases. Presses of
+ * ignored keys (Shift) don't count at all, and while a modifier is held
+ * the user is entering shortcuts rather than typing.
+ */
+class KeyboardActivitySource : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct KeyEvent {
+        quint32 key;
+        bool pressed;
+    };
+
+    ~KeyboardActivitySource();
+
+Q_SIGNALS:
+    void keyboardActivityStarted();
+    void keyboardActivityFinished();
+
+protected:
+    explicit KeyboardActivitySource(QObject *parent = nullptr);
+
+    void setModifierKeys(const QVector<quint32> &modifiers,
+                         const QVector<quint32> &ignored);
+
+    /*
+     * Events that arrived together are processed as one batch: typing a
+     * key and releasing it within the same batch still gives both signals.
+     */
+    void processKeyEvents(const KeyEvent *events, int count);
+
+private:
+    bool activity() const { return m_keysPressed && !m_modifiersPressed; }
+    void ensureKey(quint32 key);
+
+    QVector<bool> m_modifier, m_ignore, m_pressed;
+    int m_modifiersPressed, m_keysPressed;
+};
+
+#endif // KEYBOARDACTIVITYSOURCE_H
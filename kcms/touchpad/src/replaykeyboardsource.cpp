@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "replaykeyboardsource.h"
+
+ReplayKeyboardSource::ReplayKeyboardSource(QObject *parent)
+    : KeyboardActivitySource(parent), m_next(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, SIGNAL(timeout()), SLOT(deliverDue()));
+}
+
+void ReplayKeyboardSource::setModifiers(const QVector<quint32> &modifiers,
+                                        const QVector<quint32> &ignored)
+{
+    setModifierKeys(modifiers, ignored);
+}
+
+void ReplayKeyboardSource::feed(quint32 key, bool pressed)
+{
+    const KeyEvent event = { key, pressed };
+    processKeyEvents(&event, 1);
+}
+
+void ReplayKeyboardSource::replay(const QVector<TimedKeyEvent> &events)
+{
+    m_events = events;
+    m_next = 0;
+    m_clock.start();
+    deliverDue();
+}
+
+void ReplayKeyboardSource::deliverDue()
+{
+    const qint64 now = m_clock.elapsed();
+
+    // Everything that is due goes out as one batch, like a real
+    // source reading whatever piled up since it last woke up
+    QVector<KeyEvent> batch;
+    while (m_next < m_events.size() && m_events.at(m_next).msec <= now) {
+        const TimedKeyEvent &e = m_events.at(m_next++);
+        batch.append({ e.key, e.pressed });
+    }
+
+    if (!batch.isEmpty()) {
+        processKeyEvents(batch.constData(), batch.size());
+    }
+
+    if (m_next < m_events.size()) {
+        m_timer.start(qMax<qint64>(0, m_events.at(m_next).msec - now));
+    } else {
+        Q_EMIT replayFinished();
+    }
+}
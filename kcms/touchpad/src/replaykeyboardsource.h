@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2017 The KDE Project
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef REPLAYKEYBOARDSOURCE_H
+#define REPLAYKEYBOARDSOURCE_H
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include "keyboardactivitysource.h"
+
+/*
+ * Plays back recorded key events, for tests and benchmarks.
+ */
+class ReplayKeyboardSource : public KeyboardActivitySource
+{
+    Q_OBJECT
+
+public:
+    struct TimedKeyEvent {
+        int msec; // since the start of the recording
+        quint32 key;
+        bool pressed;
+    };
+
+    explicit ReplayKeyboardSource(QObject *parent = nullptr);
+
+    void setModifiers(const QVector<quint32> &modifiers,
+                      const QVector<quint32> &ignored);
+
+    // Delivers a single event right away
+    void feed(quint32 key, bool pressed);
+
+    // Delivers the events at the times they were recorded at
+    void replay(const QVector<TimedKeyEvent> &events);
+
+Q_SIGNALS:
+    void replayFinished();
+
+private Q_SLOTS:
+    void deliverDue();
+
+private:
+    QVector<TimedKeyEvent> m_events;
+    int m_next;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+#endif // REPLAYKEYBOARDSOURCE_H
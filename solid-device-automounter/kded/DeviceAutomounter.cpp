@@ -26,26 +26,58 @@
 #include <Solid/StorageAccess>
 #include <Solid/StorageVolume>
 
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QStandardPaths>
 #include <QTimer>
 
+Q_LOGGING_CATEGORY(DEVICE_AUTOMOUNTER, "device_automounter")
+
+// Settings changes are written out at most this often
+static const int SAVE_DELAY = 1000;
+
+// How many devices are being mounted at the same time
+static const int MAX_RUNNING_MOUNTS = 4;
+
+// A mount that has not reported back after this long gives up its slot,
+// and how often that is checked
+static const int MOUNT_TIMEOUT = 120000;
+static const int MOUNT_TIMEOUT_CHECK_INTERVAL = 10000;
+
 K_PLUGIN_FACTORY_WITH_JSON(DeviceAutomounterFactory,
                            "device_automounter.json",
                            registerPlugin<DeviceAutomounter>();)
 
 DeviceAutomounter::DeviceAutomounter(QObject *parent, const QVariantList &args)
     : KDEDModule(parent)
+    , m_saveTimer(new QTimer(this))
+    , m_mountTimeoutTimer(new QTimer(this))
 {
     Q_UNUSED(args);
+
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_DELAY);
+    connect(m_saveTimer, &QTimer::timeout, this, &DeviceAutomounter::saveSettings);
+
+    m_mountTimeoutTimer->setInterval(MOUNT_TIMEOUT_CHECK_INTERVAL);
+    connect(m_mountTimeoutTimer, &QTimer::timeout, this, &DeviceAutomounter::expireMounts);
+
     QTimer::singleShot(0, this, &DeviceAutomounter::init);
 }
 
 DeviceAutomounter::~DeviceAutomounter()
 {
+    if (m_saveTimer->isActive()) {
+        saveSettings();
+    }
 }
 
 void DeviceAutomounter::init()
 {
+    m_settingsLastModified = settingsLastModified();
+
     connect(Solid::DeviceNotifier::instance(), &Solid::DeviceNotifier::deviceAdded, this, &DeviceAutomounter::deviceAdded);
+    connect(Solid::DeviceNotifier::instance(), &Solid::DeviceNotifier::deviceRemoved, this, &DeviceAutomounter::deviceRemoved);
     QList<Solid::Device> volumes = Solid::Device::listFromType(Solid::DeviceInterface::StorageVolume);
     foreach(Solid::Device volume, volumes) {
         // sa can be 0 (e.g. for the swap partition)
@@ -54,13 +86,131 @@ void DeviceAutomounter::init()
         }
         automountDevice(volume, AutomounterSettings::Login);
     }
-    AutomounterSettings::self()->save();
+    scheduleSave();
 }
 
 void DeviceAutomounter::deviceMountChanged(bool accessible, const QString &udi)
 {
     AutomounterSettings::setDeviceLastSeenMounted(udi, accessible);
+    scheduleSave();
+}
+
+QDateTime DeviceAutomounter::settingsLastModified() const
+{
+    const QString path = QStandardPaths::locate(QStandardPaths::GenericConfigLocation,
+                                                AutomounterSettings::self()->config()->name());
+    return path.isEmpty() ? QDateTime() : QFileInfo(path).lastModified();
+}
+
+void DeviceAutomounter::scheduleSave()
+{
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+void DeviceAutomounter::saveSettings()
+{
+    m_saveTimer->stop();
     AutomounterSettings::self()->save();
+    m_settingsLastModified = settingsLastModified();
+}
+
+void DeviceAutomounter::reloadSettingsIfChanged()
+{
+    // The KCM writes the same file, everything else we
+    // already have in memory
+    const QDateTime lastModified = settingsLastModified();
+    if (lastModified == m_settingsLastModified) {
+        return;
+    }
+
+    if (m_saveTimer->isActive()) {
+        saveSettings();
+    }
+    AutomounterSettings::self()->load();
+    m_settingsLastModified = settingsLastModified();
+}
+
+void DeviceAutomounter::enqueueMount(const QString &udi)
+{
+    if (m_pendingMounts.contains(udi) || m_runningMounts.contains(udi)) {
+        return;
+    }
+
+    m_pendingMounts << udi;
+    startPendingMounts();
+}
+
+void DeviceAutomounter::startPendingMounts()
+{
+    while (m_runningMounts.count() < MAX_RUNNING_MOUNTS && !m_pendingMounts.isEmpty()) {
+        const QString udi = m_pendingMounts.takeFirst();
+
+        Solid::Device dev(udi);
+        Solid::StorageAccess *sa = dev.as<Solid::StorageAccess>();
+        if (!sa) {
+            continue;
+        }
+
+        connect(sa, &Solid::StorageAccess::setupDone, this, &DeviceAutomounter::deviceSetupDone, Qt::UniqueConnection);
+
+        m_runningMounts[udi].start();
+        if (!sa->setup()) {
+            qCWarning(DEVICE_AUTOMOUNTER) << "Could not start mounting" << udi;
+            m_runningMounts.remove(udi);
+        }
+    }
+
+    if (m_runningMounts.isEmpty()) {
+        m_mountTimeoutTimer->stop();
+    } else if (!m_mountTimeoutTimer->isActive()) {
+        m_mountTimeoutTimer->start();
+    }
+}
+
+void DeviceAutomounter::expireMounts()
+{
+    bool expired = false;
+    for (auto it = m_runningMounts.begin(); it != m_runningMounts.end(); ) {
+        if (it->hasExpired(MOUNT_TIMEOUT)) {
+            qCWarning(DEVICE_AUTOMOUNTER) << "Mounting" << it.key() << "did not finish within" << MOUNT_TIMEOUT << "ms, giving up on it";
+            it = m_runningMounts.erase(it);
+            expired = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (expired) {
+        startPendingMounts();
+    }
+}
+
+void DeviceAutomounter::deviceRemoved(const QString &udi)
+{
+    m_pendingMounts.removeAll(udi);
+    if (m_runningMounts.remove(udi)) {
+        startPendingMounts();
+    }
+}
+
+void DeviceAutomounter::deviceSetupDone(Solid::ErrorType error, const QVariant &errorData, const QString &udi)
+{
+    auto it = m_runningMounts.find(udi);
+    if (it == m_runningMounts.end()) {
+        // mounted by someone else
+        return;
+    }
+
+    if (error == Solid::NoError) {
+        qCDebug(DEVICE_AUTOMOUNTER) << "Mounted" << udi << "in" << it->elapsed() << "ms";
+    } else {
+        qCWarning(DEVICE_AUTOMOUNTER) << "Mounting" << udi << "failed after" << it->elapsed() << "ms:" << errorData;
+    }
+
+    m_runningMounts.erase(it);
+    startPendingMounts();
 }
 
 void DeviceAutomounter::automountDevice(Solid::Device &dev, AutomounterSettings::AutomountType type)
@@ -77,7 +227,7 @@ void DeviceAutomounter::automountDevice(Solid::Device &dev, AutomounterSettings:
         if (AutomounterSettings::shouldAutomountDevice(dev.udi(), type)) {
             Solid::StorageVolume *sv = dev.as<Solid::StorageVolume>();
             if (!sv->isIgnored()) {
-                sa->setup();
+                enqueueMount(dev.udi());
             }
         }
     }
@@ -85,11 +235,11 @@ void DeviceAutomounter::automountDevice(Solid::Device &dev, AutomounterSettings:
 
 void DeviceAutomounter::deviceAdded(const QString &udi)
 {
-    AutomounterSettings::self()->load();
+    reloadSettingsIfChanged();
 
     Solid::Device dev(udi);
     automountDevice(dev, AutomounterSettings::Attach);
-    AutomounterSettings::self()->save();
+    scheduleSave();
 
     if (dev.is<Solid::StorageAccess>()) {
         Solid::StorageAccess *sa = dev.as<Solid::StorageAccess>();
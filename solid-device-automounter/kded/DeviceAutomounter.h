@@ -21,8 +21,16 @@
 
 #include <kdedmodule.h>
 #include <Solid/Device>
+#include <Solid/SolidNamespace>
 #include "AutomounterSettings.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+
+class QTimer;
+
 class DeviceAutomounter : public KDEDModule
 {
     Q_OBJECT
@@ -33,11 +41,27 @@ public:
 private slots:
     void init();
     void deviceAdded(const QString &udi);
+    void deviceRemoved(const QString &udi);
     void deviceMountChanged(bool accessible, const QString &udi);
+    void deviceSetupDone(Solid::ErrorType error, const QVariant &errorData, const QString &udi);
+    void saveSettings();
 
 private:
     void automountDevice(Solid::Device &dev, AutomounterSettings::AutomountType type);
+    void scheduleSave();
+    void reloadSettingsIfChanged();
+    QDateTime settingsLastModified() const;
+    void enqueueMount(const QString &udi);
+    void startPendingMounts();
+    void expireMounts();
+
+    QTimer *m_saveTimer;
+    QTimer *m_mountTimeoutTimer;
+    QDateTime m_settingsLastModified;
 
+    // Devices waiting for a mount slot, and the ones being mounted
+    QStringList m_pendingMounts;
+    QHash<QString, QElapsedTimer> m_runningMounts;
 };
 
 #endif